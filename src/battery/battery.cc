@@ -53,6 +53,7 @@
 
 #if defined(__linux__)
 #include "battery/linux_sysfs.hh"
+#include "battery/linux_uevent.hh"
 #endif  // defined(__linux__)
 
 #if defined(__FreeBSD__)
@@ -66,6 +67,12 @@ BatteryState battery_state;
 bool battery_enabled;
 int percentage_hide;
 static Interval::Id battery_timeout;
+static Timer* battery_timer;
+static absl::Duration battery_interval;
+
+#if defined(__linux__)
+static std::unique_ptr<linux_uevent::Monitor> battery_uevents;
+#endif  // defined(__linux__)
 
 int8_t battery_low_status;
 bool battery_low_cmd_send;
@@ -115,6 +122,49 @@ bool UpdateBatteries() {
   return true;
 }
 
+// Batteries are sampled as often as their backend asks for. Without kernel
+// events to report status changes (like the AC adapter being plugged in) in
+// between, they're polled at least every 10 seconds.
+absl::Duration PollingInterval() {
+  static constexpr absl::Duration kMaximumPollingInterval = absl::Seconds(10);
+
+  absl::Duration interval = kMaximumPollingInterval;
+  if (battery_ptr) {
+    interval = battery_ptr->sampling_interval();
+  }
+#if defined(__linux__)
+  if (battery_uevents && battery_uevents->IsAlive()) {
+    return interval;
+  }
+#endif  // defined(__linux__)
+  return std::min(interval, kMaximumPollingInterval);
+}
+
+// The charge changes slowly: a reading a quarter of the polling interval late
+// is as good as one on time.
+absl::Duration PollingSlack(absl::Duration interval) { return interval / 4; }
+
+bool OnBatteryTimeout();
+
+// Replaces the battery interval if the polling interval changed, returning
+// whether it did.
+bool ReschedulePolling() {
+  absl::Duration interval = PollingInterval();
+  if (interval == battery_interval) {
+    return false;
+  }
+  battery_interval = interval;
+  battery_timeout = battery_timer->SetInterval(interval, OnBatteryTimeout,
+                                               PollingSlack(interval));
+  return true;
+}
+
+bool OnBatteryTimeout() {
+  UpdateBatteries();
+  // Drop the interval that just expired if it was replaced.
+  return !ReschedulePolling();
+}
+
 }  // namespace
 
 void DefaultBattery() {
@@ -122,6 +172,8 @@ void DefaultBattery() {
   percentage_hide = 101;
   battery_low_cmd_send = false;
   battery_timeout.reset();
+  battery_timer = nullptr;
+  battery_interval = absl::ZeroDuration();
   bat1_font_desc = 0;
   bat2_font_desc = 0;
   battery_low_cmd.clear();
@@ -148,7 +200,9 @@ void CleanupBattery(Timer& timer) {
 
   if (battery_timeout) {
     timer.ClearInterval(battery_timeout);
+    battery_timeout.reset();
   }
+  battery_timer = nullptr;
 
 #if defined(__OpenBSD__) || defined(__NetBSD__)
   if ((apm_fd != -1) && (close(apm_fd) == -1)) {
@@ -157,6 +211,41 @@ void CleanupBattery(Timer& timer) {
 #endif
 
   battery_ptr.reset();
+
+#if defined(__linux__)
+  battery_uevents.reset();
+#endif  // defined(__linux__)
+}
+
+int BatteryEventFd() {
+#if defined(__linux__)
+  if (battery_uevents && battery_uevents->IsAlive()) {
+    return battery_uevents->fd();
+  }
+#endif  // defined(__linux__)
+  return -1;
+}
+
+void HandleBatteryEvents() {
+#if defined(__linux__)
+  if (!battery_uevents || !battery_ptr) {
+    return;
+  }
+
+  // Plugging or unplugging the AC adapter changes the battery status, so
+  // don't bother filtering on the device name.
+  bool changed = false;
+  battery_uevents->ProcessEvents(
+      [&changed](linux_uevent::Uevent const&) { changed = true; });
+  if (changed) {
+    UpdateBatteries();
+
+    Interval::Id previous_timeout = battery_timeout;
+    if (battery_timer && ReschedulePolling()) {
+      battery_timer->ClearInterval(previous_timeout);
+    }
+  }
+#endif  // defined(__linux__)
 }
 
 void InitBattery() {
@@ -191,13 +280,14 @@ void InitBattery() {
     return;
   }
 
-  // FIXME: this should handle all the batteries present
-  battery_ptr.reset(new linux_sysfs::Battery(battery_dirs.front()));
+  battery_ptr.reset(new linux_sysfs::Batteries(battery_dirs));
 
   if (!battery_ptr->Found()) {
     util::log::Error() << "Can't initialize battery status.\n";
     return;
   }
+
+  battery_uevents.reset(new linux_uevent::Monitor("power_supply"));
 #endif
 }
 
@@ -214,8 +304,11 @@ void Battery::InitPanel(Panel* panel, Timer* timer) {
   battery->need_resize_ = true;
 
   if (!battery_timeout) {
-    battery_timeout = timer->SetInterval(absl::Seconds(10), UpdateBatteries);
+    battery_timer = timer;
     UpdateBatteries();
+    battery_interval = PollingInterval();
+    battery_timeout = timer->SetInterval(battery_interval, OnBatteryTimeout,
+                                         PollingSlack(battery_interval));
   }
 }
 
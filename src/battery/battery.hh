@@ -61,4 +61,11 @@ void UpdateBattery();
 
 void InitBattery();
 
+// Returns a file descriptor which becomes readable when the battery state
+// changes, or -1 if the platform doesn't report such changes (in which case
+// batteries are polled). HandleBatteryEvents() is then meant to be called by
+// the event loop.
+int BatteryEventFd();
+void HandleBatteryEvents();
+
 #endif  // TINT3_BATTERY_BATTERY_HH
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+
+#include "battery/battery_aggregator.hh"
+
+namespace {
+
+constexpr absl::Duration kMinimumInterval = absl::Seconds(5);
+constexpr absl::Duration kMaximumInterval = absl::Minutes(1);
+constexpr absl::Duration kIdleInterval = absl::Minutes(5);
+
+// Charging wins over discharging (the batteries are then being charged as a
+// whole), and a full battery next to one which isn't charging for whatever
+// reason means the system is just sitting on AC.
+ChargeState CombineStates(std::vector<BatteryReading> const& readings) {
+  bool discharging = false;
+  bool full = false;
+  for (auto const& reading : readings) {
+    switch (reading.state) {
+      case ChargeState::kCharging:
+        return ChargeState::kCharging;
+      case ChargeState::kDischarging:
+        discharging = true;
+        break;
+      case ChargeState::kFull:
+        full = true;
+        break;
+      case ChargeState::kUnknown:
+        break;
+    }
+  }
+  if (discharging) {
+    return ChargeState::kDischarging;
+  }
+  if (full) {
+    return ChargeState::kFull;
+  }
+  return ChargeState::kUnknown;
+}
+
+}  // namespace
+
+BatteryAggregator::BatteryAggregator(absl::Duration time_constant)
+    : time_constant_(time_constant),
+      charge_state_(ChargeState::kUnknown),
+      energy_now_(0.0),
+      energy_full_(0.0),
+      smoothed_rate_(0.0),
+      battery_count_(0),
+      last_update_(absl::InfinitePast()) {}
+
+void BatteryAggregator::Update(std::vector<BatteryReading> const& readings,
+                               absl::Time now) {
+  ChargeState charge_state = CombineStates(readings);
+
+  energy_now_ = 0.0;
+  energy_full_ = 0.0;
+  double rate = 0.0;
+  for (auto const& reading : readings) {
+    energy_now_ += reading.energy_now;
+    energy_full_ += reading.energy_full;
+    // Only the batteries doing what the whole is doing count, e.g. on
+    // systems which drain one battery after the other.
+    if (reading.state == charge_state) {
+      rate += reading.rate;
+    }
+  }
+
+  // The previous rate means nothing once the batteries are doing something
+  // else (or are different batteries altogether).
+  bool restart = (charge_state != charge_state_ ||
+                  readings.size() != battery_count_ || smoothed_rate_ <= 0.0 ||
+                  now <= last_update_);
+  if (restart) {
+    smoothed_rate_ = rate;
+  } else {
+    // Readings are irregularly spaced, so weigh them by the time elapsed
+    // since the previous one.
+    double alpha =
+        1.0 - std::exp(-absl::FDivDuration(now - last_update_, time_constant_));
+    smoothed_rate_ += alpha * (rate - smoothed_rate_);
+  }
+
+  charge_state_ = charge_state;
+  battery_count_ = readings.size();
+  last_update_ = now;
+}
+
+double BatteryAggregator::charge_percentage() const {
+  if (energy_full_ <= 0.0) {
+    return 0.0;
+  }
+  return std::min(100.0, (energy_now_ * 100.0) / energy_full_);
+}
+
+ChargeState BatteryAggregator::charge_state() const { return charge_state_; }
+
+unsigned int BatteryAggregator::seconds_to_charge() const {
+  if (smoothed_rate_ <= 0.0) {
+    return 0;
+  }
+
+  switch (charge_state_) {
+    case ChargeState::kCharging:
+      return 3600.0 * std::max(0.0, energy_full_ - energy_now_) /
+             smoothed_rate_;
+
+    case ChargeState::kDischarging:
+      return 3600.0 * energy_now_ / smoothed_rate_;
+
+    default:
+      return 0;
+  }
+}
+
+double BatteryAggregator::smoothed_rate() const { return smoothed_rate_; }
+
+absl::Duration BatteryAggregator::sampling_interval() const {
+  if ((charge_state_ != ChargeState::kCharging &&
+       charge_state_ != ChargeState::kDischarging) ||
+      smoothed_rate_ <= 0.0 || energy_full_ <= 0.0) {
+    return kIdleInterval;
+  }
+
+  absl::Duration per_percent =
+      absl::Hours(energy_full_ / 100.0 / smoothed_rate_);
+  return std::max(kMinimumInterval,
+                  std::min(kMaximumInterval, per_percent / 2));
+}
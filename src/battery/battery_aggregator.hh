@@ -0,0 +1,46 @@
+#ifndef TINT3_BATTERY_BATTERY_AGGREGATOR_HH
+#define TINT3_BATTERY_BATTERY_AGGREGATOR_HH
+
+#include <vector>
+
+#include "absl/time/time.h"
+
+#include "battery/battery_interface.hh"
+
+// Combines the readings of all the batteries of a system into a single one,
+// as if they were a single battery holding all of their energy.
+//
+// The time to charge (or to empty) is derived from the charge rate, which is
+// smoothed with an exponential moving average, since the instantaneous rate
+// follows the system load and makes for a jumpy estimate.
+class BatteryAggregator {
+ public:
+  // Readings older than the time constant only weigh for about a third (1/e)
+  // in the smoothed rate.
+  explicit BatteryAggregator(
+      absl::Duration time_constant = absl::Minutes(2));
+
+  // Adds readings of all the batteries, all taken at the given time.
+  void Update(std::vector<BatteryReading> const& readings, absl::Time now);
+
+  double charge_percentage() const;
+  ChargeState charge_state() const;
+  unsigned int seconds_to_charge() const;
+  double smoothed_rate() const;
+
+  // Readings are taken about twice per percent of charge change, within
+  // bounds, and rarely when the batteries are neither charging nor
+  // discharging.
+  absl::Duration sampling_interval() const;
+
+ private:
+  absl::Duration time_constant_;
+  ChargeState charge_state_;
+  double energy_now_;
+  double energy_full_;
+  double smoothed_rate_;
+  size_t battery_count_;
+  absl::Time last_update_;
+};
+
+#endif  // TINT3_BATTERY_BATTERY_AGGREGATOR_HH
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "absl/time/time.h"
+
+#include "battery/battery_aggregator.hh"
+
+namespace {
+
+BatteryReading Reading(ChargeState state, double energy_now,
+                       double energy_full, double rate) {
+  return BatteryReading{state, energy_now, energy_full, rate};
+}
+
+}  // namespace
+
+TEST_CASE("BatteryAggregator") {
+  absl::Time now = absl::FromUnixSeconds(1000000);
+  BatteryAggregator aggregator{absl::Minutes(2)};
+
+  SECTION("batteries are combined") {
+    // One battery is drained after the other, as on dual-battery laptops.
+    aggregator.Update(
+        {Reading(ChargeState::kDischarging, 10000000, 20000000, 10000000),
+         Reading(ChargeState::kUnknown, 30000000, 60000000, 0)},
+        now);
+    REQUIRE(aggregator.charge_state() == ChargeState::kDischarging);
+    REQUIRE(aggregator.charge_percentage() == Approx(50.0));
+    // 40 Wh left at 10 W.
+    REQUIRE(aggregator.seconds_to_charge() == 4 * 3600);
+
+    aggregator.Update(
+        {Reading(ChargeState::kCharging, 10000000, 20000000, 5000000),
+         Reading(ChargeState::kFull, 60000000, 60000000, 0)},
+        now);
+    REQUIRE(aggregator.charge_state() == ChargeState::kCharging);
+    REQUIRE(aggregator.charge_percentage() == Approx(87.5));
+    // 10 Wh to go at 5 W.
+    REQUIRE(aggregator.seconds_to_charge() == 2 * 3600);
+
+    aggregator.Update(
+        {Reading(ChargeState::kFull, 20000000, 20000000, 0),
+         Reading(ChargeState::kUnknown, 60000000, 60000000, 0)},
+        now);
+    REQUIRE(aggregator.charge_state() == ChargeState::kFull);
+    REQUIRE(aggregator.charge_percentage() == Approx(100.0));
+    REQUIRE(aggregator.seconds_to_charge() == 0);
+
+    aggregator.Update({}, now);
+    REQUIRE(aggregator.charge_state() == ChargeState::kUnknown);
+    REQUIRE(aggregator.charge_percentage() == Approx(0.0));
+  }
+
+  SECTION("the rate is smoothed") {
+    aggregator.Update(
+        {Reading(ChargeState::kDischarging, 40000000, 80000000, 10000000)},
+        now);
+    REQUIRE(aggregator.smoothed_rate() == Approx(10000000));
+
+    // A short spike barely moves the estimate...
+    aggregator.Update(
+        {Reading(ChargeState::kDischarging, 40000000, 80000000, 40000000)},
+        now + absl::Seconds(5));
+    REQUIRE(aggregator.smoothed_rate() > 10000000);
+    REQUIRE(aggregator.smoothed_rate() < 12000000);
+
+    // ...but a sustained change takes over.
+    absl::Time then = now + absl::Seconds(5);
+    for (int i = 0; i < 60; ++i) {
+      then += absl::Seconds(10);
+      aggregator.Update(
+          {Reading(ChargeState::kDischarging, 40000000, 80000000, 20000000)},
+          then);
+    }
+    REQUIRE(aggregator.smoothed_rate() == Approx(20000000).epsilon(0.01));
+    REQUIRE(aggregator.seconds_to_charge() == Approx(2 * 3600).epsilon(0.01));
+
+    // Other states start over.
+    aggregator.Update(
+        {Reading(ChargeState::kCharging, 40000000, 80000000, 30000000)},
+        then + absl::Seconds(10));
+    REQUIRE(aggregator.smoothed_rate() == Approx(30000000));
+  }
+
+  SECTION("sampling adapts to the rate") {
+    // Neither charging nor discharging: nothing is going to change.
+    aggregator.Update({Reading(ChargeState::kFull, 50000000, 50000000, 0)},
+                      now);
+    absl::Duration idle = aggregator.sampling_interval();
+
+    // 1% of 50 Wh at 5 W is 6 minutes.
+    aggregator.Update(
+        {Reading(ChargeState::kDischarging, 40000000, 50000000, 5000000)},
+        now);
+    absl::Duration slow = aggregator.sampling_interval();
+
+    // 1% of 50 Wh at 60 W is 30 seconds.
+    aggregator.Update(
+        {Reading(ChargeState::kCharging, 40000000, 50000000, 60000000)},
+        now);
+    absl::Duration fast = aggregator.sampling_interval();
+
+    REQUIRE(idle > slow);
+    REQUIRE(slow > fast);
+    REQUIRE(fast == absl::Seconds(15));
+  }
+}
@@ -3,6 +3,8 @@
 
 #include <cstdint>
 
+#include "absl/time/time.h"
+
 enum class ChargeState { kUnknown, kCharging, kDischarging, kFull };
 
 struct BatteryTimestamp {
@@ -17,13 +19,31 @@ struct BatteryState {
   ChargeState state;
 };
 
+// Raw readings of a single battery, in whatever units the platform reports
+// (e.g. µWh and µW, or µAh and µA): only their ratios matter. The rate is how
+// fast energy_now changes, per hour.
+struct BatteryReading {
+  ChargeState state;
+  double energy_now;
+  double energy_full;
+  double rate;
+};
+
 class BatteryInterface {
  public:
+  virtual ~BatteryInterface() = default;
+
   virtual bool Found() const = 0;
   virtual bool Update() = 0;
   virtual double charge_percentage() const = 0;
   virtual ChargeState charge_state() const = 0;
   virtual unsigned int seconds_to_charge() const = 0;
+
+  // How long to wait before calling Update() again. Backends which know how
+  // fast the charge is changing can sample less often when it isn't.
+  virtual absl::Duration sampling_interval() const {
+    return absl::Seconds(10);
+  }
 };
 
 #endif  // TINT3_BATTERY_BATTERY_INTERFACE_HH
@@ -1,20 +1,86 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+
 #include "battery/linux_sysfs.hh"
-#include "util/common.hh"
 #include "util/fs.hh"
 
-namespace linux_sysfs {
+namespace {
+
+// Attributes are single values, well under a page (the most sysfs returns).
+constexpr size_t kAttributeBufferSize = 64;
+
+int OpenAttribute(std::string const& base_path, const char* name) {
+  std::string path = util::fs::BuildPath({base_path, name});
+  int fd;
+  do {
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  } while (fd == -1 && errno == EINTR);
+  return fd;
+}
+
+// Reads the attribute from its start into the given buffer, returning its
+// contents without the trailing newline.
+bool ReadAttribute(int fd, char (&buffer)[kAttributeBufferSize],
+                   absl::string_view* contents) {
+  if (fd == -1) {
+    return false;
+  }
+
+  ssize_t length;
+  do {
+    length = pread(fd, buffer, sizeof(buffer), 0);
+  } while (length == -1 && errno == EINTR);
+  if (length < 0) {
+    return false;
+  }
+
+  *contents = absl::StripTrailingAsciiWhitespace(
+      absl::string_view(buffer, length));
+  return true;
+}
+
+bool ReadNumber(int fd, long int* value) {
+  char buffer[kAttributeBufferSize];
+  absl::string_view contents;
+  return ReadAttribute(fd, buffer, &contents) &&
+         absl::SimpleAtoi(contents, value);
+}
 
-std::vector<std::string> GetBatteryDirectories() {
-  static constexpr const char kPowerSupply[] = "/sys/class/power_supply";
+}  // namespace
 
+namespace linux_sysfs {
+
+std::vector<std::string> GetBatteryDirectories(
+    std::string const& power_supply) {
   std::vector<std::string> directories;
 
-  for (auto& entry : util::fs::DirectoryContents(kPowerSupply)) {
-    if (entry.substr(0, 2) == "AC") {
+  for (auto& entry : util::fs::DirectoryContents(power_supply)) {
+    if (entry.empty() || entry.substr(0, 2) == "AC") {
       continue;
     }
 
-    auto sys_path = util::fs::BuildPath({kPowerSupply, entry});
+    auto sys_path = util::fs::BuildPath({power_supply, entry});
+
+    // Skip mains adapters, USB chargers and the like (as well as peripherals,
+    // which report their batteries with a scope of "Device").
+    std::string type;
+    if (util::fs::ReadFile(util::fs::BuildPath({sys_path, "type"}), &type) &&
+        absl::StripTrailingAsciiWhitespace(type) != "Battery") {
+      continue;
+    }
+    std::string scope;
+    if (util::fs::ReadFile(util::fs::BuildPath({sys_path, "scope"}), &scope) &&
+        absl::StripTrailingAsciiWhitespace(scope) == "Device") {
+      continue;
+    }
 
     if (util::fs::FileExists({sys_path, "present"})) {
       directories.push_back(sys_path);
@@ -25,70 +91,83 @@ std::vector<std::string> GetBatteryDirectories() {
 }
 
 Battery::Battery(const std::string& base_path)
-    : found_(false),
+    : current_now_fd_(-1),
+      energy_now_fd_(-1),
+      energy_full_fd_(-1),
+      status_fd_(-1),
+      found_(false),
+      energy_full_(0),
+      energy_now_(0),
+      current_now_(0),
       charge_state_(ChargeState::kUnknown),
       charge_percentage_(0.0),
       seconds_to_charge_(0) {
   if (util::fs::FileExists({base_path, "energy_now"})) {
-    path_energy_now_ = util::fs::BuildPath({base_path, "energy_now"});
-    path_energy_full_ = util::fs::BuildPath({base_path, "energy_full"});
+    energy_now_fd_ = OpenAttribute(base_path, "energy_now");
+    energy_full_fd_ = OpenAttribute(base_path, "energy_full");
   } else if (util::fs::FileExists({base_path, "charge_now"})) {
-    path_energy_now_ = util::fs::BuildPath({base_path, "charge_now"});
-    path_energy_full_ = util::fs::BuildPath({base_path, "charge_full"});
+    energy_now_fd_ = OpenAttribute(base_path, "charge_now");
+    energy_full_fd_ = OpenAttribute(base_path, "charge_full");
   }
 
-  path_current_now_ = util::fs::BuildPath({base_path, "power_now"});
+  current_now_fd_ = OpenAttribute(base_path, "power_now");
 
-  if (!util::fs::FileExists(path_current_now_)) {
-    path_current_now_ = util::fs::BuildPath({base_path, "current_now"});
+  if (current_now_fd_ == -1) {
+    current_now_fd_ = OpenAttribute(base_path, "current_now");
   }
 
-  if (!path_energy_now_.empty() && !path_energy_full_.empty()) {
-    path_status_ = util::fs::BuildPath({base_path, "status"});
+  if (energy_now_fd_ != -1 && energy_full_fd_ != -1) {
+    status_fd_ = OpenAttribute(base_path, "status");
   }
 
-  found_ = (!path_current_now_.empty() && !path_energy_now_.empty() &&
-            !path_energy_full_.empty() && !path_status_.empty());
+  found_ = (energy_now_fd_ != -1 && energy_full_fd_ != -1);
+}
+
+Battery::~Battery() {
+  for (int fd :
+       {current_now_fd_, energy_now_fd_, energy_full_fd_, status_fd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
 }
 
 bool Battery::Found() const { return found_; }
 
 bool Battery::Update() {
-  static constexpr const char kStatusCharging[] = "Charging\n";
-  static constexpr const char kStatusDischarging[] = "Discharging\n";
-  static constexpr const char kStatusFull[] = "Full\n";
-
   if (!found_) {
     return false;
   }
 
+  char buffer[kAttributeBufferSize];
+  absl::string_view contents;
+
+  ChargeState previous_charge_state = charge_state_;
   charge_state_ = ChargeState::kUnknown;
 
-  util::fs::ReadFile(path_status_, [&](std::string const& contents) {
-    if (contents == kStatusCharging) {
+  if (ReadAttribute(status_fd_, buffer, &contents)) {
+    if (contents == "Charging") {
       charge_state_ = ChargeState::kCharging;
-    } else if (contents == kStatusDischarging) {
+    } else if (contents == "Discharging") {
       charge_state_ = ChargeState::kDischarging;
-    } else if (contents == kStatusFull) {
+    } else if (contents == "Full") {
       charge_state_ = ChargeState::kFull;
     }
-    return true;
-  });
+  }
 
-  long int energy_now = 0;
-  util::fs::ReadFile(path_energy_now_, [&](std::string const& contents) {
-    return util::string::ToNumber(contents, &energy_now);
-  });
+  energy_now_ = 0;
+  ReadNumber(energy_now_fd_, &energy_now_);
+  long int energy_now = energy_now_;
 
-  long int energy_full = 0;
-  util::fs::ReadFile(path_energy_full_, [&](std::string const& contents) {
-    return util::string::ToNumber(contents, &energy_full);
-  });
+  if (energy_full_ <= 0 || charge_state_ != previous_charge_state) {
+    energy_full_ = 0;
+    ReadNumber(energy_full_fd_, &energy_full_);
+  }
+  long int energy_full = energy_full_;
 
-  long int current_now = 0;
-  util::fs::ReadFile(path_current_now_, [&](std::string const& contents) {
-    return util::string::ToNumber(contents, &current_now);
-  });
+  current_now_ = 0;
+  ReadNumber(current_now_fd_, &current_now_);
+  long int current_now = current_now_;
 
   if (energy_full > 0) {
     charge_percentage_ = std::min(100.0, (energy_now * 100.0) / energy_full);
@@ -120,4 +199,52 @@ ChargeState Battery::charge_state() const { return charge_state_; }
 
 unsigned int Battery::seconds_to_charge() const { return seconds_to_charge_; }
 
+BatteryReading Battery::reading() const {
+  return BatteryReading{charge_state_, static_cast<double>(energy_now_),
+                        static_cast<double>(energy_full_),
+                        static_cast<double>(std::max(0L, current_now_))};
+}
+
+Batteries::Batteries(std::vector<std::string> const& base_paths, Clock clock)
+    : clock_(clock) {
+  for (auto const& base_path : base_paths) {
+    std::unique_ptr<Battery> battery{new Battery(base_path)};
+    if (battery->Found()) {
+      batteries_.push_back(std::move(battery));
+    }
+  }
+}
+
+bool Batteries::Found() const { return !batteries_.empty(); }
+
+bool Batteries::Update() {
+  std::vector<BatteryReading> readings;
+  for (auto const& battery : batteries_) {
+    if (battery->Update()) {
+      readings.push_back(battery->reading());
+    }
+  }
+  if (readings.empty()) {
+    return false;
+  }
+  aggregator_.Update(readings, clock_());
+  return true;
+}
+
+double Batteries::charge_percentage() const {
+  return aggregator_.charge_percentage();
+}
+
+ChargeState Batteries::charge_state() const {
+  return aggregator_.charge_state();
+}
+
+unsigned int Batteries::seconds_to_charge() const {
+  return aggregator_.seconds_to_charge();
+}
+
+absl::Duration Batteries::sampling_interval() const {
+  return aggregator_.sampling_interval();
+}
+
 }  // namespace linux_sysfs
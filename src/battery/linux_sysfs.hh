@@ -1,36 +1,78 @@
 #ifndef TINT3_BATTERY_LINUX_SYSFS_HH
 #define TINT3_BATTERY_LINUX_SYSFS_HH
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "battery/battery_aggregator.hh"
 #include "battery/battery_interface.hh"
 
 namespace linux_sysfs {
 
-std::vector<std::string> GetBatteryDirectories();
+// Returns the directories of the batteries under the given power_supply
+// class directory.
+std::vector<std::string> GetBatteryDirectories(
+    std::string const& power_supply = "/sys/class/power_supply");
 
+// Attribute files are opened once, and read again from the start on every
+// update: sysfs regenerates their contents on each read.
 class Battery : public BatteryInterface {
  public:
   Battery(std::string const& base_path);
+  ~Battery();
+
+  Battery(Battery const&) = delete;
+  Battery& operator=(Battery const&) = delete;
 
   bool Found() const;
   bool Update();
   double charge_percentage() const;
   ChargeState charge_state() const;
   unsigned int seconds_to_charge() const;
+  BatteryReading reading() const;
 
  private:
-  std::string path_current_now_;
-  std::string path_energy_now_;
-  std::string path_energy_full_;
-  std::string path_status_;
+  int current_now_fd_;
+  int energy_now_fd_;
+  int energy_full_fd_;
+  int status_fd_;
   bool found_;
+  // The full charge only changes (slowly) as the battery wears out, so it's
+  // only read again when the charge state changes.
+  long int energy_full_;
+  long int energy_now_;
+  long int current_now_;
   ChargeState charge_state_;
   double charge_percentage_;
   unsigned int seconds_to_charge_;
 };
 
+// All the batteries of the system, combined.
+class Batteries : public BatteryInterface {
+ public:
+  using Clock = std::function<absl::Time()>;
+
+  Batteries(std::vector<std::string> const& base_paths,
+            Clock clock = absl::Now);
+
+  bool Found() const;
+  bool Update();
+  double charge_percentage() const;
+  ChargeState charge_state() const;
+  unsigned int seconds_to_charge() const;
+  absl::Duration sampling_interval() const;
+
+ private:
+  std::vector<std::unique_ptr<Battery>> batteries_;
+  Clock clock_;
+  BatteryAggregator aggregator_;
+};
+
 }  // namespace linux_sysfs
 
 #endif  // TINT3_BATTERY_LINUX_SYSFS_HH
@@ -0,0 +1,167 @@
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_split.h"
+
+#include "battery/linux_uevent.hh"
+#include "util/log.hh"
+
+namespace {
+
+// Multicast group the kernel broadcasts uevents to (udev rebroadcasts them on
+// the second one, in its own format).
+constexpr unsigned int kKernelGroup = 1;
+
+// Uevents are limited to 2 KiB by the kernel (UEVENT_BUFFER_SIZE).
+constexpr size_t kBufferSize = 8192;
+
+int OpenUeventSocket() {
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  NETLINK_KOBJECT_UEVENT);
+  if (fd == -1) {
+    util::log::Error() << "Failed to open the uevent socket: "
+                       << std::strerror(errno) << '\n';
+    return -1;
+  }
+
+  struct sockaddr_nl address;
+  std::memset(&address, 0, sizeof(address));
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = kKernelGroup;
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) == -1) {
+    util::log::Error() << "Failed to bind the uevent socket: "
+                       << std::strerror(errno) << '\n';
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+namespace linux_uevent {
+
+bool ParseUevent(absl::string_view message, Uevent* event) {
+  event->action.clear();
+  event->devpath.clear();
+  event->subsystem.clear();
+  event->properties.clear();
+
+  bool header = true;
+  for (absl::string_view line : absl::StrSplit(message, '\0')) {
+    if (line.empty()) {
+      continue;
+    }
+
+    if (header) {
+      // action@devpath
+      size_t at = line.find('@');
+      if (at == absl::string_view::npos) {
+        return false;
+      }
+      event->action = std::string{line.substr(0, at)};
+      event->devpath = std::string{line.substr(at + 1)};
+      header = false;
+      continue;
+    }
+
+    size_t equals = line.find('=');
+    if (equals == absl::string_view::npos) {
+      continue;
+    }
+    std::string key{line.substr(0, equals)};
+    std::string value{line.substr(equals + 1)};
+    if (key == "SUBSYSTEM") {
+      event->subsystem = value;
+    }
+    event->properties[key] = std::move(value);
+  }
+
+  return !header;
+}
+
+Monitor::Monitor(std::string const& subsystem)
+    : subsystem_(subsystem), fd_(OpenUeventSocket()) {}
+
+Monitor::Monitor(std::string const& subsystem, int fd)
+    : subsystem_(subsystem), fd_(fd) {}
+
+Monitor::~Monitor() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+bool Monitor::IsAlive() const { return (fd_ != -1); }
+
+int Monitor::fd() const { return fd_; }
+
+void Monitor::ProcessEvents(Callback const& callback) {
+  if (fd_ == -1) {
+    return;
+  }
+
+  // Like in util::FileWatcher, only run the callback once all the events have
+  // been read.
+  std::vector<Uevent> events;
+  bool overflow = false;
+
+  std::vector<char> buffer(kBufferSize);
+  while (true) {
+    struct sockaddr_nl sender;
+    struct iovec iov;
+    iov.iov_base = buffer.data();
+    iov.iov_len = buffer.size();
+
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_name = &sender;
+    message.msg_namelen = sizeof(sender);
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    ssize_t length = recvmsg(fd_, &message, MSG_DONTWAIT);
+    if (length == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == ENOBUFS) {
+        overflow = true;
+        continue;
+      }
+      break;
+    }
+    if (length == 0) {
+      break;
+    }
+
+    // Only trust the kernel, not whatever userspace process sends to the
+    // group. Test sockets have no netlink address, and are trusted.
+    if (message.msg_namelen == sizeof(sender) && sender.nl_pid != 0) {
+      continue;
+    }
+
+    Uevent event;
+    if (!ParseUevent(absl::string_view(buffer.data(), length), &event) ||
+        event.subsystem != subsystem_) {
+      continue;
+    }
+    events.push_back(std::move(event));
+  }
+
+  if (overflow) {
+    callback(Uevent{});
+  }
+  for (auto const& event : events) {
+    callback(event);
+  }
+}
+
+}  // namespace linux_uevent
@@ -0,0 +1,65 @@
+#ifndef TINT3_BATTERY_LINUX_UEVENT_HH
+#define TINT3_BATTERY_LINUX_UEVENT_HH
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace linux_uevent {
+
+// A kernel uevent, as broadcast on NETLINK_KOBJECT_UEVENT sockets, e.g.:
+//
+//   change@/devices/LNXSYSTM:00/.../power_supply/BAT0
+//   ACTION=change
+//   SUBSYSTEM=power_supply
+//   POWER_SUPPLY_NAME=BAT0
+//   POWER_SUPPLY_STATUS=Discharging
+//
+// with each line terminated by a NUL character instead of a newline.
+struct Uevent {
+  std::string action;
+  std::string devpath;
+  std::string subsystem;
+  std::map<std::string, std::string> properties;
+};
+
+bool ParseUevent(absl::string_view message, Uevent* event);
+
+// Listens to the kernel uevents of a subsystem. The events are only read and
+// dispatched by ProcessEvents(), which is meant to be called by the event loop
+// whenever fd() becomes readable.
+class Monitor {
+ public:
+  // Called for every event of the subsystem. If events were lost (because
+  // they weren't read quickly enough), it's called once with an empty event,
+  // in which case anything in the subsystem may have changed.
+  using Callback = std::function<void(Uevent const&)>;
+
+  explicit Monitor(std::string const& subsystem);
+
+  // Reads the events from the given datagram socket instead of the kernel,
+  // taking ownership of it. This is meant for tests.
+  Monitor(std::string const& subsystem, int fd);
+
+  ~Monitor();
+
+  Monitor(Monitor const&) = delete;
+  Monitor& operator=(Monitor const&) = delete;
+
+  bool IsAlive() const;
+  int fd() const;
+
+  // Reads all the pending events, and runs the callback for the ones
+  // matching the subsystem.
+  void ProcessEvents(Callback const& callback);
+
+ private:
+  std::string subsystem_;
+  int fd_;
+};
+
+}  // namespace linux_uevent
+
+#endif  // TINT3_BATTERY_LINUX_UEVENT_HH
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "battery/linux_sysfs.hh"
+#include "battery/linux_uevent.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+namespace {
+
+// Messages are NUL separated, which string literals don't make easy.
+std::string MakeMessage(std::vector<std::string> const& lines) {
+  std::string message;
+  for (auto const& line : lines) {
+    message.append(line);
+    message.push_back('\0');
+  }
+  return message;
+}
+
+std::string BatteryMessage(std::string const& status) {
+  return MakeMessage({
+      "change@/devices/LNXSYSTM:00/PNP0C0A:00/power_supply/BAT0",
+      "ACTION=change",
+      "DEVPATH=/devices/LNXSYSTM:00/PNP0C0A:00/power_supply/BAT0",
+      "SUBSYSTEM=power_supply",
+      "POWER_SUPPLY_NAME=BAT0",
+      "POWER_SUPPLY_STATUS=" + status,
+  });
+}
+
+void MakeBattery(util::fs::Path path, std::string const& status,
+                 std::string const& energy_now) {
+  REQUIRE(util::fs::CreateDirectory(path));
+  REQUIRE(util::fs::WriteFile(path / "present", "1\n"));
+  REQUIRE(util::fs::WriteFile(path / "status", status + "\n"));
+  REQUIRE(util::fs::WriteFile(path / "energy_now", energy_now + "\n"));
+  REQUIRE(util::fs::WriteFile(path / "energy_full", "50000000\n"));
+  REQUIRE(util::fs::WriteFile(path / "power_now", "10000000\n"));
+}
+
+}  // namespace
+
+TEST_CASE("ParseUevent") {
+  linux_uevent::Uevent event;
+  REQUIRE(linux_uevent::ParseUevent(BatteryMessage("Charging"), &event));
+  REQUIRE(event.action == "change");
+  REQUIRE(event.devpath ==
+          "/devices/LNXSYSTM:00/PNP0C0A:00/power_supply/BAT0");
+  REQUIRE(event.subsystem == "power_supply");
+  REQUIRE(event.properties.at("POWER_SUPPLY_NAME") == "BAT0");
+  REQUIRE(event.properties.at("POWER_SUPPLY_STATUS") == "Charging");
+
+  // udev rebroadcasts events in its own binary format, without a header.
+  REQUIRE_FALSE(linux_uevent::ParseUevent(
+      MakeMessage({"libudev", "SUBSYSTEM=power_supply"}), &event));
+  REQUIRE_FALSE(linux_uevent::ParseUevent("", &event));
+}
+
+TEST_CASE("Monitor") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) == 0);
+  linux_uevent::Monitor monitor{"power_supply", fds[0]};
+  REQUIRE(monitor.IsAlive());
+
+  std::vector<linux_uevent::Uevent> events;
+  auto callback = [&](linux_uevent::Uevent const& event) {
+    events.push_back(event);
+  };
+
+  SECTION("events of the subsystem are reported") {
+    std::string charging = BatteryMessage("Charging");
+    std::string discharging = BatteryMessage("Discharging");
+    std::string other = MakeMessage({"add@/devices/virtual/input/input42",
+                                     "ACTION=add", "SUBSYSTEM=input"});
+    REQUIRE(send(fds[1], charging.data(), charging.size(), 0) > 0);
+    REQUIRE(send(fds[1], other.data(), other.size(), 0) > 0);
+    REQUIRE(send(fds[1], discharging.data(), discharging.size(), 0) > 0);
+
+    monitor.ProcessEvents(callback);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].properties.at("POWER_SUPPLY_STATUS") == "Charging");
+    REQUIRE(events[1].properties.at("POWER_SUPPLY_STATUS") == "Discharging");
+  }
+
+  SECTION("nothing pending") {
+    monitor.ProcessEvents(callback);
+    REQUIRE(events.empty());
+  }
+
+  close(fds[1]);
+}
+
+TEST_CASE("Batteries are updated on power_supply events") {
+  TemporaryDirectory sysfs;
+  util::fs::Path power_supply = sysfs.path() / "power_supply";
+  REQUIRE(util::fs::CreateDirectory(power_supply / "AC"));
+  REQUIRE(util::fs::WriteFile(power_supply / "AC" / "present", "1\n"));
+  MakeBattery(power_supply / "BAT0", "Discharging", "25000000");
+
+  auto directories = linux_sysfs::GetBatteryDirectories(power_supply);
+  REQUIRE(directories.size() == 1);
+  REQUIRE(directories[0] == std::string{power_supply / "BAT0"});
+
+  linux_sysfs::Battery battery{directories[0]};
+  REQUIRE(battery.Found());
+  REQUIRE(battery.Update());
+  REQUIRE(battery.charge_state() == ChargeState::kDischarging);
+  REQUIRE(battery.charge_percentage() == Approx(50.0));
+  REQUIRE(battery.seconds_to_charge() == 9000);
+
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) == 0);
+  linux_uevent::Monitor monitor{"power_supply", fds[0]};
+
+  // The AC adapter gets plugged in: the kernel updates sysfs, then sends the
+  // event.
+  MakeBattery(power_supply / "BAT0", "Charging", "30000000");
+  std::string message = BatteryMessage("Charging");
+  REQUIRE(send(fds[1], message.data(), message.size(), 0) > 0);
+
+  monitor.ProcessEvents(
+      [&](linux_uevent::Uevent const&) { REQUIRE(battery.Update()); });
+  REQUIRE(battery.charge_state() == ChargeState::kCharging);
+  REQUIRE(battery.charge_percentage() == Approx(60.0));
+  REQUIRE(battery.seconds_to_charge() == 7200);
+
+  close(fds[1]);
+}
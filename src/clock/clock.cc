@@ -57,6 +57,10 @@ static Interval::Id clock_timeout;
 
 namespace {
 
+// Clocks showing minutes only are checked every second, so they're already up
+// to a second late: half a second more makes no difference.
+const absl::Duration kMinutesClockSlack = absl::Milliseconds(500);
+
 absl::TimeZone LoadTimeZone(std::string const& timezone) {
   if (timezone.empty()) return absl::LocalTimeZone();
 
@@ -153,7 +157,9 @@ void InitClock(Timer& timer) {
 
   auto& update_func =
       (has_seconds_format ? UpdateClockSeconds : UpdateClockMinutes);
-  clock_timeout = timer.SetInterval(absl::Seconds(1), update_func);
+  clock_timeout = timer.SetInterval(
+      absl::Seconds(1), update_func,
+      (has_seconds_format ? absl::ZeroDuration() : kMinutesClockSlack));
   update_func();
 }
 
@@ -46,11 +46,11 @@
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_join.h"
-#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 
 #include "clock/clock.hh"
 #include "config.hh"
+#include "config_snapshot.hh"
 #include "launcher/launcher.hh"
 #include "panel.hh"
 #include "systray/systraybar.hh"
@@ -93,7 +93,7 @@ void GetAction(std::string const& event, MouseAction* action) {
   }
 }
 
-int GetTaskStatus(std::string const& status) {
+int GetTaskStatus(absl::string_view status) {
   if (status == "active") {
     return kTaskActive;
   }
@@ -109,6 +109,18 @@ int GetTaskStatus(std::string const& status) {
   return kTaskNormal;
 }
 
+// Keys of the form task_<status>_<property>, e.g. "task_active_font_color"
+// (or "task_font_color" for the normal status). This is equivalent to
+// matching them against "task.*<suffix>".
+bool IsTaskStatusKey(absl::string_view key, absl::string_view suffix) {
+  return absl::StartsWith(key, "task") && absl::EndsWith(key, suffix);
+}
+
+int GetTaskStatusFromKey(absl::string_view key) {
+  absl::string_view status{key.substr(key.find('_') + 1)};
+  return GetTaskStatus(status.substr(0, status.find('_')));
+}
+
 Background& GetBackgroundFromId(size_t id) {
   try {
     return backgrounds.at(id);
@@ -122,8 +134,8 @@ Background& GetBackgroundFromId(size_t id) {
 namespace config {
 namespace {
 
-bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
-                       std::string* output) {
+bool IdentifierMatcher(absl::string_view buffer, unsigned int* position,
+                       absl::string_view* output) {
   unsigned int begin = (*position);
   if (!isalpha(buffer[*position])) {
     return false;
@@ -134,7 +146,7 @@ bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
+  (*output) = buffer.substr(begin, end - begin);
   return true;
 }
 
@@ -150,6 +162,32 @@ std::string ExpandWords(std::string const& line) {
   return absl::StrJoin(pieces, " ");
 }
 
+// Returns the file an @import refers to, or an empty string if there is none.
+// Paths are tried as given first, and then relative to the importing file.
+std::string ResolveImportPath(std::string const& import,
+                              util::fs::Path const& from_path) {
+  std::string path{import};
+
+  // try to expand words
+  std::string expanded = ExpandWords(path);
+  if (!expanded.empty()) {
+    path = expanded;
+  }
+
+  if (util::fs::FileExists(path)) {
+    return path;
+  }
+  if (!absl::StartsWith(path, "/")) {
+    util::log::Debug()
+        << "config: import file \"" << path
+        << "\" doesn't exist, attempting an import from a relative path\n";
+    return from_path.DirectoryName() / path;
+  }
+  util::log::Debug() << "config: import file \"" << path
+                     << "\" doesn't exist, ignoring\n";
+  return std::string{};
+}
+
 }  // namespace
 
 const parser::Lexer kLexer{
@@ -210,7 +248,7 @@ bool Parser::Import(parser::TokenList* tokens) {
   tokens->Accept(kImport);
   tokens->SkipOver(kWhitespace);
 
-  std::vector<parser::Token> skipped;
+  absl::string_view skipped;
   if (!tokens->SkipUntil(kNewLine, &skipped) &&
       tokens->Current().symbol != parser::kEOF) {
     return false;
@@ -218,39 +256,21 @@ bool Parser::Import(parser::TokenList* tokens) {
 
   tokens->SkipOver(kNewLine);
 
-  std::string path{parser::TokenList::JoinSkipped(skipped)};
-  absl::StripAsciiWhitespace(&path);
+  std::string import{absl::StripAsciiWhitespace(skipped)};
 
-  if (path.empty()) {
+  if (import.empty()) {
     return false;
   }
 
-  // try to expand words
-  std::string expanded = ExpandWords(path);
-  if (!expanded.empty()) {
-    path = expanded;
-  }
-
-  if (util::fs::FileExists(path)) {
-    util::log::Debug() << "config: importing \"" << path << "\"\n";
-    if (!reader_->LoadFromFile(path)) {
-      util::log::Error() << "config: failed importing \"" << path
-                         << "\", ignoring\n";
-    }
-  } else if (!absl::StartsWith(path, "/")) {
-    util::log::Debug()
-        << "config: import file \"" << path
-        << "\" doesn't exist, attempting an import from a relative path\n";
-    path = (current_config_path_.DirectoryName() / path);
+  std::string path = ResolveImportPath(import, current_config_path_);
+  reader_->RecordImport(import, current_config_path_, path);
 
+  if (!path.empty()) {
     util::log::Debug() << "config: importing \"" << path << "\"\n";
     if (!reader_->LoadFromFile(path)) {
       util::log::Error() << "config: failed importing \"" << path
                          << "\", ignoring\n";
     }
-  } else {
-    util::log::Debug() << "config: import file \"" << path
-                       << "\" doesn't exist, ignoring\n";
   }
 
   return ConfigEntryParser(tokens);
@@ -259,8 +279,7 @@ bool Parser::Import(parser::TokenList* tokens) {
 bool Parser::Assignment(parser::TokenList* tokens) {
   tokens->SkipOver(kWhitespace);
 
-  std::string key{tokens->Current().match};
-  absl::AsciiStrToLower(&key);
+  absl::string_view key{tokens->CurrentMatch()};
   if (!tokens->Accept(kIdentifier)) {
     return false;
   }
@@ -273,16 +292,13 @@ bool Parser::Assignment(parser::TokenList* tokens) {
 
   tokens->SkipOver(kWhitespace);
 
-  std::vector<parser::Token> skipped;
-  if (!tokens->SkipUntil(kNewLine, &skipped) &&
+  absl::string_view value;
+  if (!tokens->SkipUntil(kNewLine, &value) &&
       tokens->Current().symbol != parser::kEOF) {
     return false;
   }
 
-  std::string value{parser::TokenList::JoinSkipped(skipped)};
-  absl::StripAsciiWhitespace(&value);
-
-  if (!AddKeyValue(key, value)) {
+  if (!AddKeyValue(key, absl::StripAsciiWhitespace(value))) {
     return false;
   }
 
@@ -292,8 +308,9 @@ bool Parser::Assignment(parser::TokenList* tokens) {
   return ConfigEntryParser(tokens);
 }
 
-bool Parser::AddKeyValue(std::string key, std::string value) {
-  reader_->AddEntry(key, value);
+bool Parser::AddKeyValue(absl::string_view key, absl::string_view value) {
+  // Only now do the key and value get copied out of the buffer.
+  reader_->AddEntry(absl::AsciiStrToLower(key), std::string{value});
   return true;
 }
 
@@ -322,7 +339,11 @@ void ExtractValues(std::string const& value, std::string* v1, std::string* v2,
   }
 }
 
-Reader::Reader(Server* server) : server_(server), new_config_file_(false) {
+Reader::Reader(Server* server)
+    : server_(server),
+      new_config_file_(false),
+      load_depth_(0),
+      snapshot_failed_(false) {
   new_panel_config = PanelConfig{};
   tooltip_config = TooltipConfig{};
 }
@@ -376,24 +397,96 @@ bool Reader::LoadFromDefaults() {
 }
 
 bool Reader::LoadFromFile(std::string const& path) {
+  bool top_level = (load_depth_ == 0);
+  std::string snapshot_path;
+  if (top_level) {
+    snapshot_path = Snapshot::PathFor(path);
+    if (LoadFromSnapshot(snapshot_path)) {
+      util::log::Debug() << "config: loaded \"" << path
+                         << "\" from its snapshot\n";
+      return true;
+    }
+    snapshot_.reset(new Snapshot{});
+    snapshot_failed_ = false;
+  }
+
+  ++load_depth_;
   bool read = util::fs::ReadFile(path, [=](std::string const& contents) {
+    if (snapshot_) {
+      snapshot_->AddFile(path, contents);
+    }
     config::Parser config_entry_parser{this, path};
     parser::Parser p{config::kLexer, &config_entry_parser};
     return p.Parse(contents);
   });
+  --load_depth_;
 
   if (!read) {
     util::log::Error() << "Couldn't read the configuration file.\n";
+    snapshot_failed_ = true;
+    if (top_level) {
+      snapshot_.reset();
+    }
+    return false;
+  }
+
+  FinishFile();
+  if (snapshot_) {
+    snapshot_->AddEndOfFile();
+  }
+
+  if (top_level) {
+    if (!snapshot_failed_) {
+      snapshot_->Store(snapshot_path);
+    }
+    snapshot_.reset();
+  }
+  return true;
+}
+
+bool Reader::LoadFromSnapshot(std::string const& snapshot_path) {
+  Snapshot snapshot;
+  if (!snapshot.Load(snapshot_path) || !snapshot.FilesUnchanged()) {
     return false;
   }
 
+  // Imports may resolve differently now (say, if their path depends on the
+  // environment, or a file was created since), so check them all before
+  // replaying anything.
+  for (auto const& import : snapshot.imports()) {
+    util::fs::Path from_path{import.from_path};
+    if (ResolveImportPath(import.path, from_path) != import.resolved_path) {
+      return false;
+    }
+  }
+
+  for (auto const& operation : snapshot.operations()) {
+    switch (operation.kind) {
+      case Snapshot::OperationKind::kEntry:
+        AddEntry(operation.key, operation.value);
+        break;
+      case Snapshot::OperationKind::kEndOfFile:
+        FinishFile();
+        break;
+    }
+  }
+  return true;
+}
+
+void Reader::FinishFile() {
   // append Taskbar item
   if (!new_config_file_) {
     taskbar_enabled = true;
     new_panel_config.items_order.insert(0, "T");
   }
+}
 
-  return true;
+void Reader::RecordImport(std::string const& import,
+                          std::string const& from_path,
+                          std::string const& resolved_path) {
+  if (snapshot_) {
+    snapshot_->AddImport(import, from_path, resolved_path);
+  }
 }
 
 namespace {
@@ -474,16 +567,55 @@ unsigned int ParseBorderSides(std::string const& value) {
   return border_mask;
 }
 
+// 64 bit FNV-1a, computed at compile time for the keys in case labels.
+constexpr uint64_t KeyHash(const char* key,
+                           uint64_t hash = 14695981039346656037ULL) {
+  return (*key == '\0')
+             ? hash
+             : KeyHash(key + 1, (hash ^ static_cast<unsigned char>(*key)) *
+                                    1099511628211ULL);
+}
+
+uint64_t KeyHash(absl::string_view key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
 }  // namespace
 
+// Each AddEntry_* method switches over the hash of the key, so the compiler
+// turns the known keys into a lookup table and rejects any collision between
+// them. Unknown keys could still collide with a known one, so the key itself
+// is compared once (and only once) its case is reached.
+#define CONFIG_KEY(name)  \
+  case KeyHash(name):     \
+    if (key != (name)) {  \
+      return false;       \
+    }
+
 void Reader::AddEntry(std::string const& key, std::string const& value) {
-  if (AddEntry_BackgroundBorder(key, value) || AddEntry_Gradient(key, value) ||
-      AddEntry_Panel(key, value) || AddEntry_Battery(key, value) ||
-      AddEntry_Clock(key, value) || AddEntry_Taskbar(key, value) ||
-      AddEntry_Task(key, value) || AddEntry_Systray(key, value) ||
-      AddEntry_Launcher(key, value) || AddEntry_Tooltip(key, value) ||
-      AddEntry_Executor(key, value) || AddEntry_Mouse(key, value) ||
-      AddEntry_Autohide(key, value) || AddEntry_Legacy(key, value)) {
+  if (snapshot_) {
+    snapshot_->AddEntry(key, value);
+  }
+
+  uint64_t key_hash = KeyHash(key);
+  if (AddEntry_BackgroundBorder(key, key_hash, value) ||
+      AddEntry_Gradient(key, key_hash, value) ||
+      AddEntry_Panel(key, key_hash, value) ||
+      AddEntry_Battery(key, key_hash, value) ||
+      AddEntry_Clock(key, key_hash, value) ||
+      AddEntry_Taskbar(key, key_hash, value) ||
+      AddEntry_Task(key, key_hash, value) ||
+      AddEntry_Systray(key, key_hash, value) ||
+      AddEntry_Launcher(key, key_hash, value) ||
+      AddEntry_Tooltip(key, key_hash, value) ||
+      AddEntry_Executor(key, key_hash, value) ||
+      AddEntry_Mouse(key, key_hash, value) ||
+      AddEntry_Autohide(key, key_hash, value) ||
+      AddEntry_Legacy(key, key_hash, value)) {
     return;
   }
 
@@ -492,679 +624,722 @@ void Reader::AddEntry(std::string const& key, std::string const& value) {
 }
 
 bool Reader::AddEntry_BackgroundBorder(std::string const& key,
+                                       uint64_t key_hash,
                                        std::string const& value) {
-  if (key == "rounded") {
-    int roundness;
-    if (!ParseNumber(value, &roundness)) {
+  switch (key_hash) {
+    CONFIG_KEY("rounded") {
+      int roundness;
+      if (!ParseNumber(value, &roundness)) {
+        return true;
+      }
+      // 'rounded' is the first parameter => alloc a new background
+      Background bg;
+      bg.border().set_rounded(roundness);
+      backgrounds.push_back(bg);
       return true;
     }
-    // 'rounded' is the first parameter => alloc a new background
-    Background bg;
-    bg.border().set_rounded(roundness);
-    backgrounds.push_back(bg);
-    return true;
-  }
-  if (key == "border_width") {
-    int width;
-    if (!ParseNumber(value, &width)) {
+    CONFIG_KEY("border_width") {
+      int width;
+      if (!ParseNumber(value, &width)) {
+        return true;
+      }
+      backgrounds.back().border().set_width(width);
       return true;
     }
-    backgrounds.back().border().set_width(width);
-    return true;
-  }
-  if (key == "background_color") {
-    backgrounds.back().set_fill_color(ParseColor(value));
-    return true;
-  }
-  if (key == "background_color_hover") {
-    backgrounds.back().set_fill_color_hover(ParseColor(value));
-    return true;
-  }
-  if (key == "background_color_pressed") {
-    backgrounds.back().set_fill_color_pressed(ParseColor(value));
-    return true;
-  }
-  if (key == "border_sides") {
-    backgrounds.back().border().set_mask(ParseBorderSides(value));
-    return true;
-  }
-  if (key == "border_color") {
-    backgrounds.back().border().set_color(ParseColor(value));
-    return true;
-  }
-  if (key == "border_color_hover") {
-    backgrounds.back().set_border_color_hover(ParseColor(value));
-    return true;
-  }
-  if (key == "border_color_pressed") {
-    backgrounds.back().set_border_color_pressed(ParseColor(value));
-    return true;
-  }
-  if (key == "gradient_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("background_color") {
+      backgrounds.back().set_fill_color(ParseColor(value));
       return true;
     }
-    backgrounds.back().set_gradient_id(id);
-    return true;
-  }
-  if (key == "gradient_id_hover") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("background_color_hover") {
+      backgrounds.back().set_fill_color_hover(ParseColor(value));
       return true;
     }
-    backgrounds.back().set_gradient_id_hover(id);
-    return true;
-  }
-  if (key == "gradient_id_pressed") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("background_color_pressed") {
+      backgrounds.back().set_fill_color_pressed(ParseColor(value));
       return true;
     }
-    backgrounds.back().set_gradient_id_pressed(id);
-    return true;
+    CONFIG_KEY("border_sides") {
+      backgrounds.back().border().set_mask(ParseBorderSides(value));
+      return true;
+    }
+    CONFIG_KEY("border_color") {
+      backgrounds.back().border().set_color(ParseColor(value));
+      return true;
+    }
+    CONFIG_KEY("border_color_hover") {
+      backgrounds.back().set_border_color_hover(ParseColor(value));
+      return true;
+    }
+    CONFIG_KEY("border_color_pressed") {
+      backgrounds.back().set_border_color_pressed(ParseColor(value));
+      return true;
+    }
+    CONFIG_KEY("gradient_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      backgrounds.back().set_gradient_id(id);
+      return true;
+    }
+    CONFIG_KEY("gradient_id_hover") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      backgrounds.back().set_gradient_id_hover(id);
+      return true;
+    }
+    CONFIG_KEY("gradient_id_pressed") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      backgrounds.back().set_gradient_id_pressed(id);
+      return true;
+    }
+    default:
+      break;
   }
+
   return false;
 }
 
-bool Reader::AddEntry_Gradient(std::string const& key,
+bool Reader::AddEntry_Gradient(std::string const& key, uint64_t key_hash,
                                std::string const& value) {
-  if (key == "gradient") {
-    if (value == "vertical") {
-      gradients.push_back(util::Gradient{util::GradientKind::kVertical});
-    } else if (value == "horizontal") {
-      gradients.push_back(util::Gradient{util::GradientKind::kHorizontal});
-    } else if (value == "radial") {
-      gradients.push_back(util::Gradient{util::GradientKind::kRadial});
-    } else {
-      util::log::Error() << "unknown gradient kind \"" << value
-                         << "\", ignoring\n";
+  switch (key_hash) {
+    CONFIG_KEY("gradient") {
+      if (value == "vertical") {
+        gradients.push_back(util::Gradient{util::GradientKind::kVertical});
+      } else if (value == "horizontal") {
+        gradients.push_back(util::Gradient{util::GradientKind::kHorizontal});
+      } else if (value == "radial") {
+        gradients.push_back(util::Gradient{util::GradientKind::kRadial});
+      } else {
+        util::log::Error() << "unknown gradient kind \"" << value
+                           << "\", ignoring\n";
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "start_color") {
-    gradients.back().set_start_color(ParseColor(value));
-    return true;
-  }
-  if (key == "end_color") {
-    gradients.back().set_end_color(ParseColor(value));
-    return true;
-  }
-  if (key == "color_stop") {
-    std::string::size_type first_space = value.find_first_of(' ');
-    if (first_space == std::string::npos) {
-      util::log::Error() << "malformed color stop \"" << value
-                         << "\", ignoring\n";
+    CONFIG_KEY("start_color") {
+      gradients.back().set_start_color(ParseColor(value));
       return true;
     }
-    std::string percentage_string{value, 0, first_space};
-    int percentage;
-    if (!ParseNumber(percentage_string, &percentage)) {
+    CONFIG_KEY("end_color") {
+      gradients.back().set_end_color(ParseColor(value));
       return true;
     }
-    std::string color_spec{value, first_space + 1};
-    if (!gradients.back().AddColorStop(percentage, ParseColor(color_spec))) {
-      util::log::Error() << "malformed color stop \"" << value
-                         << "\", ignoring\n";
+    CONFIG_KEY("color_stop") {
+      std::string::size_type first_space = value.find_first_of(' ');
+      if (first_space == std::string::npos) {
+        util::log::Error() << "malformed color stop \"" << value
+                           << "\", ignoring\n";
+        return true;
+      }
+      std::string percentage_string{value, 0, first_space};
+      int percentage;
+      if (!ParseNumber(percentage_string, &percentage)) {
+        return true;
+      }
+      std::string color_spec{value, first_space + 1};
+      if (!gradients.back().AddColorStop(percentage, ParseColor(color_spec))) {
+        util::log::Error() << "malformed color stop \"" << value
+                           << "\", ignoring\n";
+      }
+      return true;
     }
-    return true;
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Panel(std::string const& key, std::string const& value) {
-  if (key == "panel_monitor") {
-    new_panel_config.monitor = GetMonitor(value);
-    return true;
-  }
-  if (key == "panel_size") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    size_t b = value1.find_first_of('%');
-    int width;
-    if (!ParseNumber(value1.substr(0, b), &width)) {
+bool Reader::AddEntry_Panel(std::string const& key, uint64_t key_hash,
+                            std::string const& value) {
+  switch (key_hash) {
+    CONFIG_KEY("panel_monitor") {
+      new_panel_config.monitor = GetMonitor(value);
       return true;
     }
+    CONFIG_KEY("panel_size") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (width == 0) {  // width unspecified == full width
-      new_panel_config.width = PercentageSize(100);
-    } else if (b != std::string::npos) {  // percentage sign found
-      new_panel_config.width = PercentageSize(width);
-    } else {
-      new_panel_config.width = AbsoluteSize(width);
-    }
-
-    if (!value2.empty()) {
-      bool use_percentage = false;
-      b = value2.find_first_of('%');
-
-      if (b != std::string::npos) {
-        b = (b - 1);  // don't parse the '%' character
-        use_percentage = true;
-      }
-
-      int height;
-      if (!ParseNumber(value2.substr(0, b), &height)) {
+      size_t b = value1.find_first_of('%');
+      int width;
+      if (!ParseNumber(value1.substr(0, b), &width)) {
         return true;
       }
 
-      if (use_percentage) {
-        new_panel_config.height = PercentageSize(height);
+      if (width == 0) {  // width unspecified == full width
+        new_panel_config.width = PercentageSize(100);
+      } else if (b != std::string::npos) {  // percentage sign found
+        new_panel_config.width = PercentageSize(width);
       } else {
-        new_panel_config.height = AbsoluteSize(height);
+        new_panel_config.width = AbsoluteSize(width);
       }
-    }
 
-    return true;
-  }
-  if (key == "panel_items") {
-    new_config_file_ = true;
-    new_panel_config.items_order.assign(value);
-
-    for (char item : new_panel_config.items_order) {
-      if (item == 'L') {
-        launcher_enabled = true;
-      }
-      if (item == 'T') {
-        taskbar_enabled = true;
+      if (!value2.empty()) {
+        bool use_percentage = false;
+        b = value2.find_first_of('%');
+
+        if (b != std::string::npos) {
+          b = (b - 1);  // don't parse the '%' character
+          use_percentage = true;
+        }
+
+        int height;
+        if (!ParseNumber(value2.substr(0, b), &height)) {
+          return true;
+        }
+
+        if (use_percentage) {
+          new_panel_config.height = PercentageSize(height);
+        } else {
+          new_panel_config.height = AbsoluteSize(height);
+        }
       }
-      if (item == 'B') {
+
+      return true;
+    }
+    CONFIG_KEY("panel_items") {
+      new_config_file_ = true;
+      new_panel_config.items_order.assign(value);
+
+      for (char item : new_panel_config.items_order) {
+        if (item == 'L') {
+          launcher_enabled = true;
+        }
+        if (item == 'T') {
+          taskbar_enabled = true;
+        }
+        if (item == 'B') {
 #ifdef ENABLE_BATTERY
-        battery_enabled = true;
+          battery_enabled = true;
 #else   // ENABLE_BATTERY
-        util::log::Error() << "tint3 is built without battery support\n";
+          util::log::Error() << "tint3 is built without battery support\n";
 #endif  // ENABLE_BATTERY
+        }
+        if (item == 'S') {
+          systray_enabled = true;
+        }
+        if (item == 'C') {
+          clock_enabled = true;
+        }
       }
-      if (item == 'S') {
-        systray_enabled = true;
-      }
-      if (item == 'C') {
-        clock_enabled = true;
-      }
+      return true;
     }
-    return true;
-  }
-  if (key == "panel_margin") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
+    CONFIG_KEY("panel_margin") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    int margin_x;
-    if (!ParseNumber(value1, &margin_x)) {
+      int margin_x;
+      if (!ParseNumber(value1, &margin_x)) {
+        return true;
+      }
+      new_panel_config.margin_x = margin_x;
+
+      if (!value2.empty()) {
+        int margin_y;
+        if (!ParseNumber(value2, &margin_y)) {
+          return true;
+        }
+        new_panel_config.margin_y = margin_y;
+      }
       return true;
     }
-    new_panel_config.margin_x = margin_x;
+    CONFIG_KEY("panel_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      int margin_y;
-      if (!ParseNumber(value2, &margin_y)) {
+      int padding_x_lr;
+      if (!ParseNumber(value1, &padding_x_lr)) {
         return true;
       }
-      new_panel_config.margin_y = margin_y;
+      new_panel_config.padding_x_lr = new_panel_config.padding_x = padding_x_lr;
+
+      if (!value2.empty()) {
+        int padding_y;
+        if (!ParseNumber(value2, &padding_y)) {
+          return true;
+        }
+        new_panel_config.padding_y = padding_y;
+      }
+      if (!value3.empty()) {
+        int padding_x;
+        if (!ParseNumber(value3, &padding_x)) {
+          return true;
+        }
+        new_panel_config.padding_x = padding_x;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "panel_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
+    CONFIG_KEY("panel_position") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+
+      if (value1 == "top") {
+        new_panel_config.vertical_position = PanelVerticalPosition::kTop;
+      } else if (value1 == "bottom") {
+        new_panel_config.vertical_position = PanelVerticalPosition::kBottom;
+      } else {
+        new_panel_config.vertical_position = PanelVerticalPosition::kCenter;
+      }
+
+      if (value2 == "left") {
+        new_panel_config.horizontal_position = PanelHorizontalPosition::kLeft;
+      } else if (value2 == "right") {
+        new_panel_config.horizontal_position = PanelHorizontalPosition::kRight;
+      } else {
+        new_panel_config.horizontal_position = PanelHorizontalPosition::kCenter;
+      }
 
-    int padding_x_lr;
-    if (!ParseNumber(value1, &padding_x_lr)) {
+      new_panel_config.horizontal = (value3 != "vertical");
       return true;
     }
-    new_panel_config.padding_x_lr = new_panel_config.padding_x = padding_x_lr;
-
-    if (!value2.empty()) {
-      int padding_y;
-      if (!ParseNumber(value2, &padding_y)) {
+    CONFIG_KEY("font_shadow") {
+      int shadow;
+      if (!ParseNumber(value, &shadow)) {
         return true;
       }
-      new_panel_config.padding_y = padding_y;
+      panel_config.g_task.font_shadow = shadow;
+      return true;
     }
-    if (!value3.empty()) {
-      int padding_x;
-      if (!ParseNumber(value3, &padding_x)) {
+    CONFIG_KEY("panel_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
         return true;
       }
-      new_panel_config.padding_x = padding_x;
-    }
-    return true;
-  }
-  if (key == "panel_position") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (value1 == "top") {
-      new_panel_config.vertical_position = PanelVerticalPosition::kTop;
-    } else if (value1 == "bottom") {
-      new_panel_config.vertical_position = PanelVerticalPosition::kBottom;
-    } else {
-      new_panel_config.vertical_position = PanelVerticalPosition::kCenter;
+      new_panel_config.background = GetBackgroundFromId(id);
+      return true;
     }
-
-    if (value2 == "left") {
-      new_panel_config.horizontal_position = PanelHorizontalPosition::kLeft;
-    } else if (value2 == "right") {
-      new_panel_config.horizontal_position = PanelHorizontalPosition::kRight;
-    } else {
-      new_panel_config.horizontal_position = PanelHorizontalPosition::kCenter;
+    CONFIG_KEY("wm_menu") {
+      ParseBoolean(value, &new_panel_config.wm_menu);
+      return true;
     }
-
-    new_panel_config.horizontal = (value3 != "vertical");
-    return true;
-  }
-  if (key == "font_shadow") {
-    int shadow;
-    if (!ParseNumber(value, &shadow)) {
+    CONFIG_KEY("panel_dock") {
+      ParseBoolean(value, &new_panel_config.dock);
       return true;
     }
-    panel_config.g_task.font_shadow = shadow;
-    return true;
-  }
-  if (key == "panel_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("urgent_nb_of_blink") {
+      ParseNumber(value, &new_panel_config.max_urgent_blinks);
       return true;
     }
-    new_panel_config.background = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "wm_menu") {
-    ParseBoolean(value, &new_panel_config.wm_menu);
-    return true;
-  }
-  if (key == "panel_dock") {
-    ParseBoolean(value, &new_panel_config.dock);
-    return true;
-  }
-  if (key == "urgent_nb_of_blink") {
-    ParseNumber(value, &new_panel_config.max_urgent_blinks);
-    return true;
-  }
-  if (key == "panel_layer") {
-    if (value == "bottom") {
-      new_panel_config.layer = PanelLayer::kBottom;
-    } else if (value == "top") {
-      new_panel_config.layer = PanelLayer::kTop;
-    } else {
-      new_panel_config.layer = PanelLayer::kNormal;
+    CONFIG_KEY("panel_layer") {
+      if (value == "bottom") {
+        new_panel_config.layer = PanelLayer::kBottom;
+      } else if (value == "top") {
+        new_panel_config.layer = PanelLayer::kTop;
+      } else {
+        new_panel_config.layer = PanelLayer::kNormal;
+      }
+      return true;
     }
-    return true;
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Battery(std::string const& key,
+bool Reader::AddEntry_Battery(std::string const& key, uint64_t key_hash,
                               std::string const& value) {
-  if (key == "battery_low_status") {
+  switch (key_hash) {
+    CONFIG_KEY("battery_low_status") {
 #ifdef ENABLE_BATTERY
-    int low_status;
-    if (!ParseNumber(value, &low_status)) {
+      int low_status;
+      if (!ParseNumber(value, &low_status)) {
+        return true;
+      }
+      battery_low_status = 0;
+      if (low_status >= 0 && low_status <= 100) {
+        battery_low_status = low_status;
+      }
+#endif  // ENABLE_BATTERY
       return true;
     }
-    battery_low_status = 0;
-    if (low_status >= 0 && low_status <= 100) {
-      battery_low_status = low_status;
-    }
-#endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "battery_low_cmd") {
+    CONFIG_KEY("battery_low_cmd") {
 #ifdef ENABLE_BATTERY
-    if (!value.empty()) {
-      battery_low_cmd = value;
-    }
+      if (!value.empty()) {
+        battery_low_cmd = value;
+      }
 #endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "bat1_font") {
+      return true;
+    }
+    CONFIG_KEY("bat1_font") {
 #ifdef ENABLE_BATTERY
-    bat1_font_desc = pango_font_description_from_string(value.c_str());
+      bat1_font_desc = pango_font_description_from_string(value.c_str());
 #endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "bat2_font") {
+      return true;
+    }
+    CONFIG_KEY("bat2_font") {
 #ifdef ENABLE_BATTERY
-    bat2_font_desc = pango_font_description_from_string(value.c_str());
+      bat2_font_desc = pango_font_description_from_string(value.c_str());
 #endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "battery_font_color") {
+      return true;
+    }
+    CONFIG_KEY("battery_font_color") {
 #ifdef ENABLE_BATTERY
-    new_panel_config.battery.font = ParseColor(value);
+      new_panel_config.battery.font = ParseColor(value);
 #endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "battery_padding") {
-#ifdef ENABLE_BATTERY
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &new_panel_config.battery.padding_x_lr_)) {
       return true;
     }
-    new_panel_config.battery.padding_x_ =
-        new_panel_config.battery.padding_x_lr_;
+    CONFIG_KEY("battery_padding") {
+#ifdef ENABLE_BATTERY
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &new_panel_config.battery.padding_y_)) {
+      if (!ParseNumber(value1, &new_panel_config.battery.padding_x_lr_)) {
         return true;
       }
-    }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &new_panel_config.battery.padding_x_)) {
-        return true;
+      new_panel_config.battery.padding_x_ =
+          new_panel_config.battery.padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &new_panel_config.battery.padding_y_)) {
+          return true;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &new_panel_config.battery.padding_x_)) {
+          return true;
+        }
       }
-    }
 #endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "battery_background_id") {
-#ifdef ENABLE_BATTERY
-    int id;
-    if (!ParseNumber(value, &id)) {
       return true;
     }
-    new_panel_config.battery.bg_ = GetBackgroundFromId(id);
-#endif  // ENABLE_BATTERY
-    return true;
-  }
-  if (key == "battery_hide") {
+    CONFIG_KEY("battery_background_id") {
 #ifdef ENABLE_BATTERY
-    if (!ParseNumber(value, &percentage_hide)) {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      new_panel_config.battery.bg_ = GetBackgroundFromId(id);
+#endif  // ENABLE_BATTERY
       return true;
     }
-    if (percentage_hide == 0) {
-      percentage_hide = 101;
-    }
+    CONFIG_KEY("battery_hide") {
+#ifdef ENABLE_BATTERY
+      if (!ParseNumber(value, &percentage_hide)) {
+        return true;
+      }
+      if (percentage_hide == 0) {
+        percentage_hide = 101;
+      }
 #endif  // ENABLE_BATTERY
-    return true;
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Clock(std::string const& key, std::string const& value) {
-  if (key == "time1_format") {
-    if (!new_config_file_) {
-      clock_enabled = true;
-      new_panel_config.items_order.push_back('C');
+bool Reader::AddEntry_Clock(std::string const& key, uint64_t key_hash,
+                            std::string const& value) {
+  switch (key_hash) {
+    CONFIG_KEY("time1_format") {
+      if (!new_config_file_) {
+        clock_enabled = true;
+        new_panel_config.items_order.push_back('C');
+      }
+      if (!value.empty()) {
+        time1_format = value;
+        clock_enabled = true;
+      }
+      return true;
     }
-    if (!value.empty()) {
-      time1_format = value;
-      clock_enabled = true;
+    CONFIG_KEY("time2_format") {
+      if (!value.empty()) {
+        time2_format = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "time2_format") {
-    if (!value.empty()) {
-      time2_format = value;
+    CONFIG_KEY("time1_font") {
+      time1_font_desc = pango_font_description_from_string(value.c_str());
+      return true;
     }
-    return true;
-  }
-  if (key == "time1_font") {
-    time1_font_desc = pango_font_description_from_string(value.c_str());
-    return true;
-  }
-  if (key == "time1_timezone") {
-    if (!value.empty()) {
-      time1_timezone = value;
+    CONFIG_KEY("time1_timezone") {
+      if (!value.empty()) {
+        time1_timezone = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "time2_timezone") {
-    if (!value.empty()) {
-      time2_timezone = value;
+    CONFIG_KEY("time2_timezone") {
+      if (!value.empty()) {
+        time2_timezone = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "time2_font") {
-    time2_font_desc = pango_font_description_from_string(value.c_str());
-    return true;
-  }
-  if (key == "clock_font_color") {
-    panel_config.clock()->font_ = ParseColor(value);
-    return true;
-  }
-  if (key == "clock_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &panel_config.clock()->padding_x_lr_)) {
+    CONFIG_KEY("time2_font") {
+      time2_font_desc = pango_font_description_from_string(value.c_str());
+      return true;
+    }
+    CONFIG_KEY("clock_font_color") {
+      panel_config.clock()->font_ = ParseColor(value);
       return true;
     }
-    panel_config.clock()->padding_x_ = panel_config.clock()->padding_x_lr_;
+    CONFIG_KEY("clock_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &panel_config.clock()->padding_y_)) {
+      if (!ParseNumber(value1, &panel_config.clock()->padding_x_lr_)) {
         return true;
       }
+      panel_config.clock()->padding_x_ = panel_config.clock()->padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &panel_config.clock()->padding_y_)) {
+          return true;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &panel_config.clock()->padding_x_)) {
+          return true;
+        }
+      }
+      return true;
     }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &panel_config.clock()->padding_x_)) {
+    CONFIG_KEY("clock_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
         return true;
       }
-    }
-    return true;
-  }
-  if (key == "clock_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+      panel_config.clock()->bg_ = GetBackgroundFromId(id);
       return true;
     }
-    panel_config.clock()->bg_ = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "clock_tooltip") {
-    if (!value.empty()) {
-      time_tooltip_format = value;
+    CONFIG_KEY("clock_tooltip") {
+      if (!value.empty()) {
+        time_tooltip_format = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "clock_tooltip_timezone") {
-    if (!value.empty()) {
-      time_tooltip_timezone = value;
+    CONFIG_KEY("clock_tooltip_timezone") {
+      if (!value.empty()) {
+        time_tooltip_timezone = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "clock_lclick_command") {
-    if (!value.empty()) {
-      clock_lclick_command = value;
+    CONFIG_KEY("clock_lclick_command") {
+      if (!value.empty()) {
+        clock_lclick_command = value;
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "clock_rclick_command") {
-    if (!value.empty()) {
-      clock_rclick_command = value;
+    CONFIG_KEY("clock_rclick_command") {
+      if (!value.empty()) {
+        clock_rclick_command = value;
+      }
+      return true;
     }
-    return true;
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Taskbar(std::string const& key,
+bool Reader::AddEntry_Taskbar(std::string const& key, uint64_t key_hash,
                               std::string const& value) {
-  if (key == "taskbar_mode") {
-    if (value == "multi_desktop") {
-      new_panel_config.taskbar_mode = TaskbarMode::kMultiDesktop;
-    } else {
-      new_panel_config.taskbar_mode = TaskbarMode::kSingleDesktop;
-    }
-    return true;
-  }
-  if (key == "taskbar_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &panel_config.g_taskbar.padding_x_lr_)) {
+  switch (key_hash) {
+    CONFIG_KEY("taskbar_mode") {
+      if (value == "multi_desktop") {
+        new_panel_config.taskbar_mode = TaskbarMode::kMultiDesktop;
+      } else {
+        new_panel_config.taskbar_mode = TaskbarMode::kSingleDesktop;
+      }
       return true;
     }
-    panel_config.g_taskbar.padding_x_ = panel_config.g_taskbar.padding_x_lr_;
+    CONFIG_KEY("taskbar_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &panel_config.g_taskbar.padding_y_)) {
+      if (!ParseNumber(value1, &panel_config.g_taskbar.padding_x_lr_)) {
         return true;
       }
+      panel_config.g_taskbar.padding_x_ = panel_config.g_taskbar.padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &panel_config.g_taskbar.padding_y_)) {
+          return true;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &panel_config.g_taskbar.padding_x_)) {
+          return true;
+        }
+      }
+      return true;
     }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &panel_config.g_taskbar.padding_x_)) {
+    CONFIG_KEY("taskbar_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
         return true;
       }
-    }
-    return true;
-  }
-  if (key == "taskbar_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+      panel_config.g_taskbar.background[kTaskbarNormal] =
+          GetBackgroundFromId(id);
+
+      if (panel_config.g_taskbar.background[kTaskbarActive] == Background{}) {
+        panel_config.g_taskbar.background[kTaskbarActive] =
+            panel_config.g_taskbar.background[kTaskbarNormal];
+      }
       return true;
     }
-    panel_config.g_taskbar.background[kTaskbarNormal] = GetBackgroundFromId(id);
-
-    if (panel_config.g_taskbar.background[kTaskbarActive] == Background{}) {
+    CONFIG_KEY("taskbar_active_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
       panel_config.g_taskbar.background[kTaskbarActive] =
-          panel_config.g_taskbar.background[kTaskbarNormal];
+          GetBackgroundFromId(id);
+      return true;
     }
-    return true;
-  }
-  if (key == "taskbar_active_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("taskbar_name") {
+      ParseBoolean(value, &taskbarname_enabled);
       return true;
     }
-    panel_config.g_taskbar.background[kTaskbarActive] = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "taskbar_name") {
-    ParseBoolean(value, &taskbarname_enabled);
-    return true;
-  }
-  if (key == "taskbar_name_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
+    CONFIG_KEY("taskbar_name_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!ParseNumber(value, &panel_config.g_taskbar.bar_name.padding_x_lr_)) {
+      if (!ParseNumber(value, &panel_config.g_taskbar.bar_name.padding_x_lr_)) {
+        return true;
+      }
+      panel_config.g_taskbar.bar_name.padding_x_ =
+          panel_config.g_taskbar.bar_name.padding_x_lr_;
       return true;
     }
-    panel_config.g_taskbar.bar_name.padding_x_ =
-        panel_config.g_taskbar.bar_name.padding_x_lr_;
-    return true;
-  }
-  if (key == "taskbar_name_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("taskbar_name_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      panel_config.g_taskbar.background_name[kTaskbarNormal] =
+          GetBackgroundFromId(id);
+
+      if (panel_config.g_taskbar.background_name[kTaskbarActive] ==
+          Background{}) {
+        panel_config.g_taskbar.background_name[kTaskbarActive] =
+            panel_config.g_taskbar.background_name[kTaskbarNormal];
+      }
       return true;
     }
-    panel_config.g_taskbar.background_name[kTaskbarNormal] =
-        GetBackgroundFromId(id);
-
-    if (panel_config.g_taskbar.background_name[kTaskbarActive] ==
-        Background{}) {
+    CONFIG_KEY("taskbar_name_active_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
       panel_config.g_taskbar.background_name[kTaskbarActive] =
-          panel_config.g_taskbar.background_name[kTaskbarNormal];
+          GetBackgroundFromId(id);
+      return true;
     }
-    return true;
-  }
-  if (key == "taskbar_name_active_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("taskbar_name_font") {
+      taskbarname_font_desc = pango_font_description_from_string(value.c_str());
       return true;
     }
-    panel_config.g_taskbar.background_name[kTaskbarActive] =
-        GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "taskbar_name_font") {
-    taskbarname_font_desc = pango_font_description_from_string(value.c_str());
-    return true;
-  }
-  if (key == "taskbar_name_font_color") {
-    taskbarname_font = ParseColor(value);
-    return true;
-  }
-  if (key == "taskbar_name_active_font_color") {
-    taskbarname_active_font = ParseColor(value);
-    return true;
+    CONFIG_KEY("taskbar_name_font_color") {
+      taskbarname_font = ParseColor(value);
+      return true;
+    }
+    CONFIG_KEY("taskbar_name_active_font_color") {
+      taskbarname_active_font = ParseColor(value);
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
-  if (key == "task_text") {
-    ParseBoolean(value, &panel_config.g_task.text);
-    return true;
-  }
-  if (key == "task_icon") {
-    ParseBoolean(value, &panel_config.g_task.icon);
-    return true;
-  }
-  if (key == "task_centered") {
-    ParseBoolean(value, &panel_config.g_task.centered);
-    return true;
-  }
-  if (key == "task_width") {
-    // old parameter: just for backward compatibility
-    if (!ParseNumber(value, &panel_config.g_task.maximum_width)) {
+bool Reader::AddEntry_Task(std::string const& key, uint64_t key_hash,
+                           std::string const& value) {
+  switch (key_hash) {
+    CONFIG_KEY("task_text") {
+      ParseBoolean(value, &panel_config.g_task.text);
       return true;
     }
-    panel_config.g_task.maximum_height = 30;
-    return true;
-  }
-  if (key == "task_maximum_size") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &panel_config.g_task.maximum_width)) {
+    CONFIG_KEY("task_icon") {
+      ParseBoolean(value, &panel_config.g_task.icon);
       return true;
     }
-    panel_config.g_task.maximum_height = 30;
-
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &panel_config.g_task.maximum_height)) {
+    CONFIG_KEY("task_centered") {
+      ParseBoolean(value, &panel_config.g_task.centered);
+      return true;
+    }
+    CONFIG_KEY("task_width") {
+      // old parameter: just for backward compatibility
+      if (!ParseNumber(value, &panel_config.g_task.maximum_width)) {
         return true;
       }
-    }
-    return true;
-  }
-  if (key == "task_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &panel_config.g_task.padding_x_lr_)) {
+      panel_config.g_task.maximum_height = 30;
       return true;
     }
-    panel_config.g_task.padding_x_ = panel_config.g_task.padding_x_lr_;
+    CONFIG_KEY("task_maximum_size") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &panel_config.g_task.padding_y_)) {
+      if (!ParseNumber(value1, &panel_config.g_task.maximum_width)) {
         return true;
       }
+      panel_config.g_task.maximum_height = 30;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &panel_config.g_task.maximum_height)) {
+          return true;
+        }
+      }
+      return true;
     }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &panel_config.g_task.padding_x_)) {
+    CONFIG_KEY("task_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+
+      if (!ParseNumber(value1, &panel_config.g_task.padding_x_lr_)) {
         return true;
       }
+      panel_config.g_task.padding_x_ = panel_config.g_task.padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &panel_config.g_task.padding_y_)) {
+          return true;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &panel_config.g_task.padding_x_)) {
+          return true;
+        }
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "task_font") {
-    panel_config.g_task.font_desc =
-        pango_font_description_from_string(value.c_str());
-    return true;
+    CONFIG_KEY("task_font") {
+      panel_config.g_task.font_desc =
+          pango_font_description_from_string(value.c_str());
+      return true;
+    }
+    CONFIG_KEY("task_tooltip") {
+      ParseBoolean(value, &panel_config.g_task.tooltip_enabled);
+      return true;
+    }
+    // "tooltip" is deprecated but here for backwards compatibility
+    CONFIG_KEY("tooltip") {
+      ParseBoolean(value, &panel_config.g_task.tooltip_enabled);
+      return true;
+    }
+    default:
+      break;
   }
-  if (util::string::RegexMatch("task.*_font_color", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+
+  if (IsTaskStatusKey(key, "_font_color")) {
+    int status = GetTaskStatusFromKey(key);
     panel_config.g_task.font[status] = ParseColor(value, 1.0);
     panel_config.g_task.config_font_mask |= (1 << status);
     return true;
   }
-  if (util::string::RegexMatch("task.*_icon_asb", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+  if (IsTaskStatusKey(key, "_icon_asb")) {
+    int status = GetTaskStatusFromKey(key);
     std::string value1, value2, value3;
     config::ExtractValues(value, &value1, &value2, &value3);
     if (!ParseNumber(value1, &panel_config.g_task.alpha[status])) {
@@ -1179,9 +1354,8 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
     panel_config.g_task.config_asb_mask |= (1 << status);
     return true;
   }
-  if (util::string::RegexMatch("task.*_background_id", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+  if (IsTaskStatusKey(key, "_background_id")) {
+    int status = GetTaskStatusFromKey(key);
     int id;
     if (!ParseNumber(value, &id)) {
       return true;
@@ -1194,566 +1368,612 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
     }
     return true;
   }
-  // "tooltip" is deprecated but here for backwards compatibility
-  if (key == "task_tooltip" || key == "tooltip") {
-    ParseBoolean(value, &panel_config.g_task.tooltip_enabled);
-    return true;
-  }
 
   return false;
 }
 
-bool Reader::AddEntry_Systray(std::string const& key,
+bool Reader::AddEntry_Systray(std::string const& key, uint64_t key_hash,
                               std::string const& value) {
-  if (key == "systray_padding") {
-    if (!new_config_file_ && !systray_enabled) {
-      systray_enabled = true;
-      new_panel_config.items_order.push_back('S');
-    }
-
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
+  switch (key_hash) {
+    CONFIG_KEY("systray_padding") {
+      if (!new_config_file_ && !systray_enabled) {
+        systray_enabled = true;
+        new_panel_config.items_order.push_back('S');
+      }
 
-    if (!ParseNumber(value1, &systray.padding_x_lr_)) {
-      return true;
-    }
-    systray.padding_x_ = systray.padding_x_lr_;
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &systray.padding_y_)) {
+      if (!ParseNumber(value1, &systray.padding_x_lr_)) {
         return true;
       }
+      systray.padding_x_ = systray.padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &systray.padding_y_)) {
+          return true;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &systray.padding_x_)) {
+          return true;
+        }
+      }
+      return true;
     }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &systray.padding_x_)) {
+    CONFIG_KEY("systray_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
         return true;
       }
-    }
-    return true;
-  }
-  if (key == "systray_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+      systray.bg_ = GetBackgroundFromId(id);
+      return true;
+    }
+    CONFIG_KEY("systray_sort") {
+      if (value == "descending") {
+        systray.sort = -1;
+      } else if (value == "ascending") {
+        systray.sort = 1;
+      } else if (value == "left2right") {
+        systray.sort = 2;
+      } else if (value == "right2left") {
+        systray.sort = 3;
+      }
       return true;
     }
-    systray.bg_ = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "systray_sort") {
-    if (value == "descending") {
-      systray.sort = -1;
-    } else if (value == "ascending") {
-      systray.sort = 1;
-    } else if (value == "left2right") {
-      systray.sort = 2;
-    } else if (value == "right2left") {
-      systray.sort = 3;
-    }
-    return true;
-  }
-  if (key == "systray_icon_size") {
-    ParseNumber(value, &systray_max_icon_size);
-    return true;
-  }
-  if (key == "systray_icon_asb") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-    if (!ParseNumber(value1, &systray.alpha)) {
+    CONFIG_KEY("systray_icon_size") {
+      ParseNumber(value, &systray_max_icon_size);
       return true;
     }
-    if (!ParseNumber(value2, &systray.saturation)) {
+    CONFIG_KEY("systray_icon_asb") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+      if (!ParseNumber(value1, &systray.alpha)) {
+        return true;
+      }
+      if (!ParseNumber(value2, &systray.saturation)) {
+        return true;
+      }
+      ParseNumber(value3, &systray.brightness);
       return true;
     }
-    ParseNumber(value3, &systray.brightness);
-    return true;
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Launcher(std::string const& key,
+bool Reader::AddEntry_Launcher(std::string const& key, uint64_t key_hash,
                                std::string const& value) {
-  if (key == "launcher_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-
-    if (!ParseNumber(value1, &panel_config.launcher_.padding_x_lr_)) {
-      return false;
-    }
-    panel_config.launcher_.padding_x_ = panel_config.launcher_.padding_x_lr_;
+  switch (key_hash) {
+    CONFIG_KEY("launcher_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &panel_config.launcher_.padding_y_)) {
+      if (!ParseNumber(value1, &panel_config.launcher_.padding_x_lr_)) {
         return false;
       }
+      panel_config.launcher_.padding_x_ = panel_config.launcher_.padding_x_lr_;
+
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &panel_config.launcher_.padding_y_)) {
+          return false;
+        }
+      }
+      if (!value3.empty()) {
+        if (!ParseNumber(value3, &panel_config.launcher_.padding_x_)) {
+          return false;
+        }
+      }
+      return true;
     }
-    if (!value3.empty()) {
-      if (!ParseNumber(value3, &panel_config.launcher_.padding_x_)) {
-        return false;
+    CONFIG_KEY("launcher_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
       }
+      panel_config.launcher_.bg_ = GetBackgroundFromId(id);
+      return true;
     }
-    return true;
-  }
-  if (key == "launcher_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("launcher_icon_size") {
+      ParseNumber(value, &launcher_max_icon_size);
       return true;
     }
-    panel_config.launcher_.bg_ = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "launcher_icon_size") {
-    ParseNumber(value, &launcher_max_icon_size);
-    return true;
-  }
-  if (key == "launcher_item_app") {
-    std::string expanded = ExpandWords(value);
-    if (expanded.empty()) {
-      util::log::Debug() << "expansion failed for \"" << value
-                         << "\", adding verbatim\n";
-      panel_config.launcher_.list_apps_.push_back(value);
-    } else {
-      panel_config.launcher_.list_apps_.push_back(expanded);
+    CONFIG_KEY("launcher_icon_memory_limit") {
+      ParseNumber(value, &launcher_icon_memory_limit);
+      return true;
     }
-    return true;
-  }
-  if (key == "launcher_icon_theme") {
-    // if XSETTINGS manager running, tint3 use it.
-    if (icon_theme_name.empty()) {
-      icon_theme_name = value;
+    CONFIG_KEY("launcher_item_app") {
+      std::string expanded = ExpandWords(value);
+      if (expanded.empty()) {
+        util::log::Debug() << "expansion failed for \"" << value
+                           << "\", adding verbatim\n";
+        panel_config.launcher_.list_apps_.push_back(value);
+      } else {
+        panel_config.launcher_.list_apps_.push_back(expanded);
+      }
+      return true;
     }
-    return true;
-  }
-  if (key == "launcher_icon_asb") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-    if (!ParseNumber(value1, &launcher_alpha)) {
+    CONFIG_KEY("launcher_icon_theme") {
+      // if XSETTINGS manager running, tint3 use it.
+      if (icon_theme_name.empty()) {
+        icon_theme_name = value;
+      }
       return true;
     }
-    if (!ParseNumber(value2, &launcher_saturation)) {
+    CONFIG_KEY("launcher_icon_asb") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+      if (!ParseNumber(value1, &launcher_alpha)) {
+        return true;
+      }
+      if (!ParseNumber(value2, &launcher_saturation)) {
+        return true;
+      }
+      ParseNumber(value3, &launcher_brightness);
       return true;
     }
-    ParseNumber(value3, &launcher_brightness);
-    return true;
-  }
-  if (key == "launcher_tooltip") {
-    ParseBoolean(value, &launcher_tooltip_enabled);
-    return true;
+    CONFIG_KEY("launcher_tooltip") {
+      ParseBoolean(value, &launcher_tooltip_enabled);
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Tooltip(std::string const& key,
+bool Reader::AddEntry_Tooltip(std::string const& key, uint64_t key_hash,
                               std::string const& value) {
-  if (key == "tooltip_show_timeout") {
-    float timeout;
-    if (!ParseNumber(value, &timeout)) {
+  switch (key_hash) {
+    CONFIG_KEY("tooltip_show_timeout") {
+      float timeout;
+      if (!ParseNumber(value, &timeout)) {
+        return true;
+      }
+      tooltip_config.show_timeout_msec = 1000 * timeout;
       return true;
     }
-    tooltip_config.show_timeout_msec = 1000 * timeout;
-    return true;
-  }
-  if (key == "tooltip_hide_timeout") {
-    float timeout;
-    if (!ParseNumber(value, &timeout)) {
+    CONFIG_KEY("tooltip_hide_timeout") {
+      float timeout;
+      if (!ParseNumber(value, &timeout)) {
+        return true;
+      }
+      tooltip_config.hide_timeout_msec = 1000 * timeout;
       return true;
     }
-    tooltip_config.hide_timeout_msec = 1000 * timeout;
-    return true;
-  }
-  if (key == "tooltip_padding") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
+    CONFIG_KEY("tooltip_padding") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
 
-    if (!value1.empty()) {
-      if (!ParseNumber(value1, &tooltip_config.paddingx)) {
-        return true;
+      if (!value1.empty()) {
+        if (!ParseNumber(value1, &tooltip_config.paddingx)) {
+          return true;
+        }
+      }
+      if (!value2.empty()) {
+        if (!ParseNumber(value2, &tooltip_config.paddingy)) {
+          return true;
+        }
       }
+      return true;
     }
-    if (!value2.empty()) {
-      if (!ParseNumber(value2, &tooltip_config.paddingy)) {
+    CONFIG_KEY("tooltip_background_id") {
+      int id;
+      if (!ParseNumber(value, &id)) {
         return true;
       }
+      tooltip_config.bg = GetBackgroundFromId(id);
+      return true;
     }
-    return true;
-  }
-  if (key == "tooltip_background_id") {
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("tooltip_font_color") {
+      tooltip_config.font_color = ParseColor(value, 0.1);
       return true;
     }
-    tooltip_config.bg = GetBackgroundFromId(id);
-    return true;
-  }
-  if (key == "tooltip_font_color") {
-    tooltip_config.font_color = ParseColor(value, 0.1);
-    return true;
-  }
-  if (key == "tooltip_font") {
-    tooltip_config.font_desc =
-        pango_font_description_from_string(value.c_str());
-    return true;
+    CONFIG_KEY("tooltip_font") {
+      tooltip_config.font_desc =
+          pango_font_description_from_string(value.c_str());
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Executor(std::string const& key,
+bool Reader::AddEntry_Executor(std::string const& key, uint64_t key_hash,
                                std::string const& value) {
-  if (key == "execp") {
-    if (value != "new") {
-      util::log::Error() << "unexpected value \"" << value
-                         << "\", for execp, ignoring\n";
+  switch (key_hash) {
+    CONFIG_KEY("execp") {
+      if (value != "new") {
+        util::log::Error() << "unexpected value \"" << value
+                           << "\", for execp, ignoring\n";
+        return true;
+      }
+      executors.push_back(Executor{});
       return true;
     }
-    executors.push_back(Executor{});
-    return true;
-  }
-  if (key == "execp_background_id") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_background_id") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      int id;
+      if (!ParseNumber(value, &id)) {
+        return true;
+      }
+      executors.back().set_background(GetBackgroundFromId(id));
       return true;
     }
-    int id;
-    if (!ParseNumber(value, &id)) {
+    CONFIG_KEY("execp_cache_icon") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_cache_icon(enabled);
       return true;
     }
-    executors.back().set_background(GetBackgroundFromId(id));
-    return true;
-  }
-  if (key == "execp_cache_icon") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_centered") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_centered(enabled);
       return true;
     }
-    bool enabled;
-    ParseBoolean(value, &enabled);
-    executors.back().set_cache_icon(enabled);
-    return true;
-  }
-  if (key == "execp_centered") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command(value);
       return true;
     }
-    bool enabled;
-    ParseBoolean(value, &enabled);
-    executors.back().set_centered(enabled);
-    return true;
-  }
-  if (key == "execp_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_continuous") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_continuous(enabled);
       return true;
     }
-    executors.back().set_command(value);
-    return true;
-  }
-  if (key == "execp_continuous") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_dwheel_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command_down_wheel(value);
       return true;
     }
-    bool enabled;
-    ParseBoolean(value, &enabled);
-    executors.back().set_continuous(enabled);
-    return true;
-  }
-  if (key == "execp_dwheel_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_font") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_font(value);
       return true;
     }
-    executors.back().set_command_down_wheel(value);
-    return true;
-  }
-  if (key == "execp_font") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_font_color") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_font_color(ParseColor(value));
       return true;
     }
-    executors.back().set_font(value);
-    return true;
-  }
-  if (key == "execp_font_color") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_has_icon") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_has_icon(enabled);
       return true;
     }
-    executors.back().set_font_color(ParseColor(value));
-    return true;
-  }
-  if (key == "execp_has_icon") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_icon_h") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      int height;
+      if (!ParseNumber(value, &height)) {
+        return true;
+      }
+      if (height < 0) {
+        util::log::Error() << "negative " << key << " given, ignoring\n";
+      } else {
+        executors.back().set_icon_height(height);
+      }
       return true;
     }
-    bool enabled;
-    ParseBoolean(value, &enabled);
-    executors.back().set_has_icon(enabled);
-    return true;
-  }
-  if (key == "execp_icon_h") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_icon_w") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      int width;
+      if (!ParseNumber(value, &width)) {
+        return true;
+      }
+      if (width < 0) {
+        util::log::Error() << "negative " << key << " given, ignoring\n";
+      } else {
+        executors.back().set_icon_width(width);
+      }
       return true;
     }
-    int height;
-    if (!ParseNumber(value, &height)) {
+    CONFIG_KEY("execp_interval") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      int interval;
+      if (!ParseNumber(value, &interval)) {
+        return true;
+      }
+      if (interval < 0) {
+        util::log::Error() << "negative " << key << " given, ignoring\n";
+      } else {
+        executors.back().set_interval(interval);
+      }
       return true;
     }
-    if (height < 0) {
-      util::log::Error() << "negative " << key << " given, ignoring\n";
-    } else {
-      executors.back().set_icon_height(height);
-    }
-    return true;
-  }
-  if (key == "execp_icon_w") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_lclick_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command_left_click(value);
       return true;
     }
-    int width;
-    if (!ParseNumber(value, &width)) {
+    CONFIG_KEY("execp_markup") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_markup(enabled);
       return true;
     }
-    if (width < 0) {
-      util::log::Error() << "negative " << key << " given, ignoring\n";
-    } else {
-      executors.back().set_icon_width(width);
-    }
-    return true;
-  }
-  if (key == "execp_interval") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_mclick_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command_middle_click(value);
       return true;
     }
-    int interval;
-    if (!ParseNumber(value, &interval)) {
+    CONFIG_KEY("execp_persistent") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      bool enabled;
+      ParseBoolean(value, &enabled);
+      executors.back().set_persistent(enabled);
       return true;
     }
-    if (interval < 0) {
-      util::log::Error() << "negative " << key << " given, ignoring\n";
-    } else {
-      executors.back().set_interval(interval);
-    }
-    return true;
-  }
-  if (key == "execp_lclick_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_rclick_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command_right_click(value);
       return true;
     }
-    executors.back().set_command_left_click(value);
-    return true;
-  }
-  if (key == "execp_markup") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_tooltip") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_tooltip(value);
       return true;
     }
-    bool enabled;
-    ParseBoolean(value, &enabled);
-    executors.back().set_markup(enabled);
-    return true;
-  }
-  if (key == "execp_mclick_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("execp_uwheel_command") {
+      if (executors.empty()) {
+        util::log::Error() << key
+                           << " config entry without any previous execp "
+                              "plugin initialized, ignoring\n";
+        return true;
+      }
+      executors.back().set_command_up_wheel(value);
       return true;
     }
-    executors.back().set_command_middle_click(value);
-    return true;
+    default:
+      break;
   }
-  if (key == "execp_rclick_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+
+  return false;
+}
+
+bool Reader::AddEntry_Mouse(std::string const& key, uint64_t key_hash,
+                            std::string const& value) {
+  switch (key_hash) {
+    CONFIG_KEY("mouse_middle") {
+      GetAction(value, &new_panel_config.mouse_actions.middle);
       return true;
     }
-    executors.back().set_command_right_click(value);
-    return true;
-  }
-  if (key == "execp_tooltip") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("mouse_right") {
+      GetAction(value, &new_panel_config.mouse_actions.right);
       return true;
     }
-    executors.back().set_tooltip(value);
-    return true;
-  }
-  if (key == "execp_uwheel_command") {
-    if (executors.empty()) {
-      util::log::Error() << key
-                         << " config entry without any previous execp "
-                            "plugin initialized, ignoring\n";
+    CONFIG_KEY("mouse_scroll_up") {
+      GetAction(value, &new_panel_config.mouse_actions.scroll_up);
       return true;
     }
-    executors.back().set_command_up_wheel(value);
-    return true;
-  }
-
-  return false;
-}
-
-bool Reader::AddEntry_Mouse(std::string const& key, std::string const& value) {
-  if (key == "mouse_middle") {
-    GetAction(value, &new_panel_config.mouse_actions.middle);
-    return true;
-  }
-  if (key == "mouse_right") {
-    GetAction(value, &new_panel_config.mouse_actions.right);
-    return true;
-  }
-  if (key == "mouse_scroll_up") {
-    GetAction(value, &new_panel_config.mouse_actions.scroll_up);
-    return true;
-  }
-  if (key == "mouse_scroll_down") {
-    GetAction(value, &new_panel_config.mouse_actions.scroll_down);
-    return true;
-  }
-  if (key == "mouse_effects") {
-    ParseBoolean(value, &new_panel_config.mouse_effects);
-    return true;
-  }
-  if (key == "mouse_hover_icon_asb") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-    if (!ParseNumber(value1, &new_panel_config.mouse_hover_alpha)) {
+    CONFIG_KEY("mouse_scroll_down") {
+      GetAction(value, &new_panel_config.mouse_actions.scroll_down);
       return true;
     }
-    if (!ParseNumber(value2, &new_panel_config.mouse_hover_saturation)) {
+    CONFIG_KEY("mouse_effects") {
+      ParseBoolean(value, &new_panel_config.mouse_effects);
       return true;
     }
-    ParseNumber(value3, &new_panel_config.mouse_hover_brightness);
-    return true;
-  }
-  if (key == "mouse_pressed_icon_asb") {
-    std::string value1, value2, value3;
-    config::ExtractValues(value, &value1, &value2, &value3);
-    if (!ParseNumber(value1, &new_panel_config.mouse_pressed_alpha)) {
+    CONFIG_KEY("mouse_hover_icon_asb") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+      if (!ParseNumber(value1, &new_panel_config.mouse_hover_alpha)) {
+        return true;
+      }
+      if (!ParseNumber(value2, &new_panel_config.mouse_hover_saturation)) {
+        return true;
+      }
+      ParseNumber(value3, &new_panel_config.mouse_hover_brightness);
       return true;
     }
-    if (!ParseNumber(value2, &new_panel_config.mouse_pressed_saturation)) {
+    CONFIG_KEY("mouse_pressed_icon_asb") {
+      std::string value1, value2, value3;
+      config::ExtractValues(value, &value1, &value2, &value3);
+      if (!ParseNumber(value1, &new_panel_config.mouse_pressed_alpha)) {
+        return true;
+      }
+      if (!ParseNumber(value2, &new_panel_config.mouse_pressed_saturation)) {
+        return true;
+      }
+      ParseNumber(value3, &new_panel_config.mouse_pressed_brightness);
       return true;
     }
-    ParseNumber(value3, &new_panel_config.mouse_pressed_brightness);
-    return true;
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Autohide(std::string const& key,
+bool Reader::AddEntry_Autohide(std::string const& key, uint64_t key_hash,
                                std::string const& value) {
-  if (key == "autohide") {
-    ParseBoolean(value, &new_panel_config.autohide);
-    return true;
-  }
-  if (key == "autohide_show_timeout") {
-    float timeout;
-    if (!ParseNumber(value, &timeout)) {
+  switch (key_hash) {
+    CONFIG_KEY("autohide") {
+      ParseBoolean(value, &new_panel_config.autohide);
       return true;
     }
-    new_panel_config.autohide_show_timeout = 1000 * timeout;
-    return true;
-  }
-  if (key == "autohide_hide_timeout") {
-    float timeout;
-    if (!ParseNumber(value, &timeout)) {
+    CONFIG_KEY("autohide_show_timeout") {
+      float timeout;
+      if (!ParseNumber(value, &timeout)) {
+        return true;
+      }
+      new_panel_config.autohide_show_timeout = 1000 * timeout;
       return true;
     }
-    new_panel_config.autohide_hide_timeout = 1000 * timeout;
-    return true;
-  }
-  if (key == "strut_policy") {
-    if (value == "follow_size") {
-      new_panel_config.strut_policy = PanelStrutPolicy::kFollowSize;
-    } else if (value == "none") {
-      new_panel_config.strut_policy = PanelStrutPolicy::kNone;
-    } else {
-      new_panel_config.strut_policy = PanelStrutPolicy::kMinimum;
+    CONFIG_KEY("autohide_hide_timeout") {
+      float timeout;
+      if (!ParseNumber(value, &timeout)) {
+        return true;
+      }
+      new_panel_config.autohide_hide_timeout = 1000 * timeout;
+      return true;
     }
-    return true;
-  }
-  if (key == "autohide_height") {
-    int height;
-    if (!ParseNumber(value, &height)) {
+    CONFIG_KEY("strut_policy") {
+      if (value == "follow_size") {
+        new_panel_config.strut_policy = PanelStrutPolicy::kFollowSize;
+      } else if (value == "none") {
+        new_panel_config.strut_policy = PanelStrutPolicy::kNone;
+      } else {
+        new_panel_config.strut_policy = PanelStrutPolicy::kMinimum;
+      }
       return true;
     }
-    new_panel_config.autohide_size_px = std::max(1, height);
-    return true;
+    CONFIG_KEY("autohide_height") {
+      int height;
+      if (!ParseNumber(value, &height)) {
+        return true;
+      }
+      new_panel_config.autohide_size_px = std::max(1, height);
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
-bool Reader::AddEntry_Legacy(std::string const& key, std::string const& value) {
-  if (key == "systray") {
-    if (!new_config_file_) {
-      ParseBoolean(value, &systray_enabled);
-      if (systray_enabled) {
-        new_panel_config.items_order.push_back('S');
+bool Reader::AddEntry_Legacy(std::string const& key, uint64_t key_hash,
+                             std::string const& value) {
+  switch (key_hash) {
+    CONFIG_KEY("systray") {
+      if (!new_config_file_) {
+        ParseBoolean(value, &systray_enabled);
+        if (systray_enabled) {
+          new_panel_config.items_order.push_back('S');
+        }
+        return true;
       }
-      return true;
+      break;
     }
-  }
-  if (key == "battery") {
+    CONFIG_KEY("battery") {
 #ifdef ENABLE_BATTERY
-    if (!new_config_file_) {
-      ParseBoolean(value, &battery_enabled);
-      if (battery_enabled) {
-        new_panel_config.items_order.push_back('B');
+      if (!new_config_file_) {
+        ParseBoolean(value, &battery_enabled);
+        if (battery_enabled) {
+          new_panel_config.items_order.push_back('B');
+        }
       }
-    }
-    return true;
+      return true;
 #endif  // ENABLE_BATTERY
-  }
-  if (key == "primary_monitor_first") {
-    util::log::Error() << "Ignoring legacy option \"primary_monitor_first\".\n";
-    return true;
+      break;
+    }
+    CONFIG_KEY("primary_monitor_first") {
+      util::log::Error()
+          << "Ignoring legacy option \"primary_monitor_first\".\n";
+      return true;
+    }
+    default:
+      break;
   }
 
   return false;
 }
 
+#undef CONFIG_KEY
+
 unsigned int Reader::GetMonitor(std::string const& monitor_name) const {
   if (monitor_name == "all") {
     return Panel::kAllMonitors;
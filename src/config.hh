@@ -1,8 +1,13 @@
 #ifndef TINT3_CONFIG_HH
 #define TINT3_CONFIG_HH
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include "absl/strings/string_view.h"
+
+#include "config_snapshot.hh"
 #include "parser/parser.hh"
 #include "server.hh"
 #include "util/fs.hh"
@@ -48,22 +53,46 @@ class Reader {
   Server* server_;
   bool new_config_file_;
 
+  // Files are loaded from a snapshot of their entries whenever possible. When
+  // not, one is recorded (in snapshot_) while loading the top-level file, and
+  // stored once it's done, unless something went wrong along the way.
+  unsigned int load_depth_;
+  std::unique_ptr<Snapshot> snapshot_;
+  bool snapshot_failed_;
+
+  bool LoadFromSnapshot(std::string const& snapshot_path);
+  void FinishFile();
+  void RecordImport(std::string const& import, std::string const& from_path,
+                    std::string const& resolved_path);
   void AddEntry(std::string const& key, std::string const& value);
-  bool AddEntry_BackgroundBorder(std::string const& key,
+  bool AddEntry_BackgroundBorder(std::string const& key, uint64_t key_hash,
                                  std::string const& value);
-  bool AddEntry_Gradient(std::string const& key, std::string const& value);
-  bool AddEntry_Panel(std::string const& key, std::string const& value);
-  bool AddEntry_Battery(std::string const& key, std::string const& value);
-  bool AddEntry_Clock(std::string const& key, std::string const& value);
-  bool AddEntry_Taskbar(std::string const& key, std::string const& value);
-  bool AddEntry_Task(std::string const& key, std::string const& value);
-  bool AddEntry_Systray(std::string const& key, std::string const& value);
-  bool AddEntry_Launcher(std::string const& key, std::string const& value);
-  bool AddEntry_Tooltip(std::string const& key, std::string const& value);
-  bool AddEntry_Executor(std::string const& key, std::string const& value);
-  bool AddEntry_Mouse(std::string const& key, std::string const& value);
-  bool AddEntry_Autohide(std::string const& key, std::string const& value);
-  bool AddEntry_Legacy(std::string const& key, std::string const& value);
+  bool AddEntry_Gradient(std::string const& key, uint64_t key_hash,
+                         std::string const& value);
+  bool AddEntry_Panel(std::string const& key, uint64_t key_hash,
+                      std::string const& value);
+  bool AddEntry_Battery(std::string const& key, uint64_t key_hash,
+                        std::string const& value);
+  bool AddEntry_Clock(std::string const& key, uint64_t key_hash,
+                      std::string const& value);
+  bool AddEntry_Taskbar(std::string const& key, uint64_t key_hash,
+                        std::string const& value);
+  bool AddEntry_Task(std::string const& key, uint64_t key_hash,
+                     std::string const& value);
+  bool AddEntry_Systray(std::string const& key, uint64_t key_hash,
+                        std::string const& value);
+  bool AddEntry_Launcher(std::string const& key, uint64_t key_hash,
+                         std::string const& value);
+  bool AddEntry_Tooltip(std::string const& key, uint64_t key_hash,
+                        std::string const& value);
+  bool AddEntry_Executor(std::string const& key, uint64_t key_hash,
+                         std::string const& value);
+  bool AddEntry_Mouse(std::string const& key, uint64_t key_hash,
+                      std::string const& value);
+  bool AddEntry_Autohide(std::string const& key, uint64_t key_hash,
+                         std::string const& value);
+  bool AddEntry_Legacy(std::string const& key, uint64_t key_hash,
+                       std::string const& value);
   unsigned int GetMonitor(std::string const& monitor_name) const;
 };
 
@@ -91,7 +120,7 @@ class Parser : public parser::ParseCallback {
   bool Comment(parser::TokenList* tokens);
   bool Import(parser::TokenList* tokens);
   bool Assignment(parser::TokenList* tokens);
-  bool AddKeyValue(std::string key, std::string value);
+  bool AddKeyValue(absl::string_view key, absl::string_view value);
 };
 
 }  // namespace config
@@ -0,0 +1,250 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+#include "config_snapshot.hh"
+#include "util/fs.hh"
+#include "util/log.hh"
+#include "util/xdg.hh"
+
+namespace {
+
+// Snapshot layout, all integers in host byte order:
+//
+//   SnapshotHeader
+//   File[file_count]: string path, uint64_t size, uint64_t hash
+//   Import[import_count]: string path, string from_path, string resolved_path
+//   Operation[operation_count]: uint32_t kind, string key, string value
+//
+// where each string is stored as its uint32_t length followed by its bytes.
+//
+// Bump the version whenever the parser changes the entries it produces, so
+// that snapshots written by older versions get rebuilt.
+constexpr char kSnapshotMagic[8] = {'t', 'i', 'n', 't', '3', 'C', 'F', 'G'};
+constexpr uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t file_count;
+  uint32_t import_count;
+  uint32_t operation_count;
+};
+
+// FNV-1a: unlike std::hash and absl::Hash, it is stable across runs, which is
+// what hashes stored on disk need.
+uint64_t HashContents(absl::string_view contents) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : contents) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+template <typename T>
+void Write(std::string* data, T value) {
+  data->append(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+void WriteString(std::string* data, std::string const& value) {
+  Write<uint32_t>(data, value.length());
+  data->append(value);
+}
+
+// Reads values off the snapshot, failing (once and for all) as soon as
+// anything goes past its end.
+class SnapshotReader {
+ public:
+  explicit SnapshotReader(absl::string_view data) : data_(data), ok_(true) {}
+
+  bool ok() const { return ok_; }
+  bool AtEnd() const { return data_.empty(); }
+
+  template <typename T>
+  T Read() {
+    T value{};
+    if (!ok_ || data_.size() < sizeof(value)) {
+      ok_ = false;
+      return value;
+    }
+    std::memcpy(&value, data_.data(), sizeof(value));
+    data_.remove_prefix(sizeof(value));
+    return value;
+  }
+
+  std::string ReadString() {
+    uint32_t length = Read<uint32_t>();
+    if (!ok_ || data_.size() < length) {
+      ok_ = false;
+      return std::string{};
+    }
+    std::string value{data_.substr(0, length)};
+    data_.remove_prefix(length);
+    return value;
+  }
+
+ private:
+  absl::string_view data_;
+  bool ok_;
+};
+
+}  // namespace
+
+namespace config {
+
+std::string Snapshot::PathFor(std::string const& config_path) {
+  return util::xdg::basedir::CacheHome() / "tint3" /
+         absl::StrFormat("config-%016x.snapshot", HashContents(config_path));
+}
+
+void Snapshot::AddFile(std::string const& path, absl::string_view contents) {
+  files_.push_back(File{path, contents.size(), HashContents(contents)});
+}
+
+void Snapshot::AddImport(std::string const& path, std::string const& from_path,
+                         std::string const& resolved_path) {
+  imports_.push_back(Import{path, from_path, resolved_path});
+}
+
+void Snapshot::AddEntry(std::string const& key, std::string const& value) {
+  operations_.push_back(Operation{OperationKind::kEntry, key, value});
+}
+
+void Snapshot::AddEndOfFile() {
+  operations_.push_back(Operation{OperationKind::kEndOfFile, "", ""});
+}
+
+std::vector<Snapshot::File> const& Snapshot::files() const { return files_; }
+
+std::vector<Snapshot::Import> const& Snapshot::imports() const {
+  return imports_;
+}
+
+std::vector<Snapshot::Operation> const& Snapshot::operations() const {
+  return operations_;
+}
+
+bool Snapshot::FilesUnchanged() const {
+  for (auto const& file : files_) {
+    struct stat info;
+    if (!util::fs::Stat(file.path, &info) ||
+        static_cast<uint64_t>(info.st_size) != file.size) {
+      return false;
+    }
+    std::string contents;
+    if (!util::fs::ReadFile(file.path, &contents) ||
+        HashContents(contents) != file.hash) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Snapshot::Load(std::string const& path) {
+  files_.clear();
+  imports_.clear();
+  operations_.clear();
+
+  util::fs::MappedFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+
+  SnapshotReader reader{file.contents()};
+  SnapshotHeader header = reader.Read<SnapshotHeader>();
+  if (!reader.ok() ||
+      std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+      header.version != kSnapshotVersion) {
+    return false;
+  }
+
+  // Counts come from the file: don't trust them to reserve memory.
+  for (uint32_t i = 0; i < header.file_count && reader.ok(); ++i) {
+    File file;
+    file.path = reader.ReadString();
+    file.size = reader.Read<uint64_t>();
+    file.hash = reader.Read<uint64_t>();
+    files_.push_back(file);
+  }
+  for (uint32_t i = 0; i < header.import_count && reader.ok(); ++i) {
+    Import import;
+    import.path = reader.ReadString();
+    import.from_path = reader.ReadString();
+    import.resolved_path = reader.ReadString();
+    imports_.push_back(import);
+  }
+  bool valid_operations = true;
+  for (uint32_t i = 0; i < header.operation_count && reader.ok(); ++i) {
+    Operation operation;
+    operation.kind = static_cast<OperationKind>(reader.Read<uint32_t>());
+    operation.key = reader.ReadString();
+    operation.value = reader.ReadString();
+    if (operation.kind != OperationKind::kEntry &&
+        operation.kind != OperationKind::kEndOfFile) {
+      valid_operations = false;
+      break;
+    }
+    operations_.push_back(operation);
+  }
+
+  if (!reader.ok() || !reader.AtEnd() || !valid_operations ||
+      files_.empty()) {
+    files_.clear();
+    imports_.clear();
+    operations_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool Snapshot::Store(std::string const& path) const {
+  std::string directory{util::fs::Path(path).DirectoryName()};
+  if (!util::fs::CreateDirectory(directory)) {
+    util::log::Error() << "Couldn't create directory \"" << directory
+                       << "\" for the configuration snapshot\n";
+    return false;
+  }
+
+  SnapshotHeader header;
+  std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+  header.version = kSnapshotVersion;
+  header.file_count = files_.size();
+  header.import_count = imports_.size();
+  header.operation_count = operations_.size();
+
+  std::string data;
+  Write(&data, header);
+  for (auto const& file : files_) {
+    WriteString(&data, file.path);
+    Write(&data, file.size);
+    Write(&data, file.hash);
+  }
+  for (auto const& import : imports_) {
+    WriteString(&data, import.path);
+    WriteString(&data, import.from_path);
+    WriteString(&data, import.resolved_path);
+  }
+  for (auto const& operation : operations_) {
+    Write(&data, static_cast<uint32_t>(operation.kind));
+    WriteString(&data, operation.key);
+    WriteString(&data, operation.value);
+  }
+
+  // Other tint3 instances may be reading it, so never write it in place.
+  std::string temporary_path{absl::StrCat(path, ".", getpid())};
+  if (!util::fs::WriteFile(temporary_path, data) ||
+      std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    util::log::Error() << "Couldn't write the configuration snapshot \""
+                       << path << "\"\n";
+    util::fs::Unlink(temporary_path);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace config
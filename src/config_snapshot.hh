@@ -0,0 +1,77 @@
+#ifndef TINT3_CONFIG_SNAPSHOT_HH
+#define TINT3_CONFIG_SNAPSHOT_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace config {
+
+// Compiled form of a configuration file and everything it imports: the
+// entries they define, in the order they were read, so that they can be
+// replayed without reading, lexing or parsing the files again.
+//
+// A snapshot is only valid as long as the files it was built from have the
+// same contents (checked through their hashes), and imports still resolve to
+// the same files (checked by the reader, which knows how to resolve them).
+//
+// Values are stored as written: whatever depends on the running system, like
+// monitors or fonts, is resolved again when the entries are replayed.
+class Snapshot {
+ public:
+  struct File {
+    std::string path;
+    uint64_t size;
+    uint64_t hash;
+  };
+
+  struct Import {
+    std::string path;       // as written after @import
+    std::string from_path;  // the file containing the @import
+    std::string resolved_path;
+  };
+
+  enum class OperationKind : uint32_t {
+    kEntry,      // key = value
+    kEndOfFile,  // end of a configuration file (imported or not)
+  };
+
+  struct Operation {
+    OperationKind kind;
+    std::string key;
+    std::string value;
+  };
+
+  // Path of the snapshot of the given configuration file, in the user cache
+  // directory.
+  static std::string PathFor(std::string const& config_path);
+
+  void AddFile(std::string const& path, absl::string_view contents);
+  void AddImport(std::string const& path, std::string const& from_path,
+                 std::string const& resolved_path);
+  void AddEntry(std::string const& key, std::string const& value);
+  void AddEndOfFile();
+
+  std::vector<File> const& files() const;
+  std::vector<Import> const& imports() const;
+  std::vector<Operation> const& operations() const;
+
+  // Returns true if all the files still have the contents they had when the
+  // snapshot was built.
+  bool FilesUnchanged() const;
+
+  // Reads a snapshot back, returning false if it's missing or malformed.
+  bool Load(std::string const& path);
+  bool Store(std::string const& path) const;
+
+ private:
+  std::vector<File> files_;
+  std::vector<Import> imports_;
+  std::vector<Operation> operations_;
+};
+
+}  // namespace config
+
+#endif  // TINT3_CONFIG_SNAPSHOT_HH
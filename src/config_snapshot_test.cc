@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include "config_snapshot.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+namespace {
+
+config::Snapshot MakeSnapshot(std::string const& config_path,
+                              std::string const& import_path) {
+  config::Snapshot snapshot;
+  snapshot.AddFile(config_path, "panel_size = 100% 30\n@import other\n");
+  snapshot.AddEntry("panel_size", "100% 30");
+  snapshot.AddImport("other", config_path, import_path);
+  snapshot.AddFile(import_path, "font_shadow = 1\n");
+  snapshot.AddEntry("font_shadow", "1");
+  snapshot.AddEndOfFile();
+  snapshot.AddEndOfFile();
+  return snapshot;
+}
+
+}  // namespace
+
+TEST_CASE("Snapshot") {
+  TemporaryDirectory temp;
+  std::string config_path = temp.path() / "tint3rc";
+  std::string import_path = temp.path() / "other";
+  std::string snapshot_path = temp.path() / "cache" / "config.snapshot";
+
+  REQUIRE(util::fs::WriteFile(config_path,
+                              "panel_size = 100% 30\n@import other\n"));
+  REQUIRE(util::fs::WriteFile(import_path, "font_shadow = 1\n"));
+  REQUIRE(MakeSnapshot(config_path, import_path).Store(snapshot_path));
+
+  SECTION("round trip") {
+    config::Snapshot snapshot;
+    REQUIRE(snapshot.Load(snapshot_path));
+    REQUIRE(snapshot.FilesUnchanged());
+
+    REQUIRE(snapshot.files().size() == 2);
+    REQUIRE(snapshot.files()[0].path == config_path);
+    REQUIRE(snapshot.files()[1].path == import_path);
+
+    REQUIRE(snapshot.imports().size() == 1);
+    REQUIRE(snapshot.imports()[0].path == "other");
+    REQUIRE(snapshot.imports()[0].from_path == config_path);
+    REQUIRE(snapshot.imports()[0].resolved_path == import_path);
+
+    auto const& operations = snapshot.operations();
+    REQUIRE(operations.size() == 4);
+    REQUIRE(operations[0].kind == config::Snapshot::OperationKind::kEntry);
+    REQUIRE(operations[0].key == "panel_size");
+    REQUIRE(operations[0].value == "100% 30");
+    REQUIRE(operations[1].kind == config::Snapshot::OperationKind::kEntry);
+    REQUIRE(operations[1].key == "font_shadow");
+    REQUIRE(operations[1].value == "1");
+    REQUIRE(operations[2].kind ==
+            config::Snapshot::OperationKind::kEndOfFile);
+    REQUIRE(operations[3].kind ==
+            config::Snapshot::OperationKind::kEndOfFile);
+  }
+
+  SECTION("changed files") {
+    // Same size, different contents.
+    REQUIRE(util::fs::WriteFile(import_path, "font_shadow = 0\n"));
+
+    config::Snapshot snapshot;
+    REQUIRE(snapshot.Load(snapshot_path));
+    REQUIRE_FALSE(snapshot.FilesUnchanged());
+
+    REQUIRE(util::fs::Unlink(import_path));
+    REQUIRE_FALSE(snapshot.FilesUnchanged());
+  }
+
+  SECTION("malformed snapshots") {
+    // Snapshots are binary, which ReadFile() doesn't handle.
+    util::fs::MappedFile file;
+    REQUIRE(file.Open(snapshot_path));
+    std::string data{file.contents()};
+    file.Close();
+    REQUIRE(data.length() > 24);
+
+    config::Snapshot snapshot;
+    REQUIRE_FALSE(snapshot.Load(temp.path() / "missing.snapshot"));
+
+    // Every truncation must be rejected, not just the obvious ones.
+    for (size_t length = 0; length < data.length(); ++length) {
+      REQUIRE(util::fs::WriteFile(snapshot_path, data.substr(0, length)));
+      REQUIRE_FALSE(snapshot.Load(snapshot_path));
+      REQUIRE(snapshot.files().empty());
+      REQUIRE(snapshot.operations().empty());
+    }
+
+    REQUIRE(util::fs::WriteFile(snapshot_path, data + "x"));
+    REQUIRE_FALSE(snapshot.Load(snapshot_path));
+
+    std::string bad_magic{data};
+    bad_magic[0] = 'T';
+    REQUIRE(util::fs::WriteFile(snapshot_path, bad_magic));
+    REQUIRE_FALSE(snapshot.Load(snapshot_path));
+
+    std::string bad_version{data};
+    bad_version[8] ^= 0x7f;
+    REQUIRE(util::fs::WriteFile(snapshot_path, bad_version));
+    REQUIRE_FALSE(snapshot.Load(snapshot_path));
+  }
+}
+
+TEST_CASE("Snapshot::PathFor") {
+  std::string path = config::Snapshot::PathFor("/home/user/.config/tint3rc");
+  REQUIRE(path == config::Snapshot::PathFor("/home/user/.config/tint3rc"));
+  REQUIRE(path != config::Snapshot::PathFor("/home/user/.config/other"));
+}
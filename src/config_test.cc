@@ -1,20 +1,26 @@
 #include "catch.hpp"
 
+#include <chrono>
 #include <initializer_list>
 #include <iostream>
 #include <set>
 #include <sstream>
 #include <streambuf>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 
 #include "clock/clock.hh"  // TODO: decouple from config loading
 #include "config.hh"
+#include "config_snapshot.hh"
 #include "panel.hh"  // TODO: decouple from config loading
 #include "server.hh"
+#include "systray/systraybar.hh"  // TODO: decouple from config loading
 #include "tooltip/tooltip.hh"  // TODO: decouple from config loading
 #include "util/color.hh"
+#include "util/environment.hh"
 #include "util/fs.hh"
 #include "util/fs_test_utils.hh"
 #include "util/gradient.hh"
@@ -88,7 +94,9 @@ class MockServer : public Server {
 
 class ConfigReader : public config::Reader {
  public:
-  ConfigReader() : config::Reader(&server_) {}
+  // Only files loaded by tests using snapshots are actually read.
+  explicit ConfigReader(bool read_files = false)
+      : config::Reader(&server_), read_files_(read_files) {}
 
   MockServer& server() { return server_; }
 
@@ -98,7 +106,14 @@ class ConfigReader : public config::Reader {
     return config::Reader::GetMonitor(monitor_name);
   }
 
+  bool LoadFromSnapshot(std::string const& snapshot_path) {
+    return config::Reader::LoadFromSnapshot(snapshot_path);
+  }
+
   bool LoadFromFile(std::string const& path) {
+    if (read_files_) {
+      return config::Reader::LoadFromFile(path);
+    }
     // Doesn't actually load any files, but that's ok.
     // This is only used for testing. Test cases below which need to parse some
     // configuration will manually instantiate a new Parser.
@@ -108,6 +123,7 @@ class ConfigReader : public config::Reader {
 
  private:
   MockServer server_;
+  bool read_files_;
   std::set<std::string> loaded_files_;
 };
 
@@ -651,6 +667,7 @@ execp_dwheel_command = /bin/true
 execp_interval = 0
 execp_lclick_command = /bin/true
 execp_mclick_command = /bin/true
+execp_persistent = 1
 execp_rclick_command = /bin/true
 execp_tooltip = o hai
 execp_uwheel_command = /bin/true
@@ -720,9 +737,11 @@ TEST_CASE("ConfigParserExecp") {
     // first, single-shot executor
     REQUIRE(executors[0].command() == "/bin/true");
     REQUIRE_FALSE(executors[0].continuous());
+    REQUIRE(executors[0].persistent());
     // second, continuous executor
     REQUIRE(executors[1].command() == "/bin/false");
     REQUIRE(executors[1].continuous());
+    REQUIRE_FALSE(executors[1].persistent());
   }
 
   SECTION("bogus new") {
@@ -745,3 +764,141 @@ TEST_CASE("ConfigParserExecp") {
 
   CleanupPanel();  // TODO: decouple from config loading
 }
+
+namespace {
+
+// Legacy configuration files (without panel_items) exercise FinishFile(),
+// which puts the taskbar first at the end of every file, imports included.
+constexpr char kSnapshotMainFile[] =
+    u8R"EOF(
+systray = 1
+@import $TINT3_TEST_IMPORT
+task_text = 0
+)EOF";
+
+struct SnapshotState {
+  std::string items_order;
+  bool systray_enabled;
+  std::string time1_format;
+  bool task_text;
+
+  bool operator==(SnapshotState const& other) const {
+    return items_order == other.items_order &&
+           systray_enabled == other.systray_enabled &&
+           time1_format == other.time1_format && task_text == other.task_text;
+  }
+};
+
+void ResetSnapshotState() {
+  DefaultPanel();  // TODO: decouple from config loading
+  DefaultClock();  // TODO: decouple from config loading
+  new_panel_config.items_order.clear();
+  systray_enabled = false;
+}
+
+SnapshotState GetSnapshotState() {
+  return SnapshotState{new_panel_config.items_order, systray_enabled,
+                       time1_format, panel_config.g_task.text};
+}
+
+}  // namespace
+
+TEST_CASE("ConfigReaderSnapshots") {
+  TemporaryDirectory config_dir;
+  TemporaryDirectory cache_dir;
+  auto cache_home = environment::MakeScopedOverride<std::string>(
+      "XDG_CACHE_HOME", cache_dir.path());
+
+  std::string main_path{config_dir.path() / "tint3rc"};
+  std::string first_import{config_dir.path() / "first.tint3rc"};
+  std::string second_import{config_dir.path() / "second.tint3rc"};
+  REQUIRE(util::fs::WriteFile(main_path, kSnapshotMainFile));
+  REQUIRE(util::fs::WriteFile(first_import, "time1_format = %H:%M\n"));
+  REQUIRE(util::fs::WriteFile(second_import, "time1_format = %H\n"));
+  std::string snapshot_path{config::Snapshot::PathFor(main_path)};
+
+  auto import = environment::MakeScopedOverride("TINT3_TEST_IMPORT",
+                                                first_import);
+  ResetSnapshotState();
+  REQUIRE(test::ConfigReader{true}.LoadFromFile(main_path));
+  SnapshotState parsed = GetSnapshotState();
+  REQUIRE(parsed.items_order == "TTSC");
+  REQUIRE(parsed.systray_enabled);
+  REQUIRE(parsed.time1_format == "%H:%M");
+  REQUIRE_FALSE(parsed.task_text);
+  REQUIRE(util::fs::FileExists(snapshot_path));
+
+  SECTION("replaying the snapshot gives the same configuration") {
+    ResetSnapshotState();
+    REQUIRE(test::ConfigReader{true}.LoadFromSnapshot(snapshot_path));
+    REQUIRE(GetSnapshotState() == parsed);
+
+    ResetSnapshotState();
+    REQUIRE(test::ConfigReader{true}.LoadFromFile(main_path));
+    REQUIRE(GetSnapshotState() == parsed);
+  }
+
+  SECTION("imports resolving differently force a new parse") {
+    auto other_import = environment::MakeScopedOverride("TINT3_TEST_IMPORT",
+                                                        second_import);
+    ResetSnapshotState();
+    REQUIRE_FALSE(test::ConfigReader{true}.LoadFromSnapshot(snapshot_path));
+
+    ResetSnapshotState();
+    REQUIRE(test::ConfigReader{true}.LoadFromFile(main_path));
+    REQUIRE(time1_format == "%H");
+    // The snapshot was stored again, for the new import.
+    REQUIRE(test::ConfigReader{true}.LoadFromSnapshot(snapshot_path));
+  }
+
+  SECTION("failed imports prevent storing a snapshot") {
+    REQUIRE(util::fs::Unlink(snapshot_path));
+    auto missing_import = environment::MakeScopedOverride(
+        "TINT3_TEST_IMPORT", std::string{"missing.tint3rc"});
+    ResetSnapshotState();
+    REQUIRE(test::ConfigReader{true}.LoadFromFile(main_path));
+    REQUIRE_FALSE(util::fs::FileExists(snapshot_path));
+  }
+
+  ResetSnapshotState();
+  CleanupPanel();  // TODO: decouple from config loading
+}
+
+TEST_CASE("ConfigParserBenchmark", "[.][benchmark]") {
+  // Parses all the sample configuration files.
+  static const std::string kSamplesPath{"sample"};
+  std::vector<std::pair<std::string, std::string>> samples;
+  for (auto const& name : util::fs::DirectoryContents{kSamplesPath}) {
+    std::string path{util::fs::Path{kSamplesPath} / name};
+    std::string contents;
+    if (!name.empty() && util::fs::ReadFile(path, &contents)) {
+      samples.emplace_back(path, contents);
+    }
+  }
+  REQUIRE_FALSE(samples.empty());
+
+  static constexpr int kRounds = 100;
+  test::ostream_capture error_output{&std::cerr};
+  std::chrono::steady_clock::duration elapsed{0};
+  for (int i = 0; i < kRounds; ++i) {
+    for (auto const& sample : samples) {
+      DefaultPanel();  // TODO: decouple from config loading
+      test::ConfigReader reader;
+      config::Parser config_entry_parser{&reader, sample.first};
+      parser::Parser p{config::kLexer, &config_entry_parser};
+
+      auto start = std::chrono::steady_clock::now();
+      p.Parse(sample.second);
+      elapsed += (std::chrono::steady_clock::now() - start);
+
+      CleanupPanel();  // TODO: decouple from config loading
+    }
+  }
+
+  std::cout << samples.size() << " configuration files from " << kSamplesPath
+            << ": "
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                       .count() /
+                   static_cast<double>(kRounds * samples.size())
+            << " us/file\n";
+}
@@ -1,11 +1,31 @@
+#include <fcntl.h>
 #include <pango/pangocairo.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 #include "execp/execp.hh"
 #include "panel.hh"
+#include "server.hh"
 #include "subprocess.hh"
 #include "util/common.hh"
-#include "util/environment.hh"
 #include "util/log.hh"
+#include "util/raster_cache.hh"
 #include "util/window.hh"
 
 Executor::Executor() { size_mode_ = SizeMode::kByContent; }
@@ -19,6 +39,70 @@ void Executor::InitPanel(Panel* panel) {
 
 namespace {
 
+// Commands printing more than this are cut short, rather than having their
+// output pile up in memory.
+constexpr size_t kMaximumOutputSize = (64 << 10);  // 64 KiB
+
+void GetIconSize(Imlib_Image icon, int* width, int* height) {
+  *width = 0;
+  *height = 0;
+  if (icon) {
+    imlib_context_set_image(icon);
+    *width = imlib_image_get_width();
+    *height = imlib_image_get_height();
+  }
+}
+
+// Decodes the icon and scales it to the given size. Either dimension (or
+// both) may be left to the icon, keeping its aspect ratio. With a key, the
+// result comes from the raster cache when possible, and is stored there
+// otherwise.
+util::imlib2::Image LoadIcon(std::string const& path, unsigned int width,
+                             unsigned int height, std::string const& key) {
+  util::RasterCache::Raster raster;
+  if (!key.empty() && util::IconRasterCache().Load(key, &raster)) {
+    util::imlib2::Image icon{util::imlib2::Image::FromPixels(
+        raster.width(), raster.height(),
+        reinterpret_cast<DATA32 const*>(raster.pixels()))};
+    if (icon) {
+      return icon;
+    }
+  }
+
+  util::imlib2::Image original{imlib_load_image(path.c_str())};
+  if (!original) {
+    util::log::Debug() << "Couldn't load execp icon \"" << path << "\"\n";
+    return {};
+  }
+
+  int original_width, original_height;
+  GetIconSize(original, &original_width, &original_height);
+  int icon_width = (width > 0) ? width : original_width;
+  int icon_height = (height > 0) ? height : original_height;
+  if (width > 0 && height == 0) {
+    icon_height = std::max(1, original_height * icon_width / original_width);
+  } else if (height > 0 && width == 0) {
+    icon_width = std::max(1, original_width * icon_height / original_height);
+  }
+
+  imlib_context_set_image(original);
+  util::imlib2::Image icon{imlib_create_cropped_scaled_image(
+      0, 0, original_width, original_height, icon_width, icon_height)};
+  if (!icon) {
+    return {};
+  }
+  imlib_context_set_image(icon);
+  imlib_image_set_has_alpha(1);
+
+  if (!key.empty()) {
+    static_assert(sizeof(DATA32) == sizeof(uint32_t), "unexpected DATA32 size");
+    util::IconRasterCache().Store(key, icon_width, icon_height,
+                                  reinterpret_cast<uint32_t const*>(
+                                      imlib_image_get_data_for_reading_only()));
+  }
+  return icon;
+}
+
 inline MarkupTag markup_tag(bool has_markup) {
   if (has_markup) {
     return MarkupTag::kHasMarkup;
@@ -31,36 +115,55 @@ inline MarkupTag markup_tag(bool has_markup) {
 
 bool Executor::Resize() {
   int text_width, text_height;
-  GetTextSize(font_description_, command_, markup_tag(markup_), &text_width,
+  GetTextSize(font_description_, output_, markup_tag(markup_), &text_width,
               &text_height);
 
-  width_ = text_width;
-  height_ = text_height;
+  int icon_width, icon_height;
+  GetIconSize(icon_, &icon_width, &icon_height);
+
+  width_ = icon_width + text_width;
+  if (icon_width > 0 && text_width > 0) {
+    width_ += padding_x_;
+  }
+  height_ = std::max(icon_height, text_height);
   need_redraw_ = true;
   return false;
 }
 
 void Executor::DrawForeground(cairo_t* c) {
+  Border b = bg_.border();
+  const int w = b.width();
+
+  // The icon goes first, the text next to it.
+  int text_x = 0;
+  if (icon_) {
+    int icon_width, icon_height;
+    GetIconSize(icon_, &icon_width, &icon_height);
+    RenderImage(&server, pix_, icon_, w,
+                (static_cast<int>(height_) - icon_height) / 2);
+    text_x = icon_width + padding_x_;
+  }
+
   cairo_set_source_rgba(c, font_color_[0], font_color_[1], font_color_[2],
                         font_color_.alpha());
 
   util::GObjectPtr<PangoLayout> layout(pango_cairo_create_layout(c));
   pango_layout_set_font_description(layout.get(), font_description_());
   if (markup_) {
-    pango_layout_set_markup(layout.get(), command_.c_str(), -1);
+    pango_layout_set_markup(layout.get(), output_.c_str(), -1);
   } else {
-    pango_layout_set_text(layout.get(), command_.c_str(), -1);
+    pango_layout_set_text(layout.get(), output_.c_str(), -1);
   }
 
   PangoRectangle r1;
   pango_layout_get_pixel_extents(layout.get(), &r1, nullptr);
-  pango_layout_set_width(layout.get(), width_ * PANGO_SCALE);
+  pango_layout_set_width(layout.get(),
+                         std::max(0, static_cast<int>(width_) - text_x) *
+                             PANGO_SCALE);
   pango_layout_set_height(layout.get(), height_ * PANGO_SCALE);
   pango_layout_set_ellipsize(layout.get(), PANGO_ELLIPSIZE_END);
 
-  Border b = bg_.border();
-  const int w = b.width();
-  cairo_move_to(c, -r1.x / 2 + w, -r1.y / 2 + w);
+  cairo_move_to(c, text_x - r1.x / 2 + w, -r1.y / 2 + w);
   pango_cairo_show_layout(c, layout.get());
 }
 
@@ -72,6 +175,290 @@ std::string Executor::GetTooltipText() {
   return {};
 }
 
+void Executor::Start(Timer* timer, Watcher* watcher) {
+  Stop();
+
+  timer_ = timer;
+  watcher_ = watcher;
+  Run();
+
+  if (interval_ > 0) {
+    interval_id_ = timer_->SetInterval(absl::Seconds(interval_), [this] {
+      Run();
+      return true;
+    });
+  }
+}
+
+void Executor::Stop() {
+  if (interval_id_) {
+    timer_->ClearInterval(interval_id_);
+    interval_id_.reset();
+  }
+
+  StopHelper();
+
+  if (output_fd_ != -1) {
+    // Commands are started as session (and process group) leaders, so this
+    // terminates whatever they started too.
+    if (child_pid_ > 0) {
+      kill(-child_pid_, SIGTERM);
+    }
+    CloseOutput();
+  }
+}
+
+std::string const& Executor::output() const { return output_; }
+
+util::imlib2::Image const& Executor::icon() const { return icon_; }
+
+void Executor::Run() {
+  if (command_.empty()) {
+    return;
+  }
+  // Continuous commands are only ever run once, nothing to save there.
+  if (persistent_ && !continuous_) {
+    RunInHelper();
+    return;
+  }
+  // Still running from the previous interval.
+  if (output_fd_ != -1) {
+    return;
+  }
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    util::log::Error() << "pipe2: " << std::strerror(errno) << '\n';
+    return;
+  }
+
+  // Only the read end is non-blocking: the command shouldn't have to deal
+  // with EAGAIN when writing to its standard output.
+  pid_t child_pid = ShellExec(command_, stdout_fd{fds[1]});
+  close(fds[1]);
+
+  int flags = fcntl(fds[0], F_GETFL);
+  if (child_pid <= 0 || flags == -1 ||
+      fcntl(fds[0], F_SETFL, flags | O_NONBLOCK) == -1) {
+    close(fds[0]);
+    return;
+  }
+
+  child_pid_ = child_pid;
+  output_fd_ = fds[0];
+  pending_output_.clear();
+  watcher_->Watch(output_fd_, [this] { ReadOutput(); });
+}
+
+void Executor::ReadOutput() {
+  if (output_fd_ == -1) {
+    return;
+  }
+
+  // In continuous mode, only the last of the lines read in one go is worth
+  // displaying.
+  bool has_line = false;
+  util::LineReader::Result result = line_reader_.Read(
+      output_fd_, [this, &has_line](absl::string_view line) {
+        if (continuous_) {
+          last_line_.assign(line.data(), line.size());
+          has_line = true;
+        } else if (pending_output_.size() < kMaximumOutputSize) {
+          size_t room = (kMaximumOutputSize - pending_output_.size());
+          pending_output_.append(line.data(), std::min(line.size(), room));
+          pending_output_.push_back('\n');
+        }
+      });
+
+  if (has_line) {
+    SetOutput(last_line_);
+  }
+  if (result == util::LineReader::Result::kAgain) {
+    return;
+  }
+
+  // End of file (or an error, which is just as final).
+  if (!continuous_) {
+    SetOutput(std::string{absl::StripTrailingAsciiWhitespace(
+        absl::string_view{pending_output_})});
+  }
+  CloseOutput();
+}
+
+void Executor::CloseOutput() {
+  watcher_->Unwatch(output_fd_);
+  close(output_fd_);
+  output_fd_ = -1;
+  // The event loop reaps it.
+  child_pid_ = -1;
+  line_reader_.Clear();
+  pending_output_.clear();
+}
+
+void Executor::SetOutput(std::string const& output) {
+  absl::string_view text{output};
+  if (has_icon_) {
+    // The first line names the icon, the others are displayed next to it.
+    size_t end = text.find('\n');
+    SetIcon(std::string{absl::StripAsciiWhitespace(text.substr(0, end))});
+    text = (end != absl::string_view::npos) ? text.substr(end + 1)
+                                            : absl::string_view{};
+  }
+
+  // Most commands print the same thing most of the time: don't bother
+  // redrawing anything then.
+  if (text == output_) {
+    return;
+  }
+  output_.assign(text.data(), text.size());
+  need_resize_ = true;
+  panel_refresh = true;
+}
+
+void Executor::SetIcon(std::string const& path) {
+  // The icon is only loaded again once the command names another file, or
+  // the file changes. With execp_cache_icon, it's then read from the raster
+  // cache when possible.
+  std::string key;
+  if (!path.empty()) {
+    util::RasterCache::MakeKey(
+        path, absl::StrCat(icon_width_, "x", icon_height_), &key);
+  }
+  if (key == icon_key_) {
+    return;
+  }
+  icon_key_ = key;
+
+  bool had_icon = icon_;
+  icon_ = key.empty() ? util::imlib2::Image{}
+                      : LoadIcon(path, icon_width_, icon_height_,
+                                 cache_icon_ ? key : std::string{});
+  if (!had_icon && !icon_) {
+    return;
+  }
+  need_resize_ = true;
+  panel_refresh = true;
+}
+
+bool Executor::StartHelper() {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+    util::log::Error() << "socketpair: " << std::strerror(errno) << '\n';
+    return false;
+  }
+
+  auto sp = make_subprocess("/bin/sh", session_leader{true}, stdin_fd{fds[1]},
+                            stdout_fd{fds[1]});
+  pid_t helper_pid = sp.start();
+  close(fds[1]);
+
+  int flags = fcntl(fds[0], F_GETFL);
+  if (helper_pid <= 0 || flags == -1 ||
+      fcntl(fds[0], F_SETFL, flags | O_NONBLOCK) == -1) {
+    close(fds[0]);
+    return false;
+  }
+
+  // Tells the end of the output of a command (and its exit status) from the
+  // output itself.
+  std::random_device random;
+  helper_marker_ = absl::StrCat("tint3-execp-", absl::Hex(random()),
+                                absl::Hex(random()), " ");
+
+  helper_pid_ = helper_pid;
+  helper_fd_ = fds[0];
+  helper_busy_ = false;
+  line_reader_.Clear();
+  pending_output_.clear();
+  watcher_->Watch(helper_fd_, [this] { ReadHelperOutput(); });
+  return true;
+}
+
+void Executor::RunInHelper() {
+  // Still running from the previous interval.
+  if (helper_busy_) {
+    return;
+  }
+  if (helper_fd_ == -1 && !StartHelper()) {
+    return;
+  }
+
+  // Each command runs in a subshell, which the helper merely forks instead of
+  // executing a new shell: cd, variables, options (e.g. set -e), traps,
+  // functions and exit don't carry over from one run to the next, just like
+  // without a helper. Going through eval keeps invalid commands from taking the
+  // helper down, and the command can't read the next requests either.
+  std::string request = absl::StrCat(
+      "(eval '", absl::StrReplaceAll(command_, {{"'", "'\\''"}}),
+      "') </dev/null; printf '\\n%s%d\\n' '", helper_marker_, "' \"$?\"\n");
+  ssize_t sent = send(helper_fd_, request.data(), request.size(), MSG_NOSIGNAL);
+  if (sent != static_cast<ssize_t>(request.size())) {
+    // The helper is gone (or stuck): start over on the next run.
+    StopHelper();
+    return;
+  }
+  helper_busy_ = true;
+}
+
+void Executor::ReadHelperOutput() {
+  if (helper_fd_ == -1) {
+    return;
+  }
+
+  util::LineReader::Result result = line_reader_.Read(
+      helper_fd_, [this](absl::string_view line) {
+        if (!absl::StartsWith(line, helper_marker_)) {
+          if (pending_output_.size() < kMaximumOutputSize) {
+            size_t room = (kMaximumOutputSize - pending_output_.size());
+            pending_output_.append(line.data(), std::min(line.size(), room));
+            pending_output_.push_back('\n');
+          }
+          return;
+        }
+
+        int status;
+        line.remove_prefix(helper_marker_.size());
+        if (absl::SimpleAtoi(line, &status) && status != 0) {
+          util::log::Debug() << "execp command \"" << command_
+                             << "\" exited with status " << status << '\n';
+        }
+        SetOutput(std::string{absl::StripTrailingAsciiWhitespace(
+            absl::string_view{pending_output_})});
+        pending_output_.clear();
+        helper_busy_ = false;
+      });
+
+  if (result != util::LineReader::Result::kAgain) {
+    // The helper is gone, e.g. the command called "exit": another one is
+    // started on the next run.
+    if (helper_busy_) {
+      SetOutput(std::string{absl::StripTrailingAsciiWhitespace(
+          absl::string_view{pending_output_})});
+    }
+    StopHelper();
+  }
+}
+
+void Executor::StopHelper() {
+  if (helper_fd_ == -1) {
+    return;
+  }
+
+  // The helper exits once there's nothing left to read, unless it's still
+  // busy running a command.
+  if (helper_busy_ && helper_pid_ > 0) {
+    kill(-helper_pid_, SIGTERM);
+  }
+  watcher_->Unwatch(helper_fd_);
+  close(helper_fd_);
+  helper_fd_ = -1;
+  // The event loop reaps it.
+  helper_pid_ = -1;
+  helper_busy_ = false;
+  line_reader_.Clear();
+  pending_output_.clear();
+}
+
 void Executor::set_cache_icon(bool cache_icon) { cache_icon_ = cache_icon; }
 
 void Executor::set_centered(bool centered) { centered_ = centered; }
@@ -128,6 +515,10 @@ void Executor::set_interval(unsigned int interval) { interval_ = interval; }
 
 void Executor::set_markup(bool markup) { markup_ = markup; }
 
+bool Executor::persistent() const { return persistent_; }
+
+void Executor::set_persistent(bool persistent) { persistent_ = persistent; }
+
 void Executor::set_tooltip(std::string const& tooltip) {
   tooltip_ = tooltip;
   has_tooltip_ = true;
@@ -157,11 +548,12 @@ bool Executor::OnClick(XEvent* event) {
       &command_up_wheel_,   &command_down_wheel_,
   };
 
-  pid_t child_pid = ShellExec(*commands[button - 1], child_callback{[&] {
-    environment::Set("EXECP_X", event->xbutton.x);
-    environment::Set("EXECP_Y", event->xbutton.y);
-    environment::Set("EXECP_W", width_);
-    environment::Set("EXECP_H", height_);
-  }});
+  pid_t child_pid = ShellExec(*commands[button - 1],
+                              environment_overrides{{
+                                  {"EXECP_X", std::to_string(event->xbutton.x)},
+                                  {"EXECP_Y", std::to_string(event->xbutton.y)},
+                                  {"EXECP_W", std::to_string(width_)},
+                                  {"EXECP_H", std::to_string(height_)},
+                              }});
   return (child_pid > 0);
 }
@@ -1,20 +1,53 @@
 #ifndef TINT3_EXECP_EXECP_HH
 #define TINT3_EXECP_EXECP_HH
 
+#include <sys/types.h>
+
+#include <functional>
 #include <memory>
 #include <string>
 
 #include "util/area.hh"
 #include "util/color.hh"
+#include "util/imlib2.hh"
+#include "util/line_reader.hh"
 #include "util/pango.hh"
+#include "util/timer.hh"
 
 class Panel;
 class Executor : public Area {
  public:
+  // Watches file descriptors for readability on behalf of executors. In
+  // tint3, this is the event loop.
+  class Watcher {
+   public:
+    virtual ~Watcher() = default;
+    virtual void Watch(int fd, std::function<void()> handler) = 0;
+    virtual void Unwatch(int fd) = 0;
+  };
+
   Executor();
 
   void InitPanel(Panel* panel);
 
+  // Runs the command right away, and then every interval (unless it's still
+  // running by then). Its output is read as it comes, without ever blocking:
+  // by lines in continuous mode, or whole once the command is done otherwise.
+  //
+  // In persistent mode, the command is run by a helper shell started once
+  // and kept around, rather than by a new shell every time. Every run still
+  // starts from a clean state, in a subshell of the helper.
+  //
+  // Executors must not be copied or moved once started.
+  void Start(Timer* timer, Watcher* watcher);
+  // Stops running the command, terminating it if it's still running.
+  void Stop();
+
+  // What the command last printed, as displayed.
+  std::string const& output() const;
+  // The icon named by the first line of the output, with execp_has_icon.
+  util::imlib2::Image const& icon() const;
+
   std::string GetTooltipText() override;
   void DrawForeground(cairo_t* c) override;
   bool Resize() override;
@@ -46,6 +79,9 @@ class Executor : public Area {
   unsigned int interval() const;
   void set_interval(unsigned int interval);
 
+  bool persistent() const;
+  void set_persistent(bool persistent);
+
   void set_markup(bool continuous);
   void set_tooltip(std::string const& tooltip);
 
@@ -70,8 +106,41 @@ class Executor : public Area {
   unsigned int icon_width_ = 0;
   unsigned int interval_ = 0;
   bool markup_ = false;
+  bool persistent_ = false;
   bool has_tooltip_ = false;
   std::string tooltip_;
+
+  Timer* timer_ = nullptr;
+  Watcher* watcher_ = nullptr;
+  Interval::Id interval_id_;
+  pid_t child_pid_ = -1;
+  int output_fd_ = -1;
+  util::LineReader line_reader_;
+  std::string last_line_;
+  std::string pending_output_;
+  std::string output_;
+  util::imlib2::Image icon_;
+  // Identifies the icon file (and its modification time and size) icon_ was
+  // last loaded from, even if that failed.
+  std::string icon_key_;
+
+  // The helper shell of persistent mode reads commands from (and writes
+  // their output to) the other end of a socket pair.
+  pid_t helper_pid_ = -1;
+  int helper_fd_ = -1;
+  bool helper_busy_ = false;
+  std::string helper_marker_;
+
+  void Run();
+  void ReadOutput();
+  void CloseOutput();
+  void SetOutput(std::string const& output);
+  void SetIcon(std::string const& path);
+
+  bool StartHelper();
+  void RunInHelper();
+  void ReadHelperOutput();
+  void StopHelper();
 };
 
 #endif  // TINT3_EXECP_EXECP_HH
@@ -1,6 +1,67 @@
 #include "catch.hpp"
 
+#include <Imlib2.h>
+#include <poll.h>
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+
 #include "execp/execp.hh"
+#include "util/environment.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+#include "util/timer.hh"
+
+namespace {
+
+class FakeWatcher : public Executor::Watcher {
+ public:
+  void Watch(int fd, std::function<void()> handler) override {
+    handlers_[fd] = handler;
+  }
+
+  void Unwatch(int fd) override { handlers_.erase(fd); }
+
+  bool empty() const { return handlers_.empty(); }
+
+  // Runs the handler of a watched descriptor once it's readable, like the
+  // event loop would. Returns false if there is none, or nothing happened
+  // for a while.
+  bool RunOnce() {
+    if (handlers_.empty()) {
+      return false;
+    }
+    int fd = handlers_.begin()->first;
+    struct pollfd poll_fd = {fd, POLLIN, 0};
+    if (poll(&poll_fd, 1, 5000) != 1) {
+      return false;
+    }
+    std::function<void()> handler{handlers_.begin()->second};
+    handler();
+    return true;
+  }
+
+  void RunUntilIdle() {
+    while (RunOnce()) {
+    }
+  }
+
+  // Helper shells are watched for as long as they run.
+  template <typename Predicate>
+  void RunUntil(Predicate predicate) {
+    while (!predicate() && RunOnce()) {
+    }
+  }
+
+ private:
+  std::map<int, std::function<void()>> handlers_;
+};
+
+}  // namespace
 
 TEST_CASE("GetTooltipText") {
   SECTION("no tooltip provided") {
@@ -20,3 +81,206 @@ TEST_CASE("GetTooltipText") {
     REQUIRE(e.GetTooltipText() == "something");
   }
 }
+
+TEST_CASE("Executor") {
+  absl::Time now = absl::FromUnixSeconds(1000000);
+  Timer timer{[&now] { return now; }};
+  FakeWatcher watcher;
+
+  SECTION("the output of commands is displayed") {
+    Executor e;
+    e.set_command("echo hello; echo world");
+    e.Start(&timer, &watcher);
+    REQUIRE_FALSE(watcher.empty());
+    watcher.RunUntilIdle();
+    REQUIRE(watcher.empty());
+    REQUIRE(e.output() == "hello\nworld");
+    e.Stop();
+  }
+
+  SECTION("commands are run again on their interval") {
+    TemporaryDirectory temp_dir;
+    std::string counter{temp_dir.path() / "counter"};
+
+    Executor e;
+    e.set_command("printf x >> '" + counter + "'; wc -c < '" + counter + "'");
+    e.set_interval(5);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "1");
+
+    now += absl::Seconds(5);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "2");
+
+    e.Stop();
+    now += absl::Seconds(5);
+    timer.ProcessExpiredIntervals();
+    REQUIRE(watcher.empty());
+    REQUIRE(e.output() == "2");
+  }
+
+  SECTION("unchanged output doesn't need a resize") {
+    Executor e;
+    e.set_command("echo same");
+    e.set_interval(1);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "same");
+    REQUIRE(e.need_resize_);
+
+    e.need_resize_ = false;
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "same");
+    REQUIRE_FALSE(e.need_resize_);
+    e.Stop();
+  }
+
+  SECTION("continuous commands display their last line") {
+    Executor e;
+    e.set_command("echo one; echo two; printf three");
+    e.set_continuous(1);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "three");
+    e.Stop();
+  }
+
+  SECTION("running commands are terminated when stopped") {
+    Executor e;
+    e.set_command("echo started; exec sleep 60");
+    e.set_continuous(1);
+    e.Start(&timer, &watcher);
+
+    // Wait for the first line, but not for the end of the command.
+    while (e.output().empty() && watcher.RunOnce()) {
+    }
+    REQUIRE(e.output() == "started");
+    REQUIRE_FALSE(watcher.empty());
+    e.Stop();
+    REQUIRE(watcher.empty());
+  }
+
+  SECTION("persistent commands are run by a helper shell") {
+    Executor e;
+    e.set_command("echo $$");
+    e.set_interval(1);
+    e.set_persistent(true);
+    e.Start(&timer, &watcher);
+    watcher.RunUntil([&e] { return !e.output().empty(); });
+    std::string helper_pid = e.output();
+    REQUIRE_FALSE(helper_pid.empty());
+
+    // Same shell, and not stuck on a bad command either.
+    e.set_command("echo 'unterminated");
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntil([&e] { return e.output().empty(); });
+    REQUIRE(e.output().empty());
+
+    e.set_command("echo $$; echo it\\'s $(( 6 * 7 ))");
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntil([&e] { return !e.output().empty(); });
+    REQUIRE(e.output() == helper_pid + "\nit's 42");
+
+    e.Stop();
+    REQUIRE(watcher.empty());
+  }
+
+  SECTION("persistent commands don't share any state") {
+    Executor e;
+    e.set_command(
+        "echo $$ ${x:-unset} $(pwd); x=set; cd /; f() { :; }; set -eu; "
+        "trap 'echo trapped' EXIT; exit 1");
+    e.set_interval(1);
+    e.set_persistent(true);
+    e.Start(&timer, &watcher);
+    watcher.RunUntil([&e] { return !e.output().empty(); });
+    std::string first_output = e.output();
+    REQUIRE(first_output.find(" unset ") != std::string::npos);
+
+    // Same helper, same state as the first time around.
+    e.set_command("echo again; " + e.command());
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntil([&e] { return absl::StartsWith(e.output(), "again"); });
+    REQUIRE(e.output() == "again\n" + first_output);
+    e.Stop();
+  }
+
+  SECTION("persistent helpers are restarted once gone") {
+    Executor e;
+    e.set_command("echo $$; kill -KILL $$");
+    e.set_interval(1);
+    e.set_persistent(true);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    std::string first_helper_pid = e.output();
+    REQUIRE_FALSE(first_helper_pid.empty());
+
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE_FALSE(e.output().empty());
+    REQUIRE(e.output() != first_helper_pid);
+    e.Stop();
+  }
+
+  SECTION("the first line of the output names the icon") {
+    TemporaryDirectory cache_dir;
+    auto cache_home = environment::MakeScopedOverride<std::string>(
+        "XDG_CACHE_HOME", cache_dir.path());
+
+    Executor e;
+    e.set_command(
+        "echo src/launcher/testdata/.icons/unit-test-unthemed.png; "
+        "echo text");
+    e.set_interval(1);
+    e.set_has_icon(true);
+    e.set_cache_icon(true);
+    e.set_icon_width(8);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    REQUIRE(e.output() == "text");
+    REQUIRE(e.icon() != nullptr);
+    imlib_context_set_image(e.icon());
+    REQUIRE(imlib_image_get_width() == 8);
+    REQUIRE(imlib_image_get_height() == 8);
+
+    // Same file, unchanged: it isn't loaded again.
+    Imlib_Image icon = e.icon();
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE(e.icon() == icon);
+
+    e.set_command("echo /nonexistent.png");
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE(e.output().empty());
+    REQUIRE(e.icon() == nullptr);
+    e.Stop();
+  }
+
+  SECTION("unchanged icons aren't loaded again without the raster cache") {
+    Executor e;
+    e.set_command("echo src/launcher/testdata/.icons/unit-test-unthemed.png");
+    e.set_interval(1);
+    e.set_has_icon(true);
+    e.Start(&timer, &watcher);
+    watcher.RunUntilIdle();
+    Imlib_Image icon = e.icon();
+    REQUIRE(icon != nullptr);
+
+    now += absl::Seconds(1);
+    timer.ProcessExpiredIntervals();
+    watcher.RunUntilIdle();
+    REQUIRE(e.icon() == icon);
+    e.Stop();
+  }
+}
@@ -0,0 +1,169 @@
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "absl/strings/match.h"
+
+#include "launcher/application_index.hh"
+#include "util/fs.hh"
+
+namespace {
+
+// Guards against symbolic links pointing back to a parent directory.
+constexpr unsigned int kMaxDepth = 8;
+
+}  // namespace
+
+void ApplicationIndex::Build(std::vector<std::string> const& directories) {
+  Clear();
+  directories_ = directories;
+  for (unsigned int i = 0; i < directories_.size(); ++i) {
+    AddDirectory(IndexedDirectory{directories_[i], i, "", 0});
+  }
+}
+
+void ApplicationIndex::Clear() {
+  directories_.clear();
+  indexed_directories_.clear();
+  entries_.clear();
+}
+
+bool ApplicationIndex::Update(std::string const& directory,
+                              std::string const& name) {
+  auto it = std::find_if(
+      indexed_directories_.begin(), indexed_directories_.end(),
+      [&](IndexedDirectory const& item) { return item.path == directory; });
+  if (it == indexed_directories_.end() || name.empty()) {
+    return false;
+  }
+  IndexedDirectory parent{*it};
+
+  std::string path{util::fs::Path{directory} / name};
+  if (absl::EndsWith(name, ".desktop")) {
+    std::string id{parent.id_prefix + name};
+    RemoveEntry(id, path);
+    if (util::fs::FileExists(path)) {
+      AddEntry(id, Entry{parent.root, path});
+    }
+    return false;
+  }
+
+  // Possibly a subdirectory, either gone or new.
+  bool removed = RemoveDirectory(path);
+  struct stat info;
+  if (parent.depth < kMaxDepth && util::fs::Stat(path, &info) &&
+      S_ISDIR(info.st_mode)) {
+    AddDirectory(IndexedDirectory{path, parent.root,
+                                  parent.id_prefix + name + "-",
+                                  parent.depth + 1});
+    return true;
+  }
+  return removed;
+}
+
+std::vector<std::string> const& ApplicationIndex::directories() const {
+  return directories_;
+}
+
+std::vector<ApplicationIndex::IndexedDirectory> const&
+ApplicationIndex::indexed_directories() const {
+  return indexed_directories_;
+}
+
+bool ApplicationIndex::Find(absl::string_view desktop_file_id,
+                            std::string* path) const {
+  std::string key{desktop_file_id};
+  std::replace(key.begin(), key.end(), '/', '-');
+
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  path->assign(it->second.front().path);
+  return true;
+}
+
+void ApplicationIndex::AddDirectory(IndexedDirectory const& directory) {
+  if (!util::fs::DirectoryExists(directory.path)) {
+    return;
+  }
+  indexed_directories_.push_back(directory);
+
+  for (auto const& name : util::fs::DirectoryContents{directory.path}) {
+    if (name.empty() || name == "." || name == "..") {
+      continue;
+    }
+
+    std::string path{util::fs::Path{directory.path} / name};
+    if (absl::EndsWith(name, ".desktop")) {
+      AddEntry(directory.id_prefix + name, Entry{directory.root, path});
+      continue;
+    }
+
+    struct stat info;
+    if (directory.depth < kMaxDepth && util::fs::Stat(path, &info) &&
+        S_ISDIR(info.st_mode)) {
+      AddDirectory(IndexedDirectory{path, directory.root,
+                                    directory.id_prefix + name + "-",
+                                    directory.depth + 1});
+    }
+  }
+}
+
+bool ApplicationIndex::RemoveDirectory(std::string const& path) {
+  std::string prefix{path + "/"};
+  auto is_inside = [&](std::string const& item) {
+    return (item == path || absl::StartsWith(item, prefix));
+  };
+
+  auto removed = std::remove_if(
+      indexed_directories_.begin(), indexed_directories_.end(),
+      [&](IndexedDirectory const& item) { return is_inside(item.path); });
+  if (removed == indexed_directories_.end()) {
+    return false;
+  }
+  indexed_directories_.erase(removed, indexed_directories_.end());
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto& entries = it->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&](Entry const& entry) {
+                                   return is_inside(entry.path);
+                                 }),
+                  entries.end());
+    if (entries.empty()) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return true;
+}
+
+void ApplicationIndex::AddEntry(std::string const& id, Entry const& entry) {
+  // Entries from the same directory keep the order they were found in, the
+  // first one winning.
+  auto& entries = entries_[id];
+  entries.insert(std::upper_bound(entries.begin(), entries.end(), entry.root,
+                                  [](unsigned int root, Entry const& item) {
+                                    return root < item.root;
+                                  }),
+                 entry);
+}
+
+void ApplicationIndex::RemoveEntry(std::string const& id,
+                                   std::string const& path) {
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return;
+  }
+
+  auto& entries = it->second;
+  entries.erase(std::remove_if(
+                    entries.begin(), entries.end(),
+                    [&](Entry const& entry) { return entry.path == path; }),
+                entries.end());
+  if (entries.empty()) {
+    entries_.erase(it);
+  }
+}
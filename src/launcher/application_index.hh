@@ -0,0 +1,69 @@
+#ifndef TINT3_LAUNCHER_APPLICATION_INDEX_HH
+#define TINT3_LAUNCHER_APPLICATION_INDEX_HH
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+// Maps desktop file IDs to the desktop entries they refer to, built by listing
+// the application directories once instead of probing every candidate path
+// with stat().
+//
+// As per the Desktop Entry Specification, the ID of a desktop entry is its
+// path relative to the application directory it was found in, with slashes
+// replaced by dashes (so that "kde/foo.desktop" is known as
+// "kde-foo.desktop"), and entries in earlier directories take precedence over
+// those with the same ID in later ones.
+class ApplicationIndex {
+ public:
+  // A directory listed while building the index: one of the application
+  // directories, or one of their subdirectories.
+  struct IndexedDirectory {
+    std::string path;
+    // Index into the list of application directories.
+    unsigned int root;
+    // Prepended to the names of the entries found in this directory to make
+    // up their IDs.
+    std::string id_prefix;
+    unsigned int depth;
+  };
+
+  // Indexes the given application directories, by order of precedence.
+  // Missing directories are skipped.
+  void Build(std::vector<std::string> const& directories);
+  void Clear();
+
+  // Updates the index after the named entry of one of the indexed
+  // directories was created, changed or removed. Only the entries with the
+  // affected ID are touched, unless it's a subdirectory: returns true if
+  // indexed_directories() changed as a result.
+  bool Update(std::string const& directory, std::string const& name);
+
+  std::vector<std::string> const& directories() const;
+  std::vector<IndexedDirectory> const& indexed_directories() const;
+
+  // Looks up the desktop entry with the given ID. Slashes in the ID are
+  // treated as dashes, so that relative paths are found as well.
+  bool Find(absl::string_view desktop_file_id, std::string* path) const;
+
+ private:
+  struct Entry {
+    // Index into the list of application directories.
+    unsigned int root;
+    std::string path;
+  };
+
+  std::vector<std::string> directories_;
+  std::vector<IndexedDirectory> indexed_directories_;
+  // All the entries found for each ID, by order of precedence.
+  std::unordered_map<std::string, std::vector<Entry>> entries_;
+
+  void AddDirectory(IndexedDirectory const& directory);
+  bool RemoveDirectory(std::string const& path);
+  void AddEntry(std::string const& id, Entry const& entry);
+  void RemoveEntry(std::string const& id, std::string const& path);
+};
+
+#endif  // TINT3_LAUNCHER_APPLICATION_INDEX_HH
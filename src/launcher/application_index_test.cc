@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "launcher/application_index.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+TEST_CASE("ApplicationIndex") {
+  TemporaryDirectory temp_dir;
+  util::fs::Path first{temp_dir.path() / "first" / "applications"};
+  util::fs::Path second{temp_dir.path() / "second" / "applications"};
+  REQUIRE(util::fs::CreateDirectory(first / "kde"));
+  REQUIRE(util::fs::CreateDirectory(second));
+  REQUIRE(util::fs::WriteFile(first / "both.desktop", ""));
+  REQUIRE(util::fs::WriteFile(first / "kde" / "foo.desktop", ""));
+  REQUIRE(util::fs::WriteFile(first / "README", ""));
+  REQUIRE(util::fs::WriteFile(second / "both.desktop", ""));
+  REQUIRE(util::fs::WriteFile(second / "second.desktop", ""));
+
+  ApplicationIndex index;
+  index.Build({temp_dir.path() / "bogus_path", first, second});
+  std::string path;
+
+  SECTION("earlier directories take precedence") {
+    REQUIRE(index.Find("both.desktop", &path));
+    REQUIRE(path == std::string(first / "both.desktop"));
+    REQUIRE(index.Find("second.desktop", &path));
+    REQUIRE(path == std::string(second / "second.desktop"));
+  }
+
+  SECTION("subdirectories are prefixes") {
+    REQUIRE(index.Find("kde-foo.desktop", &path));
+    REQUIRE(path == std::string(first / "kde" / "foo.desktop"));
+    REQUIRE(index.Find("kde/foo.desktop", &path));
+    REQUIRE(path == std::string(first / "kde" / "foo.desktop"));
+    REQUIRE_FALSE(index.Find("foo.desktop", &path));
+  }
+
+  SECTION("only desktop entries are indexed") {
+    REQUIRE_FALSE(index.Find("README", &path));
+    REQUIRE_FALSE(index.Find("kde", &path));
+  }
+
+  SECTION("clear") {
+    index.Clear();
+    REQUIRE(index.directories().empty());
+    REQUIRE_FALSE(index.Find("both.desktop", &path));
+  }
+}
+
+TEST_CASE("ApplicationIndex::Update") {
+  TemporaryDirectory temp_dir;
+  util::fs::Path first{temp_dir.path() / "first"};
+  util::fs::Path second{temp_dir.path() / "second"};
+  REQUIRE(util::fs::CreateDirectory(first));
+  REQUIRE(util::fs::CreateDirectory(second));
+  REQUIRE(util::fs::WriteFile(second / "app.desktop", ""));
+
+  ApplicationIndex index;
+  index.Build({first, second});
+  REQUIRE(index.indexed_directories().size() == 2);
+  std::string path;
+
+  SECTION("entries") {
+    // A new entry with higher precedence shadows the existing one...
+    REQUIRE(util::fs::WriteFile(first / "app.desktop", ""));
+    REQUIRE_FALSE(index.Update(first, "app.desktop"));
+    REQUIRE(index.Find("app.desktop", &path));
+    REQUIRE(path == std::string(first / "app.desktop"));
+
+    // ... until it's removed.
+    REQUIRE(util::fs::Unlink(first / "app.desktop"));
+    REQUIRE_FALSE(index.Update(first, "app.desktop"));
+    REQUIRE(index.Find("app.desktop", &path));
+    REQUIRE(path == std::string(second / "app.desktop"));
+
+    REQUIRE(util::fs::Unlink(second / "app.desktop"));
+    REQUIRE_FALSE(index.Update(second, "app.desktop"));
+    REQUIRE_FALSE(index.Find("app.desktop", &path));
+  }
+
+  SECTION("subdirectories") {
+    REQUIRE(util::fs::CreateDirectory(second / "kde"));
+    REQUIRE(util::fs::WriteFile(second / "kde" / "foo.desktop", ""));
+    REQUIRE(index.Update(second, "kde"));
+    REQUIRE(index.indexed_directories().size() == 3);
+    REQUIRE(index.Find("kde-foo.desktop", &path));
+
+    REQUIRE(util::fs::WriteFile(second / "kde" / "bar.desktop", ""));
+    REQUIRE_FALSE(index.Update(second / "kde", "bar.desktop"));
+    REQUIRE(index.Find("kde-bar.desktop", &path));
+
+    REQUIRE(util::fs::Unlink(second / "kde" / "foo.desktop"));
+    REQUIRE(util::fs::Unlink(second / "kde" / "bar.desktop"));
+    REQUIRE(rmdir(std::string(second / "kde").c_str()) == 0);
+    REQUIRE(index.Update(second, "kde"));
+    REQUIRE(index.indexed_directories().size() == 2);
+    REQUIRE_FALSE(index.Find("kde-bar.desktop", &path));
+  }
+
+  SECTION("unrelated files") {
+    REQUIRE(util::fs::WriteFile(first / "README", ""));
+    REQUIRE_FALSE(index.Update(first, "README"));
+    REQUIRE_FALSE(index.Update(temp_dir.path(), "first"));
+  }
+}
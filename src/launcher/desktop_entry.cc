@@ -16,8 +16,8 @@ namespace launcher {
 namespace desktop_entry {
 namespace {
 
-bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
-                       std::string* output) {
+bool IdentifierMatcher(absl::string_view buffer, unsigned int* position,
+                       absl::string_view* output) {
   unsigned int begin = (*position);
   if (!isalpha(buffer[*position])) {
     return false;
@@ -28,10 +28,384 @@ bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
+  (*output) = buffer.substr(begin, end - begin);
   return true;
 }
 
+// Splits desktop entry contents into the same tokens as kLexer, one at a time
+// and without copying them.
+class Scanner {
+ public:
+  explicit Scanner(absl::string_view contents)
+      : contents_(contents), begin_(0), end_(0), symbol_(parser::kEOF) {
+    Scan();
+  }
+
+  parser::Symbol symbol() const { return symbol_; }
+  size_t begin() const { return begin_; }
+
+  absl::string_view match() const {
+    return contents_.substr(begin_, end_ - begin_);
+  }
+
+  absl::string_view Slice(size_t begin, size_t end) const {
+    return contents_.substr(begin, end - begin);
+  }
+
+  void Next() {
+    begin_ = end_;
+    Scan();
+  }
+
+  bool Accept(parser::Symbol symbol) {
+    if (symbol_ != symbol) {
+      return false;
+    }
+    Next();
+    return true;
+  }
+
+  void SkipOver(parser::Symbol symbol) {
+    while (symbol_ == symbol) {
+      Next();
+    }
+  }
+
+  // Skips to the next token with the given symbol, and returns false if the
+  // end of the contents is reached first.
+  bool SkipUntil(parser::Symbol symbol) {
+    while (symbol_ != symbol && symbol_ != parser::kEOF) {
+      Next();
+    }
+    return (symbol_ != parser::kEOF);
+  }
+
+ private:
+  absl::string_view contents_;
+  size_t begin_;
+  size_t end_;
+  parser::Symbol symbol_;
+
+  // Matches the token starting at begin_, trying the same matchers in the
+  // same order as kLexer.
+  void Scan() {
+    size_t length = contents_.length();
+    if (begin_ == length) {
+      end_ = length;
+      symbol_ = parser::kEOF;
+      return;
+    }
+
+    char c = contents_[begin_];
+    end_ = (begin_ + 1);
+    if (c == '\r' || c == '\n') {
+      if (c == '\r' && end_ < length && contents_[end_] == '\n') {
+        ++end_;
+      }
+      symbol_ = kNewLine;
+    } else if (isspace(c)) {
+      while (end_ < length && isspace(contents_[end_]) &&
+             contents_[end_] != '\n') {
+        ++end_;
+      }
+      symbol_ = kWhitespace;
+    } else if (c == '#') {
+      symbol_ = kPoundSign;
+    } else if (c == '[') {
+      symbol_ = kLeftBracket;
+    } else if (c == ']') {
+      symbol_ = kRightBracket;
+    } else if (c == '=') {
+      symbol_ = kEqualsSign;
+    } else if (isalpha(c)) {
+      while (end_ < length &&
+             (isalnum(contents_[end_]) || contents_[end_] == '-')) {
+        ++end_;
+      }
+      symbol_ = kIdentifier;
+    } else {
+      symbol_ = kAny;
+    }
+  }
+};
+
+bool IsBooleanKey(absl::string_view key) {
+  return (key == "NoDisplay" || key == "Hidden" || key == "Terminal" ||
+          key == "StartupNotify" || key == "DBusActivatable");
+}
+
+bool IsStringListKey(absl::string_view key) {
+  return (key == "OnlyShowIn" || key == "NotShowIn" || key == "Actions" ||
+          key == "MimeType" || key == "Categories" || key == "Implements");
+}
+
+// Keys kept by ParseFirstGroup().
+bool IsLauncherKey(absl::string_view key) {
+  return (key == "Type" || key == "Exec" || key == "Icon" || key == "Name" ||
+          key == "Comment");
+}
+
+// Same as ParseBooleanValue(), without the result.
+bool IsBooleanValue(absl::string_view value) {
+  value = absl::StripAsciiWhitespace(value);
+  return (value == "true" || value == "1" || value == "false" || value == "0");
+}
+
+// Cheap check for values which ParseNumericValue() can't possibly accept, as
+// going through a stream is comparatively slow.
+bool MayBeNumericValue(absl::string_view value) {
+  value = absl::StripAsciiWhitespace(value);
+  return (!value.empty() && (absl::ascii_isdigit(value[0]) || value[0] == '+' ||
+                             value[0] == '-' || value[0] == '.'));
+}
+
+// Same as ParseStringValue(), but only validates the value if output is
+// nullptr.
+bool UnescapeStringValue(absl::string_view value, std::string* output) {
+  if (output != nullptr) {
+    output->clear();
+    output->reserve(value.length());
+  }
+
+  bool is_escape = false;
+  for (char c : value) {
+    if (std::iscntrl(c)) {
+      util::log::Error() << "String value cannot contain control characters.\n";
+      return false;
+    }
+
+    if (c == '\\') {
+      is_escape = (!is_escape);
+      if (!is_escape && output != nullptr) {
+        output->push_back(c);
+      }
+      continue;
+    }
+
+    if (is_escape) {
+      switch (c) {
+        case 's':
+          c = ' ';
+          break;
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case ';':
+          break;
+        default:
+          util::log::Error() << "Invalid escape sequence: \\" << c << '\n';
+          return false;
+      }
+      is_escape = false;
+    }
+    if (output != nullptr) {
+      output->push_back(c);
+    }
+  }
+
+  // Trailing slashes are not valid as they leave an unterminated escape
+  // sequence behind.
+  if (is_escape) {
+    util::log::Error() << "Unterminated escape sequence.\n";
+    return false;
+  }
+  return true;
+}
+
+// Same as ParseStringListValue(), without the result.
+bool IsStringListValue(absl::string_view value) {
+  bool is_escape = false;
+  size_t begin = 0;
+
+  for (size_t i = 0; i < value.length(); ++i) {
+    if (value[i] == '\\') {
+      is_escape = (!is_escape);
+      continue;
+    }
+    if (value[i] == ';') {
+      if (is_escape) {
+        is_escape = false;
+      } else {
+        if (!UnescapeStringValue(value.substr(begin, i - begin), nullptr)) {
+          return false;
+        }
+        begin = (i + 1);
+      }
+    }
+  }
+  if (begin != value.length()) {
+    return UnescapeStringValue(value.substr(begin), nullptr);
+  }
+  return true;
+}
+
+// Follows the same grammar as Parser, see ParseFirstGroup().
+class FirstGroupParser {
+ public:
+  FirstGroupParser(absl::string_view contents, absl::string_view locale,
+                   Group* group)
+      : scanner_(contents),
+        locale_(locale),
+        group_(group),
+        in_first_group_(false),
+        found_first_group_(false) {}
+
+  bool Parse() {
+    // Only empty lines and comments can come before the first group.
+    while (scanner_.symbol() != kLeftBracket) {
+      if (scanner_.Accept(kPoundSign)) {
+        scanner_.SkipUntil(kNewLine);
+      } else if (!scanner_.Accept(kNewLine)) {
+        return false;
+      }
+    }
+
+    while (true) {
+      if (!GroupHeader() || !scanner_.Accept(kNewLine)) {
+        return false;
+      }
+
+      while (scanner_.symbol() != kLeftBracket) {
+        if (scanner_.symbol() == parser::kEOF) {
+          return found_first_group_;
+        }
+        if (scanner_.Accept(kPoundSign)) {
+          scanner_.SkipUntil(kNewLine);
+        } else if (!scanner_.Accept(kNewLine) && !GroupEntry()) {
+          return false;
+        }
+      }
+    }
+  }
+
+ private:
+  Scanner scanner_;
+  absl::string_view locale_;
+  Group* group_;
+  bool in_first_group_;
+  bool found_first_group_;
+
+  bool GroupHeader() {
+    scanner_.Accept(kLeftBracket);
+
+    size_t begin = scanner_.begin();
+    scanner_.SkipUntil(kRightBracket);
+    absl::string_view name{scanner_.Slice(begin, scanner_.begin())};
+
+    // Like in Parser, groups without a name are dropped.
+    in_first_group_ = (!found_first_group_ && !name.empty());
+    if (in_first_group_) {
+      (*group_) = Group{std::string{name}};
+      found_first_group_ = true;
+    }
+
+    return scanner_.Accept(kRightBracket);
+  }
+
+  bool GroupEntry() {
+    // key = value
+    absl::string_view key{scanner_.match()};
+    if (!scanner_.Accept(kIdentifier)) {
+      return false;
+    }
+
+    // key[locale] = value
+    absl::string_view locale;
+    if (scanner_.Accept(kLeftBracket)) {
+      size_t begin = scanner_.begin();
+      if (!scanner_.SkipUntil(kRightBracket)) {
+        return false;
+      }
+      locale = scanner_.Slice(begin, scanner_.begin());
+      scanner_.Accept(kRightBracket);
+    }
+
+    scanner_.SkipOver(kWhitespace);
+
+    if (!scanner_.Accept(kEqualsSign)) {
+      return false;
+    }
+
+    scanner_.SkipOver(kWhitespace);
+
+    size_t begin = scanner_.begin();
+    if (!scanner_.SkipUntil(kNewLine)) {
+      return false;
+    }
+    if (!AddKeyValue(key, scanner_.Slice(begin, scanner_.begin()), locale)) {
+      return false;
+    }
+
+    // skip over the actual newline
+    scanner_.Next();
+    return true;
+  }
+
+  // Validates the value as Parser::AddKeyValue() does, but only stores it if
+  // it's one of the kept entries.
+  bool AddKeyValue(absl::string_view key, absl::string_view value,
+                   absl::string_view locale) {
+    if (IsBooleanKey(key)) {
+      return IsBooleanValue(value);
+    }
+    if (IsStringListKey(key)) {
+      return IsStringListValue(value);
+    }
+    if (key == "Version") {
+      return UnescapeStringValue(value, nullptr);
+    }
+
+    bool keep = (in_first_group_ && IsLauncherKey(key));
+
+    float value_numeric;
+    if (MayBeNumericValue(value) &&
+        ParseNumericValue(std::string{value}, &value_numeric)) {
+      if (keep) {
+        group_->AddEntry(std::string{key}, value_numeric);
+      }
+      return true;
+    }
+
+    // Only the translation for our own locale is worth copying.
+    bool keep_value = (keep && (locale.empty() || locale == locale_));
+    std::string value_string;
+    if (!UnescapeStringValue(value, keep_value ? &value_string : nullptr)) {
+      return false;
+    }
+    if (!keep) {
+      return true;
+    }
+
+    std::string key_string{key};
+    if (locale.empty()) {
+      group_->AddEntry(key_string, value_string);
+      return true;
+    }
+
+    if (group_->IsEntry<std::string>(key_string)) {
+      // Locale string which extends a previously non-localized entry
+      std::string nonlocalized_value{group_->GetEntry<std::string>(key_string)};
+      group_->AddEntry(key_string,
+                       Group::LocaleString{{"", nonlocalized_value}});
+    } else if (!group_->IsEntry<Group::LocaleString>(key_string)) {
+      // Locale string, new
+      group_->AddEntry(key_string, Group::LocaleString{});
+    }
+    if (keep_value) {
+      // Locale string, existing or just added
+      group_->GetEntry<Group::LocaleString>(key_string)[std::string{locale}] =
+          value_string;
+    }
+    return true;
+  }
+};
+
 }  // namespace
 
 const parser::Lexer kLexer{
@@ -125,15 +499,14 @@ bool Parser::GroupHeader(parser::TokenList* tokens) {
     return false;
   }
 
-  std::vector<parser::Token> skipped;
-  tokens->SkipUntil(kRightBracket, &skipped);
+  absl::string_view name;
+  tokens->SkipUntil(kRightBracket, &name);
 
   if (current_group_.GetName() != Group::kInvalidName) {
     groups_.emplace_back(current_group_);
   }
 
-  current_group_ =
-      desktop_entry::Group{parser::TokenList::JoinSkipped(skipped)};
+  current_group_ = desktop_entry::Group{std::string{name}};
 
   return tokens->Accept(kRightBracket);
 }
@@ -165,21 +538,19 @@ bool Parser::GroupEntry(parser::TokenList* tokens) {
 
   // start of a new entry
   // key = value
-  std::string key{tokens->Current().match};
+  absl::string_view key{tokens->CurrentMatch()};
   if (!tokens->Accept(kIdentifier)) {
     return false;
   }
 
   // localized entry?
   // key[locale] = value
-  std::string locale;
+  absl::string_view locale;
   if (tokens->Accept(kLeftBracket)) {
-    std::vector<parser::Token> skipped;
-    if (!tokens->SkipUntil(kRightBracket, &skipped)) {
+    if (!tokens->SkipUntil(kRightBracket, &locale)) {
       return false;
     }
     tokens->Accept(kRightBracket);
-    locale = parser::TokenList::JoinSkipped(skipped);
   }
 
   tokens->SkipOver(kWhitespace);
@@ -190,12 +561,13 @@ bool Parser::GroupEntry(parser::TokenList* tokens) {
 
   tokens->SkipOver(kWhitespace);
 
-  std::vector<parser::Token> skipped;
-  if (!tokens->SkipUntil(kNewLine, &skipped)) {
+  absl::string_view value;
+  if (!tokens->SkipUntil(kNewLine, &value)) {
     return false;
   }
 
-  if (!AddKeyValue(key, parser::TokenList::JoinSkipped(skipped), locale)) {
+  if (!AddKeyValue(std::string{key}, std::string{value},
+                   std::string{locale})) {
     return false;
   }
 
@@ -463,5 +835,10 @@ std::string BestLocalizedEntry(Group& group, std::string const& key) {
   return (it != localized_name.end()) ? it->second : localized_name.at("");
 }
 
+bool ParseFirstGroup(absl::string_view contents, absl::string_view locale,
+                     Group* group) {
+  return FirstGroupParser{contents, locale, group}.Parse();
+}
+
 }  // namespace desktop_entry
 }  // namespace launcher
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "absl/types/variant.h"
 
 #include "parser/parser.hh"
@@ -114,6 +115,15 @@ bool Validate(DesktopEntry* entry);
 
 std::string BestLocalizedEntry(Group& group, std::string const& key);
 
+// Single-pass parser for the launcher, which accepts and rejects the same
+// contents as Parser, without going through the lexer nor copying anything
+// but the entries tint3 uses: Type, Exec, Icon, Name and Comment, from the
+// first group. Of their localized variants, only the one for the given locale
+// is kept, which is all BestLocalizedEntry() needs under that locale.
+// Also returns false if the contents don't have any group.
+bool ParseFirstGroup(absl::string_view contents, absl::string_view locale,
+                     Group* group);
+
 }  // namespace desktop_entry
 }  // namespace launcher
 
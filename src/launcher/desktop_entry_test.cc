@@ -1,8 +1,16 @@
 #include "catch.hpp"
 
+#include <chrono>
 #include <clocale>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "parser/parser.hh"
+#include "util/fs.hh"
 
 #include "launcher/desktop_entry.hh"
 
@@ -345,3 +353,221 @@ TEST_CASE("TrailingWhitespace",
   REQUIRE(groups[0].GetEntry<std::string>("Comment") ==
           "Browse the World Wide Web ");
 }
+
+TEST_CASE("ParseFirstGroup", "Only keeps what the launcher needs") {
+  launcher::desktop_entry::Group group{
+      launcher::desktop_entry::Group::kInvalidName};
+
+  REQUIRE(launcher::desktop_entry::ParseFirstGroup(kExampleContents, "it",
+                                                   &group));
+  REQUIRE(group.GetName() == "Desktop Entry");
+  REQUIRE(group.GetEntry<std::string>("Type") == "Application");
+  REQUIRE(group.GetEntry<std::string>("Exec") == "fooview %F");
+  REQUIRE(group.GetEntry<std::string>("Icon") == "fooview");
+  REQUIRE(group.GetEntry<std::string>("Name") == "Foo Viewer");
+  REQUIRE_FALSE(group.HasEntry("Version"));
+  REQUIRE_FALSE(group.HasEntry("MimeType"));
+
+  REQUIRE(launcher::desktop_entry::ParseFirstGroup(kLocalizedContents, "it",
+                                                   &group));
+  using LocaleString = launcher::desktop_entry::Group::LocaleString;
+  REQUIRE(group.GetEntry<LocaleString>("Name") ==
+          (LocaleString{{"", "Foo Viewer"}, {"it", "Visualizzatore di Foo"}}));
+
+  REQUIRE_FALSE(launcher::desktop_entry::ParseFirstGroup("", "", &group));
+  REQUIRE_FALSE(
+      launcher::desktop_entry::ParseFirstGroup("\n# comment\n", "", &group));
+}
+
+namespace {
+
+// Checks that ParseFirstGroup() agrees with Parser on the given contents.
+void RequireSameFirstGroup(std::string const& contents,
+                           std::string const& locale) {
+  using launcher::desktop_entry::Group;
+
+  launcher::desktop_entry::Parser desktop_entry_parser;
+  parser::Parser p{launcher::desktop_entry::kLexer, &desktop_entry_parser};
+  bool parsed = p.Parse(contents);
+  launcher::desktop_entry::DesktopEntry groups{
+      desktop_entry_parser.GetDesktopEntry()};
+
+  Group group{Group::kInvalidName};
+  INFO("contents: \"" << contents << '"');
+  REQUIRE(launcher::desktop_entry::ParseFirstGroup(contents, locale, &group) ==
+          (parsed && !groups.empty()));
+  if (!parsed || groups.empty()) {
+    return;
+  }
+
+  Group& expected = groups[0];
+  REQUIRE(group.GetName() == expected.GetName());
+  for (std::string key : {"Type", "Exec", "Icon", "Name", "Comment"}) {
+    INFO("key: " << key);
+    REQUIRE(group.HasEntry(key) == expected.HasEntry(key));
+    if (!expected.HasEntry(key)) {
+      continue;
+    }
+
+    REQUIRE(group.IsEntry<std::string>(key) ==
+            expected.IsEntry<std::string>(key));
+    REQUIRE(group.IsEntry<float>(key) == expected.IsEntry<float>(key));
+    REQUIRE(group.IsEntry<Group::LocaleString>(key) ==
+            expected.IsEntry<Group::LocaleString>(key));
+
+    if (expected.IsEntry<std::string>(key)) {
+      REQUIRE(group.GetEntry<std::string>(key) ==
+              expected.GetEntry<std::string>(key));
+    } else if (expected.IsEntry<float>(key)) {
+      REQUIRE(group.GetEntry<float>(key) == expected.GetEntry<float>(key));
+    } else {
+      auto& locale_map = group.GetEntry<Group::LocaleString>(key);
+      auto& expected_locale_map = expected.GetEntry<Group::LocaleString>(key);
+      for (std::string l : {std::string{}, locale}) {
+        REQUIRE(locale_map.count(l) == expected_locale_map.count(l));
+        if (expected_locale_map.count(l) != 0) {
+          REQUIRE(locale_map.at(l) == expected_locale_map.at(l));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("ParseFirstGroupFuzz", "Agrees with Parser on random contents") {
+  // Both parsers complain loudly about invalid values.
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(nullptr);
+
+  static const std::vector<std::string> kFragments{
+      "[",         "]",     "=",       " ",      "\t",      "\n",  "\r",
+      "\r\n",      "#",     "\\",      "\\s",    ";",       "\x01", "\xc3\xa9",
+      "a",         "-",     "_",       "1",      "1.5",     ".",   "+",
+      "e3",        "true",  "Name",    "Exec",   "Icon",    "Type",
+      "Comment",   "[it]",  "[fr]",    "[]",     "Version", "Hidden",
+      "MimeType",  "Desktop Entry",    "[Desktop Entry]\n",  "Name=",
+      "Exec=foo",  "Icon=1", "Name[it]=", "Comment[it]=x\n",
+  };
+
+  std::mt19937 generator{1234};
+  auto pick = [&generator](size_t size) {
+    return std::uniform_int_distribution<size_t>{0, size - 1}(generator);
+  };
+
+  SECTION("random lines") {
+    static const std::vector<std::string> kKeys{
+        "Type", "Exec", "Icon", "Name", "Comment", "Version", "Hidden",
+        "MimeType", "X-Other",
+    };
+    static const std::vector<std::string> kSeparators{"=", " = ", "\t=",
+                                                      " \r= "};
+    static const std::vector<std::string> kNewLines{"\n", "\n", "\r\n",
+                                                    "\r"};
+    auto fragments = [&](size_t max_count) {
+      std::string result;
+      for (size_t count = pick(max_count + 1); count != 0; --count) {
+        result += kFragments[pick(kFragments.size())];
+      }
+      return result;
+    };
+
+    for (int i = 0; i < 20000; ++i) {
+      std::string contents;
+      for (size_t lines = pick(8); lines != 0; --lines) {
+        switch (pick(6)) {
+          case 0:
+            contents += "[" + fragments(2) + "]";
+            break;
+          case 1:
+            contents += "#" + fragments(3);
+            break;
+          case 2:
+            contents += fragments(3);
+            break;
+          default:
+            contents += kKeys[pick(kKeys.size())];
+            if (pick(2) == 0) {
+              contents += "[" + fragments(1) + "]";
+            }
+            contents += kSeparators[pick(kSeparators.size())] + fragments(3);
+            break;
+        }
+        contents += kNewLines[pick(kNewLines.size())];
+      }
+      RequireSameFirstGroup(contents, "it");
+    }
+  }
+
+  SECTION("mutated entries") {
+    std::vector<std::string> samples{kExampleContents, kLocalizedContents,
+                                     kValueTypes, kTrailingWhitespace};
+    for (int i = 0; i < 20000; ++i) {
+      std::string contents{samples[pick(samples.size())]};
+      for (size_t mutations = pick(4) + 1; mutations != 0; --mutations) {
+        size_t position = pick(contents.length() + 1);
+        std::string const& fragment = kFragments[pick(kFragments.size())];
+        switch (pick(3)) {
+          case 0:
+            contents.insert(position, fragment);
+            break;
+          case 1:
+            contents.erase(position, fragment.length());
+            break;
+          default:
+            contents.replace(position, fragment.length(), fragment);
+            break;
+        }
+      }
+      RequireSameFirstGroup(contents, "it");
+    }
+  }
+
+  std::cerr.rdbuf(cerr_buffer);
+}
+
+TEST_CASE("ParseFirstGroupBenchmark", "[.][benchmark]") {
+  // Parses all the entries in /usr/share/applications with both parsers.
+  static const std::string kApplicationsPath{"/usr/share/applications"};
+  std::vector<std::string> corpus;
+  for (auto const& name : util::fs::DirectoryContents{kApplicationsPath}) {
+    std::string contents;
+    if (util::fs::ReadFile(util::fs::Path{kApplicationsPath} / name,
+                           &contents)) {
+      corpus.push_back(contents);
+    }
+  }
+  if (corpus.empty()) {
+    WARN("No desktop entries found in " << kApplicationsPath);
+    return;
+  }
+
+  auto measure = [&corpus](std::function<void(std::string const&)> parse) {
+    static constexpr int kRounds = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+      for (auto const& contents : corpus) {
+        parse(contents);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+               .count() /
+           static_cast<double>(kRounds * corpus.size());
+  };
+
+  double parser_us = measure([](std::string const& contents) {
+    launcher::desktop_entry::Parser desktop_entry_parser;
+    parser::Parser p{launcher::desktop_entry::kLexer, &desktop_entry_parser};
+    p.Parse(contents);
+  });
+  double first_group_us = measure([](std::string const& contents) {
+    launcher::desktop_entry::Group group{
+        launcher::desktop_entry::Group::kInvalidName};
+    launcher::desktop_entry::ParseFirstGroup(contents, "it", &group);
+  });
+
+  std::cout << corpus.size() << " desktop entries from " << kApplicationsPath
+            << ":\n  Parser:          " << parser_us
+            << " us/entry\n  ParseFirstGroup: " << first_group_us
+            << " us/entry\n";
+}
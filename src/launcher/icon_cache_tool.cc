@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+
+#include "launcher/icon_cache_tool.hh"
+#include "launcher/icon_theme.hh"
+#include "util/fs.hh"
+#include "util/log.hh"
+#include "util/xdg.hh"
+
+namespace {
+
+// Only printed on request, so it goes to stdout and isn't an error.
+void PrintUsage(std::string const& argv0) {
+  std::cout << "Usage: " << argv0 << u8R"EOF( icon-cache [cache-file...]
+
+Prints the contents of the given icon cache files. If none is given, all the
+ones in $XDG_CACHE_HOME/tint3 are printed.
+)EOF";
+}
+
+std::vector<std::string> ListCacheFiles() {
+  util::fs::Path cache_dir{util::xdg::basedir::CacheHome() / "tint3"};
+  std::vector<std::string> cache_files;
+  for (auto const& name : util::fs::DirectoryContents(cache_dir)) {
+    if (absl::EndsWith(name, ".cache")) {
+      cache_files.push_back(cache_dir / name);
+    }
+  }
+  std::sort(cache_files.begin(), cache_files.end());
+  return cache_files;
+}
+
+}  // namespace
+
+int IconCacheTool(int argc, char* argv[]) {
+  std::vector<std::string> cache_files{argv + 2, argv + argc};
+  if (cache_files.empty()) {
+    cache_files = ListCacheFiles();
+  } else if (cache_files.front() == "help" || cache_files.front() == "-h") {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  int status = 0;
+  for (auto const& cache_file : cache_files) {
+    IconThemeIndex index;
+    if (!index.Open(cache_file)) {
+      util::log::Error() << "Error: \"" << cache_file
+                         << "\" is not a valid icon cache.\n";
+      status = 1;
+      continue;
+    }
+    std::cout << cache_file << ":\n" << index.Dump();
+  }
+  return status;
+}
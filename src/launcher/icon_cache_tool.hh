@@ -0,0 +1,9 @@
+#ifndef TINT3_LAUNCHER_ICON_CACHE_TOOL_HH
+#define TINT3_LAUNCHER_ICON_CACHE_TOOL_HH
+
+// Entry point of "tint3 icon-cache", which prints the contents of the given
+// icon cache files (or of all the ones in the cache directory, if none is
+// given).
+int IconCacheTool(int argc, char* argv[]);
+
+#endif  // TINT3_LAUNCHER_ICON_CACHE_TOOL_HH
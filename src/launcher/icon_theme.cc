@@ -0,0 +1,490 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+#include "launcher/icon_theme.hh"
+#include "util/fs.hh"
+#include "util/log.hh"
+#include "util/xdg.hh"
+
+namespace {
+
+// Cache file layout, all integers in host byte order:
+//
+//   CacheHeader
+//   DirectoryRecord[directory_count]
+//   FileRecord[file_count]          (sorted by name)
+//   Location[location_count]
+//   char[strings_size]              (directory paths and file names)
+//
+// Every section is a multiple of 8 bytes long, so that the records are
+// properly aligned when the file is mapped.
+constexpr char kCacheMagic[8] = {'t', 'i', 'n', 't', '3', 'I', 'C', 'N'};
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t directory_count;
+  uint32_t file_count;
+  uint32_t location_count;
+  uint32_t strings_size;
+  uint32_t reserved;
+};
+
+struct DirectoryRecord {
+  uint32_t path_offset;
+  uint32_t path_length;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint32_t exists;
+  uint32_t reserved;
+};
+
+struct FileRecord {
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint32_t first_location;
+  uint32_t location_count;
+};
+
+using Location = IconThemeIndex::Location;
+
+static_assert(sizeof(CacheHeader) % 8 == 0, "unaligned cache header");
+static_assert(sizeof(DirectoryRecord) % 8 == 0, "unaligned directory record");
+static_assert(sizeof(FileRecord) % 8 == 0, "unaligned file record");
+static_assert(sizeof(Location) == 2 * sizeof(uint32_t),
+              "unexpected Location layout");
+
+bool IsIconFileName(std::string const& file_name) {
+  for (auto const& extension : IconExtensions()) {
+    if (file_name.length() > extension.length() &&
+        absl::EndsWith(file_name, extension)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Visits the directories an index is built from, in the order they're
+// recorded in it, passing their stat() information (or nullptr if they don't
+// exist) and whether their contents should be indexed.
+// The root of the theme under each base directory comes first, so that the
+// subdirectories of a theme that isn't installed in some base directory don't
+// need to be checked one by one. Unthemed icons (an empty theme name) are
+// indexed from the roots themselves.
+// Stops as soon as fn returns false, and returns false in that case.
+template <typename Fn>
+bool ForEachIndexedDirectory(std::vector<std::string> const& base_dirs,
+                             std::string const& theme_name,
+                             std::vector<IconThemeDir*> const& directories,
+                             Fn fn) {
+  auto stat_directory = [](std::string const& path, struct stat* info) {
+    return util::fs::Stat(path, info) && S_ISDIR(info->st_mode);
+  };
+
+  for (unsigned int j = 0; j < base_dirs.size(); ++j) {
+    std::string root{theme_name.empty()
+                         ? base_dirs[j]
+                         : util::fs::BuildPath({base_dirs[j], theme_name})};
+
+    struct stat info;
+    bool exists = stat_directory(root, &info);
+    if (!fn(root, exists ? &info : nullptr, theme_name.empty(),
+            Location{0, j})) {
+      return false;
+    }
+    if (!exists || theme_name.empty()) {
+      continue;
+    }
+
+    for (unsigned int i = 0; i < directories.size(); ++i) {
+      std::string path{util::fs::BuildPath({root, directories[i]->name})};
+      exists = stat_directory(path, &info);
+      if (!fn(path, exists ? &info : nullptr, true, Location{i, j})) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+class CacheWriter {
+ public:
+  void AddDirectory(std::string const& path, struct stat const* info) {
+    DirectoryRecord record{};
+    record.path_offset = AddString(path);
+    record.path_length = path.length();
+    if (info != nullptr) {
+      record.mtime_sec = info->st_mtim.tv_sec;
+      record.mtime_nsec = info->st_mtim.tv_nsec;
+      record.exists = 1;
+    }
+    directories_.push_back(record);
+  }
+
+  void AddFile(std::string const& file_name, Location location) {
+    files_[file_name].push_back(location);
+  }
+
+  std::string Serialize() {
+    std::vector<FileRecord> files;
+    std::vector<Location> locations;
+    files.reserve(files_.size());
+    for (auto& entry : files_) {
+      auto& file_locations = entry.second;
+      std::sort(file_locations.begin(), file_locations.end(),
+                [](Location const& lhs, Location const& rhs) {
+                  return std::tie(lhs.directory, lhs.base) <
+                         std::tie(rhs.directory, rhs.base);
+                });
+
+      FileRecord record;
+      record.name_offset = AddString(entry.first);
+      record.name_length = entry.first.length();
+      record.first_location = locations.size();
+      record.location_count = file_locations.size();
+      files.push_back(record);
+      locations.insert(locations.end(), file_locations.begin(),
+                       file_locations.end());
+    }
+    strings_.resize((strings_.size() + 7) & ~7);
+
+    CacheHeader header{};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.directory_count = directories_.size();
+    header.file_count = files.size();
+    header.location_count = locations.size();
+    header.strings_size = strings_.size();
+
+    std::string data;
+    data.reserve(sizeof(header) +
+                 directories_.size() * sizeof(DirectoryRecord) +
+                 files.size() * sizeof(FileRecord) +
+                 locations.size() * sizeof(Location) + strings_.size());
+    Append(&data, &header, 1);
+    Append(&data, directories_.data(), directories_.size());
+    Append(&data, files.data(), files.size());
+    Append(&data, locations.data(), locations.size());
+    data.append(strings_);
+    return data;
+  }
+
+ private:
+  template <typename T>
+  static void Append(std::string* data, T const* items, size_t count) {
+    data->append(reinterpret_cast<char const*>(items), count * sizeof(T));
+  }
+
+  uint32_t AddString(std::string const& str) {
+    uint32_t offset = strings_.size();
+    strings_.append(str);
+    return offset;
+  }
+
+  std::vector<DirectoryRecord> directories_;
+  std::map<std::string, std::vector<Location>> files_;
+  std::string strings_;
+};
+
+// Typed view over the sections of a cache file.
+struct CacheView {
+  explicit CacheView(absl::string_view data)
+      : header(reinterpret_cast<CacheHeader const*>(data.data())),
+        directories(
+            reinterpret_cast<DirectoryRecord const*>(header + 1),
+            header->directory_count),
+        files(reinterpret_cast<FileRecord const*>(directories.end()),
+              header->file_count),
+        locations(reinterpret_cast<Location const*>(files.end()),
+                  header->location_count),
+        strings(reinterpret_cast<char const*>(locations.end()),
+                header->strings_size) {}
+
+  absl::string_view Path(DirectoryRecord const& record) const {
+    return strings.substr(record.path_offset, record.path_length);
+  }
+
+  absl::string_view Name(FileRecord const& record) const {
+    return strings.substr(record.name_offset, record.name_length);
+  }
+
+  CacheHeader const* header;
+  absl::Span<DirectoryRecord const> directories;
+  absl::Span<FileRecord const> files;
+  absl::Span<Location const> locations;
+  absl::string_view strings;
+};
+
+}  // namespace
+
+void IconThemeIndex::Build(std::vector<std::string> const& base_dirs,
+                           std::string const& theme_name,
+                           std::vector<IconThemeDir*> const& directories) {
+  Clear();
+
+  CacheWriter writer;
+  ForEachIndexedDirectory(
+      base_dirs, theme_name, directories,
+      [&](std::string const& path, struct stat const* info, bool list,
+          Location location) {
+        writer.AddDirectory(path, info);
+        if (info != nullptr && list) {
+          for (auto const& file_name : util::fs::DirectoryContents(path)) {
+            if (IsIconFileName(file_name)) {
+              writer.AddFile(file_name, location);
+            }
+          }
+        }
+        return true;
+      });
+
+  built_ = writer.Serialize();
+  data_ = built_;
+}
+
+void IconThemeIndex::BuildUnthemed(std::vector<std::string> const& base_dirs) {
+  Build(base_dirs, "", {});
+}
+
+void IconThemeIndex::Load(std::string const& cache_path,
+                          std::vector<std::string> const& base_dirs,
+                          std::string const& theme_name,
+                          std::vector<IconThemeDir*> const& directories) {
+  Clear();
+
+  if (mapped_.Open(cache_path) &&
+      Attach(mapped_.contents(), std::max<size_t>(directories.size(), 1),
+             base_dirs.size()) &&
+      IsUpToDate(base_dirs, theme_name, directories)) {
+    loaded_from_cache_ = true;
+    return;
+  }
+
+  util::log::Debug() << "Icon cache \"" << cache_path
+                     << "\" is missing or out of date, rebuilding it\n";
+  Build(base_dirs, theme_name, directories);
+  WriteCache(cache_path);
+}
+
+void IconThemeIndex::LoadUnthemed(std::string const& cache_path,
+                                  std::vector<std::string> const& base_dirs) {
+  Load(cache_path, base_dirs, "", {});
+}
+
+bool IconThemeIndex::Open(std::string const& cache_path) {
+  Clear();
+  if (!mapped_.Open(cache_path) ||
+      !Attach(mapped_.contents(), UINT32_MAX, UINT32_MAX)) {
+    Clear();
+    return false;
+  }
+  loaded_from_cache_ = true;
+  return true;
+}
+
+void IconThemeIndex::Clear() {
+  built_.clear();
+  mapped_.Close();
+  data_ = absl::string_view{};
+  loaded_from_cache_ = false;
+}
+
+bool IconThemeIndex::loaded_from_cache() const { return loaded_from_cache_; }
+
+absl::Span<IconThemeIndex::Location const> IconThemeIndex::Find(
+    absl::string_view file_name) const {
+  if (data_.empty()) {
+    return {};
+  }
+
+  CacheView cache{data_};
+  auto it = std::lower_bound(cache.files.begin(), cache.files.end(), file_name,
+                             [&](FileRecord const& record,
+                                 absl::string_view name) {
+                               return cache.Name(record) < name;
+                             });
+  if (it == cache.files.end() || cache.Name(*it) != file_name) {
+    return {};
+  }
+  return cache.locations.subspan(it->first_location, it->location_count);
+}
+
+std::string IconThemeIndex::Dump() const {
+  if (data_.empty()) {
+    return "";
+  }
+
+  CacheView cache{data_};
+  std::string output;
+  absl::StrAppendFormat(&output, "directories (%u):\n",
+                        cache.header->directory_count);
+  for (auto const& record : cache.directories) {
+    if (record.exists) {
+      absl::StrAppendFormat(&output, "  %s (mtime %d.%09d)\n",
+                            cache.Path(record), record.mtime_sec,
+                            record.mtime_nsec);
+    } else {
+      absl::StrAppendFormat(&output, "  %s (missing)\n", cache.Path(record));
+    }
+  }
+
+  absl::StrAppendFormat(&output, "files (%u):\n", cache.header->file_count);
+  for (auto const& record : cache.files) {
+    absl::StrAppend(&output, "  ", cache.Name(record), ":");
+    for (auto const& location : cache.locations.subspan(
+             record.first_location, record.location_count)) {
+      absl::StrAppendFormat(&output, " %u/%u", location.base,
+                            location.directory);
+    }
+    output.push_back('\n');
+  }
+  return output;
+}
+
+bool IconThemeIndex::Attach(absl::string_view data, size_t directory_count,
+                            size_t base_count) {
+  // The cache file may have been truncated or corrupted in any way, so check
+  // that all the offsets it contains are within bounds before trusting it.
+  if (data.size() < sizeof(CacheHeader)) {
+    return false;
+  }
+
+  auto header = reinterpret_cast<CacheHeader const*>(data.data());
+  if (std::memcmp(header->magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header->version != kCacheVersion) {
+    return false;
+  }
+
+  uint64_t expected_size =
+      sizeof(CacheHeader) +
+      uint64_t{header->directory_count} * sizeof(DirectoryRecord) +
+      uint64_t{header->file_count} * sizeof(FileRecord) +
+      uint64_t{header->location_count} * sizeof(Location) +
+      header->strings_size;
+  if (data.size() != expected_size) {
+    return false;
+  }
+
+  CacheView cache{data};
+  auto in_strings = [&](uint32_t offset, uint32_t length) {
+    return uint64_t{offset} + length <= cache.strings.size();
+  };
+
+  for (auto const& record : cache.directories) {
+    if (!in_strings(record.path_offset, record.path_length)) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < cache.files.size(); ++i) {
+    FileRecord const& record = cache.files[i];
+    if (!in_strings(record.name_offset, record.name_length) ||
+        uint64_t{record.first_location} + record.location_count >
+            cache.locations.size()) {
+      return false;
+    }
+    // Lookups are binary searches.
+    if (i > 0 && !(cache.Name(cache.files[i - 1]) < cache.Name(record))) {
+      return false;
+    }
+  }
+
+  for (auto const& location : cache.locations) {
+    if (location.directory >= directory_count || location.base >= base_count) {
+      return false;
+    }
+  }
+
+  data_ = data;
+  return true;
+}
+
+bool IconThemeIndex::IsUpToDate(
+    std::vector<std::string> const& base_dirs, std::string const& theme_name,
+    std::vector<IconThemeDir*> const& directories) const {
+  CacheView cache{data_};
+  size_t next = 0;
+
+  bool matches = ForEachIndexedDirectory(
+      base_dirs, theme_name, directories,
+      [&](std::string const& path, struct stat const* info, bool /* list */,
+          Location /* location */) {
+        if (next == cache.directories.size()) {
+          return false;
+        }
+        DirectoryRecord const& record = cache.directories[next++];
+        if (cache.Path(record) != path) {
+          return false;
+        }
+        if (info == nullptr) {
+          return record.exists == 0;
+        }
+        return record.exists != 0 &&
+               record.mtime_sec == info->st_mtim.tv_sec &&
+               record.mtime_nsec == info->st_mtim.tv_nsec;
+      });
+  return matches && next == cache.directories.size();
+}
+
+void IconThemeIndex::WriteCache(std::string const& cache_path) const {
+  std::string directory{util::fs::Path(cache_path).DirectoryName()};
+  if (!util::fs::CreateDirectory(directory)) {
+    util::log::Error() << "Couldn't create directory \"" << directory
+                       << "\" for the icon cache\n";
+    return;
+  }
+
+  // Write to a temporary file first, so that a tint3 instance mapping the
+  // cache concurrently never sees it half written.
+  std::string temporary_path{absl::StrCat(cache_path, ".", getpid())};
+  if (!util::fs::WriteFile(temporary_path, data_) ||
+      std::rename(temporary_path.c_str(), cache_path.c_str()) != 0) {
+    util::log::Error() << "Couldn't write the icon cache \"" << cache_path
+                       << "\"\n";
+    util::fs::Unlink(temporary_path);
+  }
+}
+
+IconTheme::~IconTheme() {
+  for (auto const& dir : list_directories) {
+    delete dir;
+  }
+}
+
+std::vector<std::string> IconBaseDirectories() {
+  return {
+      util::fs::HomeDirectory() / ".icons",
+      util::fs::HomeDirectory() / ".local" / "share" / "icons",
+      "/usr/local/share/icons",
+      "/usr/local/share/pixmaps",
+      "/usr/share/icons",
+      "/usr/share/pixmaps",
+  };
+}
+
+std::string IconThemeCachePath(std::string const& theme_name) {
+  return util::xdg::basedir::CacheHome() / "tint3" /
+         absl::StrCat("icon-theme-", theme_name, ".cache");
+}
+
+std::string UnthemedIconsCachePath() {
+  return util::xdg::basedir::CacheHome() / "tint3" / "unthemed-icons.cache";
+}
+
+std::vector<std::string> const& IconExtensions() {
+  static const std::vector<std::string> extensions{".png", ".xpm"};
+  return extensions;
+}
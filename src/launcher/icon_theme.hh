@@ -0,0 +1,114 @@
+#ifndef TINT3_LAUNCHER_ICON_THEME_HH
+#define TINT3_LAUNCHER_ICON_THEME_HH
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+#include "util/fs.hh"
+
+enum class IconType { kScalable, kFixed, kThreshold };
+
+struct IconThemeDir {
+  std::string name;
+  std::string context;
+  int size;
+  IconType type;
+  int max_size;
+  int min_size;
+  int threshold;
+};
+
+// Maps icon file names to the places they can be found in, built by listing
+// each directory once instead of probing every candidate path with stat().
+//
+// The index is kept in a compact binary format (see icon_theme.cc) that can
+// be persisted to disk and memory-mapped back on the next start, and which is
+// used as is for lookups. Alongside the icons, it records the modification
+// time of every directory it was built from: as long as none of them changed,
+// a cached index can be used without listing any directory at all.
+class IconThemeIndex {
+ public:
+  struct Location {
+    // Index into the theme's list of directories (0 for unthemed icons).
+    unsigned int directory;
+    // Index into the list of base directories.
+    unsigned int base;
+  };
+
+  // Indexes the icons of a theme, listing each of its directories under every
+  // base directory.
+  void Build(std::vector<std::string> const& base_dirs,
+             std::string const& theme_name,
+             std::vector<IconThemeDir*> const& directories);
+
+  // Indexes the unthemed icons, i.e. the ones directly inside the base
+  // directories.
+  void BuildUnthemed(std::vector<std::string> const& base_dirs);
+
+  // Same as Build() and BuildUnthemed(), but reuse the index cached at
+  // cache_path if it's still up to date. Otherwise, the index is rebuilt and
+  // the cache is (re)written.
+  void Load(std::string const& cache_path,
+            std::vector<std::string> const& base_dirs,
+            std::string const& theme_name,
+            std::vector<IconThemeDir*> const& directories);
+  void LoadUnthemed(std::string const& cache_path,
+                    std::vector<std::string> const& base_dirs);
+
+  // Maps the index cached at cache_path without checking whether it's up to
+  // date. Returns false if the file doesn't contain a valid index.
+  bool Open(std::string const& cache_path);
+
+  void Clear();
+
+  // Returns true if the current index was read from a cache file.
+  bool loaded_from_cache() const;
+
+  // Returns where the given icon file can be found, in (directory, base
+  // directory) order. The result is empty if it can't be found anywhere.
+  absl::Span<Location const> Find(absl::string_view file_name) const;
+
+  // Returns a human readable description of the index contents.
+  std::string Dump() const;
+
+ private:
+  bool Attach(absl::string_view data, size_t directory_count,
+              size_t base_count);
+  bool IsUpToDate(std::vector<std::string> const& base_dirs,
+                  std::string const& theme_name,
+                  std::vector<IconThemeDir*> const& directories) const;
+  void WriteCache(std::string const& cache_path) const;
+
+  std::string built_;
+  util::fs::MappedFile mapped_;
+  absl::string_view data_;
+  bool loaded_from_cache_ = false;
+};
+
+class IconTheme {
+ public:
+  ~IconTheme();
+
+  std::string name;
+  std::vector<std::string> list_inherits;
+  std::vector<IconThemeDir*> list_directories;
+  IconThemeIndex index;
+};
+
+// Returns the directories icon themes (and unthemed icons) are looked up in,
+// in order of precedence.
+std::vector<std::string> IconBaseDirectories();
+
+// Returns the path the index of the given icon theme is cached at.
+std::string IconThemeCachePath(std::string const& theme_name);
+
+// Returns the path the index of the unthemed icons is cached at.
+std::string UnthemedIconsCachePath();
+
+// Returns the file extensions of the icons we know how to load.
+std::vector<std::string> const& IconExtensions();
+
+#endif  // TINT3_LAUNCHER_ICON_THEME_HH
@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "launcher/icon_theme.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+namespace {
+
+IconThemeDir* MakeFixedDir(std::string const& name, int size) {
+  auto dir = new IconThemeDir();
+  dir->name = name;
+  dir->size = dir->min_size = dir->max_size = size;
+  dir->type = IconType::kFixed;
+  dir->threshold = 2;
+  return dir;
+}
+
+}  // namespace
+
+TEST_CASE("IconThemeIndex") {
+  std::vector<std::string> base_dirs{"/tmp/bogus_path",
+                                     "src/launcher/testdata/.icons"};
+
+  SECTION("themed icons") {
+    IconTheme theme;
+    theme.name = "UnitTestTheme";
+    theme.list_directories.push_back(MakeFixedDir("16x16/actions", 16));
+    theme.list_directories.push_back(MakeFixedDir("16x16/apps", 16));
+    theme.list_directories.push_back(MakeFixedDir("16x16/devices", 16));
+    theme.index.Build(base_dirs, theme.name, theme.list_directories);
+
+    auto png = theme.index.Find("unit-test-app.png");
+    REQUIRE(png.size() == 1);
+    REQUIRE(png.front().directory == 1);
+    REQUIRE(png.front().base == 1);
+
+    auto xpm = theme.index.Find("unit-test-app.xpm");
+    REQUIRE(xpm.size() == 1);
+    REQUIRE(xpm.front().directory == 2);
+    REQUIRE(xpm.front().base == 1);
+
+    REQUIRE(theme.index.Find("unit-test-app").empty());
+    REQUIRE(theme.index.Find("unit-test-unthemed.png").empty());
+    REQUIRE(theme.index.Find("index.theme").empty());
+
+    theme.index.Clear();
+    REQUIRE(theme.index.Find("unit-test-app.png").empty());
+  }
+
+  SECTION("unthemed icons") {
+    IconThemeIndex index;
+    index.BuildUnthemed(base_dirs);
+
+    auto png = index.Find("unit-test-unthemed.png");
+    REQUIRE(png.size() == 1);
+    REQUIRE(png.front().base == 1);
+
+    REQUIRE(index.Find("unit-test-app.png").empty());
+  }
+}
+
+TEST_CASE("IconThemeIndex::Load") {
+  TemporaryDirectory temp_dir;
+  std::vector<std::string> base_dirs{temp_dir.path() / "bogus_path",
+                                     temp_dir.path() / "icons"};
+  std::string cache_path{temp_dir.path() / "cache" / "theme.cache"};
+  util::fs::Path apps_dir{temp_dir.path() / "icons" / "Theme" / "apps"};
+  REQUIRE(util::fs::CreateDirectory(apps_dir));
+  REQUIRE(util::fs::WriteFile(apps_dir / "first.png", ""));
+
+  IconTheme theme;
+  theme.name = "Theme";
+  theme.list_directories.push_back(MakeFixedDir("actions", 16));
+  theme.list_directories.push_back(MakeFixedDir("apps", 16));
+
+  auto load = [&](IconThemeIndex* index) {
+    index->Load(cache_path, base_dirs, theme.name, theme.list_directories);
+  };
+
+  // The first load has to build the index, and writes the cache.
+  IconThemeIndex index;
+  load(&index);
+  REQUIRE_FALSE(index.loaded_from_cache());
+  REQUIRE(index.Find("first.png").size() == 1);
+  REQUIRE(index.Find("first.png").front().directory == 1);
+  REQUIRE(util::fs::FileExists(cache_path));
+
+  // Following loads read it back.
+  load(&index);
+  REQUIRE(index.loaded_from_cache());
+  REQUIRE(index.Find("first.png").size() == 1);
+  REQUIRE(index.Find("first.png").front().directory == 1);
+  REQUIRE(index.Find("first.png").front().base == 1);
+  REQUIRE(index.Find("second.png").empty());
+
+  SECTION("stale caches are rebuilt") {
+    REQUIRE(util::fs::WriteFile(apps_dir / "second.png", ""));
+    // Don't depend on the timestamp granularity of the file system.
+    struct stat info;
+    REQUIRE(util::fs::Stat(apps_dir, &info));
+    struct timespec times[2] = {info.st_atim, info.st_mtim};
+    times[1].tv_sec += 10;
+    REQUIRE(utimensat(AT_FDCWD, std::string(apps_dir).c_str(), times,
+                      /* flags= */ 0) == 0);
+
+    load(&index);
+    REQUIRE_FALSE(index.loaded_from_cache());
+    REQUIRE(index.Find("second.png").size() == 1);
+
+    load(&index);
+    REQUIRE(index.loaded_from_cache());
+    REQUIRE(index.Find("second.png").size() == 1);
+  }
+
+  SECTION("caches built for a different theme layout are rebuilt") {
+    theme.list_directories.push_back(MakeFixedDir("devices", 16));
+    load(&index);
+    REQUIRE_FALSE(index.loaded_from_cache());
+    REQUIRE(index.Find("first.png").size() == 1);
+  }
+
+  SECTION("corrupt caches are rebuilt") {
+    std::string contents;
+    {
+      util::fs::MappedFile file;
+      REQUIRE(file.Open(cache_path));
+      contents.assign(file.contents().data(), file.contents().size());
+    }
+
+    std::vector<std::string> corruptions{
+        "",
+        contents.substr(0, contents.size() / 2),
+        contents + "trailing garbage",
+        std::string(contents.size(), 'x'),
+    };
+    // A location pointing past the end of the list of directories: it's the
+    // only one, stored right before the strings.
+    uint32_t strings_size;
+    std::memcpy(&strings_size, contents.data() + 24, sizeof(strings_size));
+    std::string bad_location{contents};
+    bad_location[contents.size() - strings_size - 8] = '\x7f';
+    corruptions.push_back(bad_location);
+
+    for (auto const& corruption : corruptions) {
+      REQUIRE(util::fs::WriteFile(cache_path, corruption));
+      IconThemeIndex other_index;
+      load(&other_index);
+      REQUIRE_FALSE(other_index.loaded_from_cache());
+      REQUIRE(other_index.Find("first.png").size() == 1);
+
+      load(&other_index);
+      REQUIRE(other_index.loaded_from_cache());
+    }
+  }
+
+  SECTION("dump") {
+    IconThemeIndex dumped_index;
+    REQUIRE(dumped_index.Open(cache_path));
+    std::string dump{dumped_index.Dump()};
+    REQUIRE(dump.find(std::string(apps_dir)) != std::string::npos);
+    REQUIRE(dump.find("first.png: 1/1") != std::string::npos);
+  }
+}
@@ -24,6 +24,8 @@
 #include <xsettings-client.h>
 
 #include <algorithm>
+#include <climits>
+#include <clocale>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -32,12 +34,18 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
 
 #include "launcher.hh"
+#include "launcher/application_index.hh"
 #include "launcher/desktop_entry.hh"
 #include "panel.hh"
 #include "server.hh"
@@ -46,6 +54,7 @@
 #include "taskbar/taskbar.hh"
 #include "util/fs.hh"
 #include "util/log.hh"
+#include "util/raster_cache.hh"
 #include "util/xdg.hh"
 
 bool launcher_enabled = false;
@@ -54,6 +63,7 @@ bool launcher_tooltip_enabled;
 int launcher_alpha;
 int launcher_saturation;
 int launcher_brightness;
+int launcher_icon_memory_limit;
 std::string icon_theme_name;
 XSettingsClient* xsettings_client;
 
@@ -61,6 +71,10 @@ namespace {
 
 const char kIconFallback[] = "application-x-executable";
 
+// Icons are mostly decoded and scaled on the worker pool, which doesn't need
+// to be large to hide most of the I/O and decoding latency.
+constexpr unsigned int kMaxIconWorkers = 4;
+
 void XSettingsNotifyCallback(const char* name, XSettingsAction action,
                              XSettingsSetting* setting, void* data) {
   static std::string kIconThemeNameSetting = "Net/IconThemeName";
@@ -87,6 +101,7 @@ void XSettingsNotifyCallback(const char* name, XSettingsAction action,
     launcher.LoadIcons();
     launcher.need_resize_ = true;
   }
+  WatchLauncherFiles();
 }
 
 }  // namespace
@@ -102,6 +117,7 @@ void DefaultLauncher() {
   launcher_alpha = 100;
   launcher_saturation = 0;
   launcher_brightness = 0;
+  launcher_icon_memory_limit = 4096;
   icon_theme_name.clear();
   xsettings_client = nullptr;
 }
@@ -145,6 +161,7 @@ void Launcher::InitPanel(Panel* panel) {
 
 void CleanupLauncher() {
   if (xsettings_client) xsettings_client_destroy(xsettings_client);
+  LauncherFileWatcher().UnwatchAll();
 
   for (Panel& p : panels) {
     p.launcher_.CleanupTheme();
@@ -167,6 +184,7 @@ void Launcher::CleanupTheme() {
     if (theme) delete theme;
   }
   list_themes_.clear();
+  unthemed_icons_.Clear();
 }
 
 int Launcher::GetIconSize() const {
@@ -186,83 +204,358 @@ int Launcher::GetIconSize() const {
   return icon_size;
 }
 
-bool Launcher::Resize() {
-  int icons_per_column = 1, icons_per_row = 1, margin = 0;
-  int icon_size = GetIconSize();
+namespace {
 
-  // Resize icons if necessary
-  for (auto& launcher_icon : list_icons_) {
-    if (launcher_icon->icon_size_ != icon_size ||
-        !launcher_icon->icon_original_) {
-      launcher_icon->icon_size_ = icon_size;
-      launcher_icon->width_ = launcher_icon->icon_size_;
-      launcher_icon->height_ = launcher_icon->icon_size_;
+struct IconAdjustment {
+  int alpha;
+  float saturation;
+  float brightness;
 
-      // Get the path for an icon file with the new size
-      std::string new_icon_path =
-          GetIconPath(launcher_icon->icon_name_, launcher_icon->icon_size_);
+  bool IsNeutral() const {
+    return alpha == 100 && saturation == 0.0f && brightness == 0.0f;
+  }
+};
+
+constexpr IconAdjustment kNoAdjustment{100, 0.0f, 0.0f};
+
+// Describes how the images of a launcher icon are derived from its file.
+// Self-contained, so that it can be handed over to a worker thread.
+struct IconRequest {
+  std::string path;
+  int size;
+  // The launcher_alpha, launcher_saturation and launcher_brightness settings.
+  int alpha;
+  int saturation;
+  int brightness;
+  IconAdjustment hover;
+  IconAdjustment pressed;
+
+  // Returns the raster cache key of the image with the given adjustment
+  // applied on top of the launcher settings.
+  bool MakeKey(IconAdjustment const& adjustment, std::string* key) const {
+    std::string variant{absl::StrFormat("%dx%d asb(%d,%d,%d)", size, size,
+                                        alpha, saturation, brightness)};
+    if (!adjustment.IsNeutral()) {
+      absl::StrAppendFormat(&variant, " asb(%d,%g,%g)", adjustment.alpha,
+                            adjustment.saturation, adjustment.brightness);
+    }
+    return util::RasterCache::MakeKey(path, variant, key);
+  }
+};
+
+IconRequest MakeIconRequest(std::string const& path, int size,
+                            IconAdjustment const& hover,
+                            IconAdjustment const& pressed) {
+  return IconRequest{path,
+                     size,
+                     launcher_alpha,
+                     launcher_saturation,
+                     launcher_brightness,
+                     hover,
+                     pressed};
+}
 
-      if (new_icon_path.empty()) {
-        // Draw a blank icon
-        launcher_icon->icon_original_.Free();
-        launcher_icon->icon_scaled_.Free();
-        launcher_icon->icon_hover_.Free();
-        launcher_icon->icon_pressed_.Free();
-        new_icon_path = GetIconPath(kIconFallback, launcher_icon->icon_size_);
+bool LoadCachedRaster(std::string const& key, int size,
+                      util::RasterCache::Raster* raster) {
+  return util::IconRasterCache().Load(key, raster) &&
+         raster->width() == static_cast<unsigned int>(size) &&
+         raster->height() == static_cast<unsigned int>(size);
+}
 
-        if (!new_icon_path.empty()) {
-          launcher_icon->icon_original_ =
-              imlib_load_image(new_icon_path.c_str());
+void StoreCachedRaster(std::string const& key, int size,
+                       DATA32 const* pixels) {
+  static_assert(sizeof(DATA32) == sizeof(uint32_t), "unexpected DATA32 size");
+  util::IconRasterCache().Store(key, size, size,
+                                reinterpret_cast<uint32_t const*>(pixels));
+}
 
-          util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                             << new_icon_path.c_str() << '\n';
-        }
+// Returns the icon described by the request, with the given adjustment
+// applied on top of the launcher settings. The result is read from the raster
+// cache when possible, and only decodes the source icon (once) otherwise.
+// Goes through Imlib2, so it must run on the main thread.
+util::imlib2::Image LoadIconImage(LauncherIcon* launcher_icon,
+                                  IconRequest const& request,
+                                  IconAdjustment const& adjustment) {
+  std::string key;
+  bool cacheable = !request.path.empty() && request.MakeKey(adjustment, &key);
+
+  util::RasterCache::Raster raster;
+  if (cacheable && LoadCachedRaster(key, request.size, &raster)) {
+    util::imlib2::Image image{util::imlib2::Image::FromPixels(
+        request.size, request.size,
+        reinterpret_cast<DATA32 const*>(raster.pixels()))};
+    if (image) {
+      return image;
+    }
+  }
 
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, icon_size);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
-        if (new_panel_config.mouse_effects) {
-          launcher_icon->icon_hover_.AdjustASB(
-              new_panel_config.mouse_hover_alpha,
-              new_panel_config.mouse_hover_saturation / 100.0f,
-              new_panel_config.mouse_hover_brightness / 100.0f);
-        }
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        if (new_panel_config.mouse_effects) {
-          launcher_icon->icon_pressed_.AdjustASB(
-              new_panel_config.mouse_pressed_alpha,
-              new_panel_config.mouse_pressed_saturation / 100.0f,
-              new_panel_config.mouse_pressed_brightness / 100.0f);
-        }
-        continue;
-      }
+  if (!launcher_icon->icon_original_ ||
+      request.path != launcher_icon->icon_path_) {
+    launcher_icon->icon_original_ =
+        request.path.empty() ? nullptr : imlib_load_image(request.path.c_str());
+    launcher_icon->icon_path_ = request.path;
+  }
+
+  util::imlib2::Image image{
+      ScaleIcon(launcher_icon->icon_original_, request.size)};
+  if (!adjustment.IsNeutral()) {
+    image.AdjustASB(adjustment.alpha, adjustment.saturation,
+                    adjustment.brightness);
+  }
+
+  // Only cache actual icons, not the blank one drawn when loading fails.
+  if (cacheable && launcher_icon->icon_original_) {
+    imlib_context_set_image(image);
+    StoreCachedRaster(key, request.size,
+                      imlib_image_get_data_for_reading_only());
+  }
+  return image;
+}
+
+// Sets the scaled, hover and pressed images of the launcher icon as described
+// by the request (blank ones if its path is empty).
+void LoadIconImages(LauncherIcon* launcher_icon, IconRequest const& request) {
+  auto adjusted = [&](IconAdjustment const& adjustment) {
+    if (adjustment.IsNeutral()) {
+      return launcher_icon->icon_scaled_;
+    }
+    return LoadIconImage(launcher_icon, request, adjustment);
+  };
+
+  launcher_icon->icon_scaled_ =
+      LoadIconImage(launcher_icon, request, kNoAdjustment);
+  launcher_icon->icon_hover_ = adjusted(request.hover);
+  launcher_icon->icon_pressed_ = adjusted(request.pressed);
+}
 
-      if (!launcher_icon->icon_path_.empty() &&
-          new_icon_path == launcher_icon->icon_path_) {
-        // If it's the same file just rescale
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, icon_size);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_hover_.AdjustASB(100, 0.0, +0.1);
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_pressed_.AdjustASB(100, 0.0, -0.1);
-
-        util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                           << launcher_icon->icon_path_ << '\n';
+// Straight ARGB32 pixels of the scaled, hover and pressed images of an icon.
+struct IconRasters {
+  std::vector<DATA32> scaled;
+  std::vector<DATA32> hover;
+  std::vector<DATA32> pressed;
+};
+
+// Launcher icons currently holding images, least recently drawn first, and
+// the total memory held by those images.
+std::list<LauncherIcon*> icons_by_use;
+size_t icon_image_bytes = 0;
+
+size_t ImageBytes(Imlib_Image image) {
+  if (!image) {
+    return 0;
+  }
+  imlib_context_set_image(image);
+  return sizeof(DATA32) * imlib_image_get_width() * imlib_image_get_height();
+}
+
+// Marks the launcher icon as the most recently drawn one.
+void TouchIcon(LauncherIcon* launcher_icon) {
+  icons_by_use.remove(launcher_icon);
+  icons_by_use.push_back(launcher_icon);
+}
+
+void UntrackIcon(LauncherIcon* launcher_icon) {
+  icons_by_use.remove(launcher_icon);
+  icon_image_bytes -= launcher_icon->icon_image_bytes_;
+  launcher_icon->icon_image_bytes_ = 0;
+}
+
+// Accounts for the images just loaded into the launcher icon, then frees the
+// images of the least recently drawn icons until launcher_icon_memory_limit
+// is met again. Evicted icons keep showing what they last drew, and only load
+// their images again when they have to be redrawn.
+void TrackIcon(LauncherIcon* launcher_icon) {
+  UntrackIcon(launcher_icon);
+  launcher_icon->icon_image_bytes_ = ImageBytes(launcher_icon->icon_original_) +
+                                     ImageBytes(launcher_icon->icon_scaled_) +
+                                     ImageBytes(launcher_icon->icon_hover_) +
+                                     ImageBytes(launcher_icon->icon_pressed_);
+  icon_image_bytes += launcher_icon->icon_image_bytes_;
+  icons_by_use.push_back(launcher_icon);
+
+  if (launcher_icon_memory_limit <= 0) {
+    return;
+  }
+  size_t limit = static_cast<size_t>(launcher_icon_memory_limit) * 1024;
+  while (icon_image_bytes > limit && icons_by_use.front() != launcher_icon) {
+    icons_by_use.front()->FreeImages();
+  }
+}
+
+// Sets the images of the launcher icon from the rasters.
+void SetIconImages(LauncherIcon* launcher_icon, IconRequest const& request,
+                   IconRasters const& rasters) {
+  int size = request.size;
+  launcher_icon->icon_scaled_ =
+      util::imlib2::Image::FromPixels(size, size, rasters.scaled.data());
+  launcher_icon->icon_hover_ =
+      util::imlib2::Image::FromPixels(size, size, rasters.hover.data());
+  launcher_icon->icon_pressed_ =
+      util::imlib2::Image::FromPixels(size, size, rasters.pressed.data());
+  launcher_icon->icon_path_ = request.path;
+}
+
+// Decodes the PNG file at the given path with cairo (which, unlike Imlib2,
+// can safely be used from several threads at once), scaled to size x size.
+bool DecodePNG(std::string const& path, int size, std::vector<DATA32>* pixels) {
+  cairo_surface_t* source = cairo_image_surface_create_from_png(path.c_str());
+  if (cairo_surface_status(source) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(source);
+    return false;
+  }
+
+  cairo_surface_t* target =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+  cairo_t* c = cairo_create(target);
+  cairo_scale(c, static_cast<double>(size) /
+                     cairo_image_surface_get_width(source),
+              static_cast<double>(size) /
+                  cairo_image_surface_get_height(source));
+  cairo_set_source_surface(c, source, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(c), CAIRO_FILTER_GOOD);
+  cairo_set_operator(c, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(c);
+  cairo_destroy(c);
+  cairo_surface_destroy(source);
+
+  cairo_surface_flush(target);
+  bool success = (cairo_surface_status(target) == CAIRO_STATUS_SUCCESS);
+  if (success) {
+    unsigned char const* data = cairo_image_surface_get_data(target);
+    int stride = cairo_image_surface_get_stride(target);
+    pixels->resize(size * size);
+    for (int y = 0; y < size; ++y) {
+      std::memcpy(&(*pixels)[y * size], data + y * stride,
+                  size * sizeof(DATA32));
+    }
+    UnpremultiplyAlpha(pixels->data(), size, size);
+  }
+  cairo_surface_destroy(target);
+  return success;
+}
+
+// Thread-safe counterpart of LoadIconImages(), which produces raw pixels
+// instead of Imlib2 images. Returns false if the icon can't be loaded this
+// way (e.g. it's not a PNG file), in which case LoadIconImages() has to take
+// over on the main thread. Without allow_decoding, only succeeds if all the
+// images are found in the raster cache.
+bool LoadIconRasters(IconRequest const& request, IconRasters* rasters,
+                     bool allow_decoding) {
+  struct {
+    IconAdjustment const& adjustment;
+    std::vector<DATA32>* pixels;
+    std::string key;
+    bool cached;
+  } images[] = {
+      {kNoAdjustment, &rasters->scaled, {}, false},
+      {request.hover, &rasters->hover, {}, false},
+      {request.pressed, &rasters->pressed, {}, false},
+  };
+
+  bool all_cached = true;
+  for (auto& image : images) {
+    if (!request.MakeKey(image.adjustment, &image.key)) {
+      return false;
+    }
+    util::RasterCache::Raster raster;
+    image.cached = LoadCachedRaster(image.key, request.size, &raster);
+    if (image.cached) {
+      image.pixels->assign(raster.pixels(),
+                           raster.pixels() + request.size * request.size);
+    }
+    all_cached = all_cached && image.cached;
+  }
+  if (all_cached) {
+    return true;
+  }
+  if (!allow_decoding) {
+    return false;
+  }
+
+  std::vector<DATA32> scaled;
+  if (!absl::EndsWith(request.path, ".png") ||
+      !DecodePNG(request.path, request.size, &scaled)) {
+    return false;
+  }
+  AdjustASB(scaled.data(), request.size, request.size, request.alpha,
+            request.saturation / 100.0f, request.brightness / 100.0f);
+
+  for (auto& image : images) {
+    if (image.cached) {
+      continue;
+    }
+    image.pixels->assign(scaled.begin(), scaled.end());
+    if (!image.adjustment.IsNeutral()) {
+      AdjustASB(image.pixels->data(), request.size, request.size,
+                image.adjustment.alpha, image.adjustment.saturation,
+                image.adjustment.brightness);
+    }
+    StoreCachedRaster(image.key, request.size, image.pixels->data());
+  }
+  return true;
+}
+
+// Loads the images of the launcher icon as described by the request. Cached
+// images are read right away; otherwise they are loaded on the worker pool and
+// swapped in once done, and the icon is drawn empty in the meantime.
+void LoadIconImagesAsync(LauncherIcon* launcher_icon,
+                         IconRequest const& request) {
+  launcher_icon->FreeImages();
+
+  IconRasters cached_rasters;
+  if (request.path.empty()) {
+    // Nothing to decode, just draw a blank icon.
+    LoadIconImages(launcher_icon, request);
+    TrackIcon(launcher_icon);
+    return;
+  }
+  if (LoadIconRasters(request, &cached_rasters, /* allow_decoding= */ false)) {
+    SetIconImages(launcher_icon, request, cached_rasters);
+    TrackIcon(launcher_icon);
+    return;
+  }
+
+  launcher_icon->icon_loading_ = true;
+  LauncherWorkerPool().Submit(launcher_icon, [launcher_icon, request] {
+    auto rasters = std::make_shared<IconRasters>();
+    bool loaded =
+        LoadIconRasters(request, rasters.get(), /* allow_decoding= */ true);
+
+    return [launcher_icon, request, rasters, loaded] {
+      launcher_icon->icon_loading_ = false;
+      if (loaded) {
+        SetIconImages(launcher_icon, request, *rasters);
       } else {
-        // Load the new file and scale
-        launcher_icon->icon_original_ = imlib_load_image(new_icon_path.c_str());
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, launcher_icon->icon_size_);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_hover_.AdjustASB(100, 0.0, +0.1);
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_pressed_.AdjustASB(100, 0.0, -0.1);
-        launcher_icon->icon_path_ = new_icon_path;
-
-        util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                           << launcher_icon->icon_path_ << '\n';
+        LoadIconImages(launcher_icon, request);
       }
+      TrackIcon(launcher_icon);
+      launcher_icon->need_redraw_ = true;
+      panel_refresh = true;
+    };
+  });
+}
+
+}  // namespace
+
+util::WorkerPool& LauncherWorkerPool() {
+  static util::WorkerPool pool{std::min(
+      std::max(std::thread::hardware_concurrency(), 1U), kMaxIconWorkers)};
+  return pool;
+}
+
+bool Launcher::Resize() {
+  int icons_per_column = 1, icons_per_row = 1, margin = 0;
+  int icon_size = GetIconSize();
+
+  // Resize icons if necessary. Their images are only loaded once they are
+  // drawn at the new size.
+  for (auto& launcher_icon : list_icons_) {
+    if (launcher_icon->icon_size_ != icon_size) {
+      launcher_icon->icon_size_ = icon_size;
+      launcher_icon->width_ = launcher_icon->icon_size_;
+      launcher_icon->height_ = launcher_icon->icon_size_;
+      launcher_icon->need_redraw_ = true;
+      launcher_icon->FreeImages();
     }
   }
 
@@ -338,8 +631,71 @@ bool Launcher::Resize() {
   return true;
 }
 
+std::string Launcher::ResolveIconPath(LauncherIcon const* launcher_icon,
+                                      bool* is_fallback) {
+  // Get the path for an icon file with the current size
+  std::string icon_path =
+      GetIconPath(launcher_icon->icon_name_, launcher_icon->icon_size_);
+  if (is_fallback != nullptr) {
+    (*is_fallback) = icon_path.empty();
+  }
+  if (icon_path.empty()) {
+    // Use the fallback icon, or a blank one if there's none
+    icon_path = GetIconPath(kIconFallback, launcher_icon->icon_size_);
+  }
+  return icon_path;
+}
+
+void Launcher::RequestIconImages(LauncherIcon* launcher_icon) {
+  bool is_fallback;
+  std::string icon_path = ResolveIconPath(launcher_icon, &is_fallback);
+
+  if (is_fallback) {
+    IconAdjustment hover{kNoAdjustment}, pressed{kNoAdjustment};
+    if (new_panel_config.mouse_effects) {
+      hover = IconAdjustment{new_panel_config.mouse_hover_alpha,
+                             new_panel_config.mouse_hover_saturation / 100.0f,
+                             new_panel_config.mouse_hover_brightness / 100.0f};
+      pressed =
+          IconAdjustment{new_panel_config.mouse_pressed_alpha,
+                         new_panel_config.mouse_pressed_saturation / 100.0f,
+                         new_panel_config.mouse_pressed_brightness / 100.0f};
+    }
+    LoadIconImagesAsync(launcher_icon,
+                        MakeIconRequest(icon_path, launcher_icon->icon_size_,
+                                        hover, pressed));
+  } else {
+    LoadIconImagesAsync(
+        launcher_icon,
+        MakeIconRequest(icon_path, launcher_icon->icon_size_,
+                        IconAdjustment{100, 0.0f, +0.1f},
+                        IconAdjustment{100, 0.0f, -0.1f}));
+  }
+
+  if (!icon_path.empty()) {
+    util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
+                       << icon_path << '\n';
+  }
+}
+
 LauncherIcon::LauncherIcon() : Area() { set_has_mouse_effects(true); }
 
+LauncherIcon::~LauncherIcon() {
+  // Pending loads and the memory accounting reference this icon.
+  FreeImages();
+}
+
+void LauncherIcon::FreeImages() {
+  LauncherWorkerPool().Cancel(this);
+  icon_loading_ = false;
+
+  icon_original_.Free();
+  icon_scaled_.Free();
+  icon_hover_.Free();
+  icon_pressed_.Free();
+  UntrackIcon(this);
+}
+
 // Here we override the default layout of the icons; normally Area layouts its
 // children
 // in a stack; we need to layout them in a kind of table
@@ -353,6 +709,19 @@ std::string LauncherIcon::GetTooltipText() {
 }
 
 void LauncherIcon::DrawForeground(cairo_t* c) {
+  if (!icon_scaled_) {
+    // Load the images on the first draw, but not for icons overflowing the
+    // panel, which are never seen.
+    if (!icon_loading_ && panel_x_ < static_cast<int>(panel_->width_) &&
+        panel_y_ < static_cast<int>(panel_->height_)) {
+      static_cast<Launcher*>(parent_)->RequestIconImages(this);
+    }
+    if (!icon_scaled_) {
+      return;
+    }
+  }
+  TouchIcon(this);
+
   Imlib_Image image = icon_scaled_;
   if (new_panel_config.mouse_effects) {
     if (mouse_state() == MouseState::kMouseOver)
@@ -373,10 +742,12 @@ bool LauncherIcon::OnClick(XEvent* event) {
   sn.set_name(icon_tooltip_);
   sn.Initiate(cmd_, event->xbutton.time);
 
-  pid_t child_pid = ShellExec(cmd_, child_callback{[&sn] {
-                                sn.IncrementRef();
-                                sn.SetupChildProcess();
-                              }});
+  std::vector<std::pair<std::string, std::string>> environment;
+  std::string startup_id = sn.startup_id();
+  if (!startup_id.empty()) {
+    environment.emplace_back("DESKTOP_STARTUP_ID", startup_id);
+  }
+  pid_t child_pid = ShellExec(cmd_, environment_overrides{environment});
 
 #if HAVE_SN
   if (child_pid > 0) {
@@ -438,12 +809,6 @@ bool ParseThemeLine(std::string const& line, std::string& key,
   return (found && !key.empty() && !value.empty());
 }
 
-IconTheme::~IconTheme() {
-  for (auto const& dir : list_directories) {
-    delete dir;
-  }
-}
-
 // TODO Use UTF8 when parsing the file
 IconTheme* LoadTheme(std::string const& name) {
   if (name.empty()) {
@@ -642,22 +1007,51 @@ void ExpandExec(launcher::desktop_entry::Group* group,
   group->AddEntry("Exec", expanded);
 }
 
+// Reads the first group of the desktop entry, which is all the launcher needs.
 bool ParseDesktopFile(std::string const& contents,
-                      launcher::desktop_entry::DesktopEntry* output) {
-  launcher::desktop_entry::Parser desktop_entry_parser;
-  parser::Parser p{launcher::desktop_entry::kLexer, &desktop_entry_parser};
-  if (!p.Parse(contents)) {
-    return false;
+                      launcher::desktop_entry::Group* output) {
+  const char* locale = setlocale(LC_MESSAGES, nullptr);
+  return launcher::desktop_entry::ParseFirstGroup(
+      contents, (locale != nullptr) ? locale : "", output);
+}
+
+// Directories searched for desktop entries, by order of precedence.
+std::vector<std::string> ApplicationDirectories() {
+  std::vector<std::string> directories{
+      util::xdg::basedir::DataHome() / "applications",
+      util::fs::HomeDirectory() / ".local" / "share" / "applications",
+      "/usr/local/share/applications",
+      "/usr/share/applications",
+      "/opt/share/applications",
+  };
+  for (auto const& dir : util::xdg::basedir::DataDirs()) {
+    directories.push_back(util::fs::Path{dir} / "applications");
   }
 
-  launcher::desktop_entry::DesktopEntry desktop_entry{
-      desktop_entry_parser.GetDesktopEntry()};
-  output->assign(desktop_entry.begin(), desktop_entry.end());
-  return true;
+  // Only the first occurrence of each directory matters.
+  std::vector<std::string> unique_directories;
+  for (auto const& dir : directories) {
+    if (std::find(unique_directories.begin(), unique_directories.end(), dir) ==
+        unique_directories.end()) {
+      unique_directories.push_back(dir);
+    }
+  }
+  return unique_directories;
 }
 
 }  // namespace
 
+ApplicationIndex& DesktopEntryIndex() {
+  static ApplicationIndex index;
+
+  // Rebuilt whenever the XDG directories change.
+  std::vector<std::string> directories{ApplicationDirectories()};
+  if (directories != index.directories()) {
+    index.Build(directories);
+  }
+  return index;
+}
+
 bool FindDesktopEntry(std::string const& name, std::string* output_path) {
   // First, check if the given parameter is already a valid path
   if (util::fs::FileExists(name)) {
@@ -665,96 +1059,298 @@ bool FindDesktopEntry(std::string const& name, std::string* output_path) {
     return true;
   }
 
-  // Second, try and find the given .desktop entry name in a standard location
-  std::vector<std::string> candidates = {
-      util::xdg::basedir::DataHome() / "applications" / name,
-      util::fs::HomeDirectory() / ".local" / "share" / "applications" / name,
-      util::fs::Path("/usr/local/share/applications") / name,
-      util::fs::Path("/usr/share/applications") / name,
-      util::fs::Path("/opt/share/applications") / name,
-  };
+  // Second, look up the given desktop file ID in the application directories
+  return DesktopEntryIndex().Find(name, output_path);
+}
 
-  auto it = std::find_if(
-      candidates.begin(), candidates.end(),
-      [](util::fs::Path const& item) { return util::fs::FileExists(item); });
-  if (it != candidates.end()) {
-    output_path->assign(*it);
-    return true;
+namespace {
+
+// Changes reported by the file watcher, applied once all the pending events
+// have been read.
+struct PendingChanges {
+  // Desktop entries (or any file in the directories they're in).
+  std::set<std::string> desktop_files;
+  bool all_desktop_files = false;
+  // Files in the icon theme directories.
+  std::set<std::string> icon_files;
+  bool icon_themes = false;
+  // Whether the set of directories to watch changed.
+  bool directories = false;
+};
+
+PendingChanges pending_changes;
+
+void OnApplicationDirectoryChange(std::string const& directory,
+                                  std::string const& name) {
+  if (name.empty()) {
+    // Events were lost: rebuild the whole index.
+    DesktopEntryIndex().Clear();
+    pending_changes.all_desktop_files = true;
+    pending_changes.directories = true;
+    return;
   }
 
-  for (auto const& dir : util::xdg::basedir::DataDirs()) {
-    std::string resolved_path = util::fs::Path{dir} / "applications" / name;
-    if (util::fs::FileExists(resolved_path)) {
-      output_path->assign(resolved_path);
-      return true;
+  if (DesktopEntryIndex().Update(directory, name)) {
+    pending_changes.directories = true;
+  }
+  pending_changes.desktop_files.insert(util::fs::Path{directory} / name);
+}
+
+void OnDesktopFileDirectoryChange(std::string const& directory,
+                                  std::string const& name) {
+  if (name.empty()) {
+    pending_changes.all_desktop_files = true;
+    return;
+  }
+  pending_changes.desktop_files.insert(util::fs::Path{directory} / name);
+}
+
+void OnIconDirectoryChange(std::string const& directory,
+                           std::string const& name) {
+  pending_changes.icon_themes = true;
+  if (!name.empty()) {
+    pending_changes.icon_files.insert(util::fs::Path{directory} / name);
+  }
+}
+
+}  // namespace
+
+util::FileWatcher& LauncherFileWatcher() {
+  static util::FileWatcher watcher;
+  return watcher;
+}
+
+void WatchLauncherFiles() {
+  util::FileWatcher& watcher = LauncherFileWatcher();
+  watcher.UnwatchAll();
+  if (!launcher_enabled || !watcher.IsAlive()) {
+    return;
+  }
+
+  std::set<std::string> application_dirs;
+  for (auto const& dir : DesktopEntryIndex().indexed_directories()) {
+    if (application_dirs.insert(dir.path).second) {
+      watcher.WatchDirectory(dir.path, OnApplicationDirectoryChange);
+    }
+  }
+
+  // Launcher items given as paths can be anywhere, watch the directories
+  // they're in (even if they don't exist yet).
+  std::set<std::string> desktop_file_dirs;
+  std::set<std::string> icon_dirs;
+  std::vector<std::string> base_dirs{IconBaseDirectories()};
+
+  for (Panel& p : panels) {
+    Launcher& launcher = p.launcher_;
+    for (auto const& app : launcher.list_apps_) {
+      std::string path;
+      if (!FindDesktopEntry(app, &path)) {
+        if (app.find('/') == std::string::npos) {
+          continue;
+        }
+        path = app;
+      }
+      std::string dir{util::fs::Path{path}.DirectoryName()};
+      if (application_dirs.count(dir) == 0 &&
+          desktop_file_dirs.insert(dir).second) {
+        watcher.WatchDirectory(dir, OnDesktopFileDirectoryChange);
+      }
+    }
+
+    // The same directories the icon theme indexes are built from, plus the
+    // base directories for themes coming and going.
+    for (auto const& base_dir : base_dirs) {
+      std::vector<std::string> dirs{base_dir};
+      for (auto const& theme : launcher.list_themes_) {
+        util::fs::Path theme_dir{util::fs::Path{base_dir} / theme->name};
+        dirs.push_back(theme_dir);
+        for (auto const& dir : theme->list_directories) {
+          dirs.push_back(theme_dir / dir->name);
+        }
+      }
+      for (auto const& dir : dirs) {
+        if (icon_dirs.insert(dir).second) {
+          watcher.WatchDirectory(dir, OnIconDirectoryChange);
+        }
+      }
+    }
+  }
+}
+
+void HandleLauncherFileChanges() {
+  LauncherFileWatcher().ProcessEvents();
+
+  PendingChanges changes;
+  std::swap(changes, pending_changes);
+
+  for (Panel& p : panels) {
+    Launcher& launcher = p.launcher_;
+    if (changes.icon_themes) {
+      launcher.ReloadThemes(changes.icon_files);
+    }
+    if (changes.all_desktop_files) {
+      for (auto const& launcher_icon : launcher.list_icons_) {
+        changes.desktop_files.insert(launcher_icon->desktop_file_path_);
+      }
+    }
+    if (!changes.desktop_files.empty() || changes.all_desktop_files) {
+      launcher.ReloadIcons(changes.desktop_files);
     }
   }
 
-  // Give up and fail
-  return false;
+  // Themes may have been added or gained directories.
+  if (changes.directories || changes.icon_themes) {
+    WatchLauncherFiles();
+  }
 }
 
 // Populates the list_icons list
 void Launcher::LoadIcons() {
   // Load apps (.desktop style launcher items)
-  for (auto const& path : list_apps_) {
+  for (auto const& app : list_apps_) {
+    LauncherIcon* launcher_icon = LoadIcon(app);
+    if (launcher_icon != nullptr) {
+      list_icons_.push_back(launcher_icon);
+      AddChild(launcher_icon);
+    }
+  }
+}
+
+LauncherIcon* Launcher::LoadIcon(std::string const& path) {
+  std::string resolved_path;
+  if (!FindDesktopEntry(path, &resolved_path)) {
+    util::log::Error() << "File \"" << path << "\" not found, skipping\n";
+    return nullptr;
+  }
+
+  LauncherIcon* launcher_icon = nullptr;
+  util::fs::ReadFile(resolved_path, [&](std::string const& contents) {
+    launcher::desktop_entry::Group de{
+        launcher::desktop_entry::Group::kInvalidName};
+    if (!ParseDesktopFile(contents, &de)) {
+      util::log::Error() << "Failed parsing \"" << path << "\", skipping.\n";
+      return false;
+    }
+
+    if (!de.IsEntry<std::string>("Type") ||
+        de.GetEntry<std::string>("Type") != "Application") {
+      util::log::Error() << "Desktop entry \"" << path << "\" not of type "
+                         << "\"Application\", skipping.\n";
+      return false;
+    }
+
+    if (de.IsEntry<std::string>("Exec")) {
+      ExpandExec(&de, path);
+
+      launcher_icon = new LauncherIcon();
+      launcher_icon->parent_ = this;
+      launcher_icon->panel_ = panel_;
+      launcher_icon->size_mode_ = SizeMode::kByContent;
+      launcher_icon->need_resize_ = false;
+      launcher_icon->need_redraw_ = true;
+      launcher_icon->bg_ = backgrounds.front();
+      launcher_icon->on_screen_ = true;
+
+      launcher_icon->is_app_desktop_ = true;
+      launcher_icon->app_ = path;
+      launcher_icon->desktop_file_path_ = resolved_path;
+      launcher_icon->cmd_ = de.GetEntry<std::string>("Exec");
+      launcher_icon->icon_name_ = de.HasEntry("Icon")
+                                      ? de.GetEntry<std::string>("Icon")
+                                      : kIconFallback;
+      launcher_icon->icon_size_ = 1;
+      if (de.HasEntry("Comment")) {
+        launcher_icon->icon_tooltip_ =
+            launcher::desktop_entry::BestLocalizedEntry(de, "Comment");
+      } else if (de.HasEntry("Name")) {
+        launcher_icon->icon_tooltip_ =
+            launcher::desktop_entry::BestLocalizedEntry(de, "Name");
+      } else {
+        launcher_icon->icon_tooltip_ = de.GetEntry<std::string>("Exec");
+      }
+    }
+
+    return true;
+  });
+  return launcher_icon;
+}
+
+void Launcher::ReloadIcons(std::set<std::string> const& changed_paths) {
+  std::vector<LauncherIcon*> old_icons;
+  old_icons.swap(list_icons_);
+  bool changed = false;
+
+  for (auto const& app : list_apps_) {
+    auto it = std::find_if(old_icons.begin(), old_icons.end(),
+                           [&](LauncherIcon* launcher_icon) {
+                             return (launcher_icon != nullptr &&
+                                     launcher_icon->app_ == app);
+                           });
+    LauncherIcon* launcher_icon = nullptr;
+    if (it != old_icons.end()) {
+      std::swap(launcher_icon, *it);
+    }
+
+    // Keep icons whose desktop entry is unchanged as they are.
     std::string resolved_path;
-    if (!FindDesktopEntry(path, &resolved_path)) {
-      util::log::Error() << "File \"" << path << "\" not found, skipping\n";
+    if (launcher_icon != nullptr && FindDesktopEntry(app, &resolved_path) &&
+        resolved_path == launcher_icon->desktop_file_path_ &&
+        changed_paths.count(resolved_path) == 0) {
+      list_icons_.push_back(launcher_icon);
       continue;
     }
 
-    util::fs::ReadFile(resolved_path, [&](std::string const& contents) {
-      launcher::desktop_entry::DesktopEntry entry;
-      if (!ParseDesktopFile(contents, &entry)) {
-        util::log::Error() << "Failed parsing \"" << path << "\", skipping.\n";
-        return false;
-      }
+    if (launcher_icon != nullptr) {
+      RemoveChild(launcher_icon);
+      delete launcher_icon;
+      changed = true;
+    }
+    launcher_icon = LoadIcon(app);
+    if (launcher_icon != nullptr) {
+      list_icons_.push_back(launcher_icon);
+      AddChild(launcher_icon);
+      changed = true;
+    }
+  }
 
-      // Reference to the first group, "Desktop Entry".
-      auto& de = entry[0];
+  for (auto const& launcher_icon : old_icons) {
+    if (launcher_icon != nullptr) {
+      RemoveChild(launcher_icon);
+      delete launcher_icon;
+      changed = true;
+    }
+  }
 
-      if (!de.IsEntry<std::string>("Type") ||
-          de.GetEntry<std::string>("Type") != "Application") {
-        util::log::Error() << "Desktop entry \"" << path << "\" not of type "
-                           << "\"Application\", skipping.\n";
-        return false;
-      }
+  if (changed) {
+    // Reloaded icons keep their place.
+    children_.assign(list_icons_.begin(), list_icons_.end());
+    need_resize_ = true;
+    panel_refresh = true;
+  }
+}
 
-      if (de.IsEntry<std::string>("Exec")) {
-        ExpandExec(&de, path);
-
-        auto launcher_icon = new LauncherIcon();
-        launcher_icon->parent_ = this;
-        launcher_icon->panel_ = panel_;
-        launcher_icon->size_mode_ = SizeMode::kByContent;
-        launcher_icon->need_resize_ = false;
-        launcher_icon->need_redraw_ = true;
-        launcher_icon->bg_ = backgrounds.front();
-        launcher_icon->on_screen_ = true;
-
-        launcher_icon->is_app_desktop_ = true;
-        launcher_icon->cmd_ = de.GetEntry<std::string>("Exec");
-        launcher_icon->icon_name_ = de.HasEntry("Icon")
-                                        ? de.GetEntry<std::string>("Icon")
-                                        : kIconFallback;
-        launcher_icon->icon_size_ = 1;
-        if (de.HasEntry("Comment")) {
-          launcher_icon->icon_tooltip_ =
-              launcher::desktop_entry::BestLocalizedEntry(de, "Comment");
-        } else if (de.HasEntry("Name")) {
-          launcher_icon->icon_tooltip_ =
-              launcher::desktop_entry::BestLocalizedEntry(de, "Name");
-        } else {
-          launcher_icon->icon_tooltip_ = de.GetEntry<std::string>("Exec");
-        }
+void Launcher::ReloadThemes(std::set<std::string> const& changed_paths) {
+  for (auto const& theme : list_themes_) {
+    delete theme;
+  }
+  list_themes_.clear();
+  unthemed_icons_.Clear();
 
-        list_icons_.push_back(launcher_icon);
-        AddChild(launcher_icon);
-      }
+  // Indexes of unchanged themes are read back from their caches.
+  LoadThemes();
 
-      return true;
-    });
+  for (auto& launcher_icon : list_icons_) {
+    if (!launcher_icon->icon_scaled_ && !launcher_icon->icon_loading_) {
+      // Resolved when drawn next.
+      continue;
+    }
+    if (launcher_icon->icon_loading_ ||
+        changed_paths.count(launcher_icon->icon_path_) != 0 ||
+        ResolveIconPath(launcher_icon, nullptr) != launcher_icon->icon_path_) {
+      launcher_icon->FreeImages();
+      launcher_icon->need_redraw_ = true;
+      panel_refresh = true;
+    }
   }
 }
 
@@ -770,6 +1366,7 @@ bool Launcher::LoadThemes() {
     util::log::Error() << "Loading \"" << icon_theme_name << "\". Icon theme:";
   }
 
+  std::vector<std::string> base_dirs{IconBaseDirectories()};
   std::list<std::string> queue{icon_theme_name};
   std::set<std::string> queued{icon_theme_name};
   bool icon_theme_name_loaded = false;
@@ -794,6 +1391,8 @@ bool Launcher::LoadThemes() {
       continue;
     }
 
+    theme->index.Load(IconThemeCachePath(theme->name), base_dirs, theme->name,
+                      theme->list_directories);
     list_themes_.push_back(theme);
     if (name == icon_theme_name) {
       icon_theme_name_loaded = true;
@@ -808,6 +1407,8 @@ bool Launcher::LoadThemes() {
     }
   }
 
+  unthemed_icons_.LoadUnthemed(UnthemedIconsCachePath(), base_dirs);
+
   util::log::Error() << '\n';
   return icon_theme_name_loaded;
 }
@@ -860,16 +1461,8 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
     return std::string();
   }
 
-  std::vector<std::string> basenames{
-      util::fs::HomeDirectory() / ".icons",
-      util::fs::HomeDirectory() / ".local" / "share" / "icons",
-      "/usr/local/share/icons",
-      "/usr/local/share/pixmaps",
-      "/usr/share/icons",
-      "/usr/share/pixmaps",
-  };
-
-  std::vector<std::string> extensions{".png", ".xpm"};
+  std::vector<std::string> basenames{IconBaseDirectories()};
+  std::vector<std::string> extensions{IconExtensions()};
 
   // if the icon name already contains one of the extensions (e.g. vlc.png
   // instead of vlc) add a special entry
@@ -882,6 +1475,31 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
     }
   }
 
+  // The themes are indexed by file name, so gather the locations of all the
+  // candidate file names and visit them in the same order as walking the
+  // directories would: theme directory, then base directory, then extension.
+  struct Candidate {
+    IconThemeIndex::Location location;
+    unsigned int extension;
+
+    bool operator<(Candidate const& other) const {
+      return std::tie(location.directory, location.base, extension) <
+             std::tie(other.location.directory, other.location.base,
+                      other.extension);
+    }
+  };
+
+  auto find_candidates = [&](IconThemeIndex const& index) {
+    std::vector<Candidate> candidates;
+    for (unsigned int i = 0; i < extensions.size(); ++i) {
+      for (auto const& location : index.Find(icon_name + extensions[i])) {
+        candidates.push_back(Candidate{location, i});
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    return candidates;
+  };
+
   // Stage 1: best size match
   // Contrary to the freedesktop spec, we are not choosing the closest icon in
   // size, but the next larger icon
@@ -902,32 +1520,31 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
   IconTheme* next_larger_theme = nullptr;
 
   for (auto const& theme : list_themes_) {
-    for (auto const& dir : theme->list_directories) {
-      for (auto const& base_name : basenames) {
-        for (auto const& extension : extensions) {
-          std::string icon_file_name(icon_name + extension);
-          std::string file_name = util::fs::BuildPath(
-              {base_name, theme->name, dir->name, icon_file_name});
-
-          if (util::fs::FileExists(file_name)) {
-            // Closest match
-            if (DirectorySizeDistance(dir, size) < minimal_size &&
-                (!best_file_theme || theme == best_file_theme)) {
-              best_file_name = file_name;
-              minimal_size = DirectorySizeDistance(dir, size);
-              best_file_theme = theme;
-            }
-
-            // Next larger match
-            if (dir->size >= size &&
-                (next_larger_size == -1 || dir->size < next_larger_size) &&
-                (!next_larger_theme || theme == next_larger_theme)) {
-              next_larger = file_name;
-              next_larger_size = dir->size;
-              next_larger_theme = theme;
-            }
-          }
-        }
+    for (auto const& candidate : find_candidates(theme->index)) {
+      IconThemeDir* dir =
+          theme->list_directories[candidate.location.directory];
+      std::string icon_file_name(icon_name +
+                                 extensions[candidate.extension]);
+      // The index only lists files that exist: no need to check again.
+      std::string file_name = util::fs::BuildPath(
+          {basenames[candidate.location.base], theme->name, dir->name,
+           icon_file_name});
+
+      // Closest match
+      if (DirectorySizeDistance(dir, size) < minimal_size &&
+          (!best_file_theme || theme == best_file_theme)) {
+        best_file_name = file_name;
+        minimal_size = DirectorySizeDistance(dir, size);
+        best_file_theme = theme;
+      }
+
+      // Next larger match
+      if (dir->size >= size &&
+          (next_larger_size == -1 || dir->size < next_larger_size) &&
+          (!next_larger_theme || theme == next_larger_theme)) {
+        next_larger = file_name;
+        next_larger_size = dir->size;
+        next_larger_theme = theme;
       }
     }
   }
@@ -941,15 +1558,12 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
   }
 
   // Stage 2: look in unthemed icons
-  for (auto const& base_name : basenames) {
-    for (auto const& extension : extensions) {
-      std::string icon_file_name(icon_name + extension);
-      std::string file_name = util::fs::BuildPath({base_name, icon_file_name});
-
-      if (util::fs::FileExists(file_name)) {
-        return file_name;
-      }
-    }
+  auto unthemed_candidates = find_candidates(unthemed_icons_);
+  if (!unthemed_candidates.empty()) {
+    Candidate const& candidate = unthemed_candidates.front();
+    std::string icon_file_name(icon_name + extensions[candidate.extension]);
+    return util::fs::BuildPath(
+        {basenames[candidate.location.base], icon_file_name});
   }
 
   util::log::Error() << "Could not find icon " << icon_name.c_str() << '\n';
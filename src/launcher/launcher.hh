@@ -2,12 +2,23 @@
 #define TINT3_LAUNCHER_LAUNCHER_HH
 
 #include <xsettings-client.h>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "launcher/application_index.hh"
+#include "launcher/icon_theme.hh"
 #include "util/area.hh"
 #include "util/common.hh"
+#include "util/file_watcher.hh"
 #include "util/imlib2.hh"
+#include "util/worker_pool.hh"
+
+namespace test {
+
+class LauncherHelper;
+
+}  // namespace test
 
 class LauncherIcon : public Area {
  public:
@@ -15,16 +26,30 @@ class LauncherIcon : public Area {
   util::imlib2::Image icon_scaled_;
   util::imlib2::Image icon_hover_;
   util::imlib2::Image icon_pressed_;
+  // The launcher_item_app this icon was loaded from, and the desktop entry it
+  // resolved to.
+  std::string app_;
+  std::string desktop_file_path_;
   std::string cmd_;
   std::string icon_name_;
   std::string icon_path_;
   std::string icon_tooltip_;
   int icon_size_ = 0;
+  // Set while the images are being loaded on the worker pool.
+  bool icon_loading_ = false;
+  // Memory held by the images above, counted against
+  // launcher_icon_memory_limit.
+  size_t icon_image_bytes_ = 0;
   bool is_app_desktop_ = false;
   int x_ = 0;
   int y_ = 0;
 
   LauncherIcon();
+  ~LauncherIcon() override;
+
+  // Drops the images (and any pending load of them). They are loaded again
+  // the next time the icon is drawn.
+  void FreeImages();
 
   void DrawForeground(cairo_t*) override;
   std::string GetTooltipText() override;
@@ -44,34 +69,19 @@ struct DesktopEntry {
   std::string icon;
 };
 
-enum class IconType { kScalable, kFixed, kThreshold };
-
-struct IconThemeDir {
-  std::string name;
-  std::string context;
-  int size;
-  IconType type;
-  int max_size;
-  int min_size;
-  int threshold;
-};
-
-class IconTheme {
- public:
-  ~IconTheme();
-
-  std::string name;
-  std::vector<std::string> list_inherits;
-  std::vector<IconThemeDir*> list_directories;
-};
-
 class Launcher : public Area {
+  friend class test::LauncherHelper;
+
   std::string GetIconPath(std::string const& icon_name, int size);
+  std::string ResolveIconPath(LauncherIcon const* launcher_icon,
+                              bool* is_fallback);
+  LauncherIcon* LoadIcon(std::string const& path);
 
  public:
   std::vector<std::string> list_apps_;  // paths to .desktop files
   std::vector<LauncherIcon*> list_icons_;
   std::vector<IconTheme*> list_themes_;
+  IconThemeIndex unthemed_icons_;
 
   int GetIconSize() const;
 
@@ -80,9 +90,23 @@ class Launcher : public Area {
   // Populates the list_themes list
   bool LoadThemes();
 
-  // Populates the list_icons list
+  // Populates the list_icons list. Only reads the desktop entries, the icon
+  // images are loaded the first time each icon is drawn.
   void LoadIcons();
 
+  // Reloads the launcher icons whose desktop entries are among the changed
+  // paths, or now resolve to different files. The others are kept as they
+  // are.
+  void ReloadIcons(std::set<std::string> const& changed_paths);
+
+  // Reloads the icon themes, and drops the images of the launcher icons that
+  // are among the changed paths or now resolve to different files.
+  void ReloadThemes(std::set<std::string> const& changed_paths);
+
+  // Resolves the icon file of the launcher icon for its current size, and
+  // starts loading its images.
+  void RequestIconImages(LauncherIcon* launcher_icon);
+
   bool Resize() override;
 
   static void InitPanel(Panel* panel);
@@ -100,9 +124,21 @@ extern bool launcher_tooltip_enabled;
 extern int launcher_alpha;
 extern int launcher_saturation;
 extern int launcher_brightness;
+extern int launcher_icon_memory_limit;  // KiB, 0 for no limit
 extern std::string icon_theme_name;  // theme name
 extern XSettingsClient* xsettings_client;
 
+// Pool the launcher icons are loaded on. Its completions must be run by the
+// main loop.
+util::WorkerPool& LauncherWorkerPool();
+
+// Watches the launcher items, the application directories and the icon
+// themes for changes, which are applied by HandleLauncherFileChanges() once
+// the event loop sees LauncherFileWatcher().fd() becoming readable.
+util::FileWatcher& LauncherFileWatcher();
+void WatchLauncherFiles();
+void HandleLauncherFileChanges();
+
 // default global data
 void DefaultLauncher();
 
@@ -110,9 +146,13 @@ void DefaultLauncher();
 void InitLauncher();
 void CleanupLauncher();
 
+// Index of the desktop entries in the XDG application directories, built
+// on first use and rebuilt whenever those directories change.
+ApplicationIndex& DesktopEntryIndex();
+
 // Looks up for the given desktop entry in well known paths.
 // The desktop entry can be a relative or absolute path to a file, or it can
-// be simply the file name that will be resolved against standard XDG dirs.
+// be a desktop file ID that will be resolved against standard XDG dirs.
 bool FindDesktopEntry(std::string const& name, std::string* output_path);
 
 #endif  // TINT3_LAUNCHER_LAUNCHER_HH
@@ -1,8 +1,23 @@
 #include "catch.hpp"
 
+#include <string>
+
 #include "launcher/launcher.hh"
 #include "panel.hh"
 #include "util/environment.hh"
+#include "util/fs_test_utils.hh"
+
+namespace test {
+
+class LauncherHelper {
+ public:
+  static std::string GetIconPath(Launcher& launcher,
+                                 std::string const& icon_name, int size) {
+    return launcher.GetIconPath(icon_name, size);
+  }
+};
+
+}  // namespace test
 
 Monitor TestMonitor() {
   Monitor m;
@@ -51,6 +66,10 @@ TEST_CASE("FindDesktopEntry") {
 TEST_CASE("Launcher::LoadThemes") {
   auto data_home =
       environment::MakeScopedOverride("HOME", "src/launcher/testdata");
+  TemporaryDirectory cache_dir;
+  auto cache_home =
+      environment::MakeScopedOverride<std::string>("XDG_CACHE_HOME",
+                                                  cache_dir.path());
   icon_theme_name = "UnitTestTheme";
 
   // Should successfully load:
@@ -60,6 +79,45 @@ TEST_CASE("Launcher::LoadThemes") {
   l.CleanupTheme();
 }
 
+TEST_CASE("Launcher::GetIconPath") {
+  TemporaryDirectory home_dir;
+  TemporaryDirectory cache_dir;
+  auto home = environment::MakeScopedOverride<std::string>("HOME",
+                                                          home_dir.path());
+  auto cache_home =
+      environment::MakeScopedOverride<std::string>("XDG_CACHE_HOME",
+                                                  cache_dir.path());
+  icon_theme_name = "UnitTestTheme";
+
+  util::fs::Path icons{home_dir.path() / ".icons"};
+  util::fs::Path theme{icons / "UnitTestTheme"};
+  REQUIRE(util::fs::CreateDirectory(icons));
+  REQUIRE(util::fs::CreateDirectory(theme));
+  REQUIRE(util::fs::CreateDirectory(theme / "16x16"));
+  REQUIRE(util::fs::CreateDirectory(theme / "16x16" / "apps"));
+  REQUIRE(util::fs::CopyFile(
+      "src/launcher/testdata/.icons/UnitTestTheme/index.theme",
+      theme / "index.theme"));
+  std::string themed_path{theme / "16x16" / "apps" / "unit-test-app.png"};
+  std::string unthemed_path{icons / "unit-test-unthemed.png"};
+  REQUIRE(util::fs::WriteFile(themed_path, "PNG"));
+  REQUIRE(util::fs::WriteFile(unthemed_path, "PNG"));
+
+  Launcher l;
+  REQUIRE(l.LoadThemes());
+
+  // Lookups go by the index only: files deleted after indexing are still
+  // found, as nothing looks at the filesystem again.
+  REQUIRE(util::fs::Unlink(themed_path));
+  REQUIRE(util::fs::Unlink(unthemed_path));
+  REQUIRE(test::LauncherHelper::GetIconPath(l, "unit-test-app", 16) ==
+          themed_path);
+  REQUIRE(test::LauncherHelper::GetIconPath(l, "unit-test-unthemed", 16) ==
+          unthemed_path);
+  REQUIRE(test::LauncherHelper::GetIconPath(l, "no-such-icon", 16).empty());
+  l.CleanupTheme();
+}
+
 TEST_CASE("Launcher::GetIconSize") {
   server.monitor.emplace_back(TestMonitor());
 
@@ -135,3 +193,51 @@ TEST_CASE("Launcher::GetIconSize") {
     REQUIRE(l.GetIconSize() == p.width_);
   }
 }
+
+TEST_CASE("Launcher::ReloadIcons") {
+  TemporaryDirectory temp_dir;
+  std::string first_path{temp_dir.path() / "first.desktop"};
+  std::string second_path{temp_dir.path() / "second.desktop"};
+
+  auto desktop_entry = [](std::string const& comment) {
+    return "[Desktop Entry]\n"
+           "Type=Application\n"
+           "Exec=true\n"
+           "Comment=" +
+           comment + "\n";
+  };
+  REQUIRE(util::fs::WriteFile(first_path, desktop_entry("First")));
+
+  if (backgrounds.empty()) {
+    backgrounds.push_back(Background());
+  }
+
+  Launcher l;
+  l.list_apps_ = {first_path, second_path};
+  l.LoadIcons();
+  REQUIRE(l.list_icons_.size() == 1);
+  LauncherIcon* first_icon = l.list_icons_.front();
+
+  // Nothing changed: the icon is kept as it is.
+  l.ReloadIcons({});
+  REQUIRE(l.list_icons_.size() == 1);
+  REQUIRE(l.list_icons_.front() == first_icon);
+
+  // The missing desktop entry appears.
+  REQUIRE(util::fs::WriteFile(second_path, desktop_entry("Second")));
+  l.ReloadIcons({second_path});
+  REQUIRE(l.list_icons_.size() == 2);
+  REQUIRE(l.list_icons_.front() == first_icon);
+  REQUIRE(l.list_icons_.back()->icon_tooltip_ == "Second");
+  REQUIRE(l.children_.size() == 2);
+
+  // An existing desktop entry is modified.
+  REQUIRE(util::fs::WriteFile(first_path, desktop_entry("Modified")));
+  l.ReloadIcons({first_path});
+  REQUIRE(l.list_icons_.size() == 2);
+  REQUIRE(l.list_icons_.front()->icon_tooltip_ == "Modified");
+  REQUIRE(l.list_icons_.back()->icon_tooltip_ == "Second");
+  REQUIRE(l.children_.front() == l.list_icons_.front());
+
+  l.CleanupTheme();
+}
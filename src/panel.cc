@@ -40,6 +40,9 @@ namespace {
 char kClassHintName[] = "tint3";
 char kClassHintClass[] = "Tint3";
 
+// Too short to notice when the panel shows or hides.
+const absl::Duration kAutohideSlack = absl::Milliseconds(20);
+
 }  // namespace
 
 bool panel_refresh;
@@ -859,7 +862,8 @@ bool Panel::AutohideHide() {
 void Panel::AutohideTriggerShow(Timer& timer) {
   autohide_timeout_ =
       timer.SetTimeout(absl::Milliseconds(config_.autohide_show_timeout),
-                       [this]() -> bool { return AutohideShow(); });
+                       [this]() -> bool { return AutohideShow(); },
+                       kAutohideSlack);
 }
 
 void Panel::AutohideTriggerHide(Timer& timer) {
@@ -876,5 +880,6 @@ void Panel::AutohideTriggerHide(Timer& timer) {
 
   autohide_timeout_ =
       timer.SetTimeout(absl::Milliseconds(config_.autohide_hide_timeout),
-                       [this]() -> bool { return AutohideHide(); });
+                       [this]() -> bool { return AutohideHide(); },
+                       kAutohideSlack);
 }
@@ -1,13 +1,18 @@
 #include "parser/lexer.hh"
 
-#include <regex>
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <stdexcept>
 #include <utility>
 
 namespace parser {
 namespace matcher {
 
-bool NewLine(std::string const& buffer, unsigned int* position,
-             std::string* output) {
+bool NewLine(absl::string_view buffer, unsigned int* position,
+             absl::string_view* output) {
   unsigned int begin = (*position);
   unsigned int end = begin;
   if (end < buffer.length() && buffer[end] == '\r') {
@@ -17,91 +22,441 @@ bool NewLine(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
+  (*output) = buffer.substr(begin, end - begin);
   return !output->empty();
 }
 
-bool Whitespace(std::string const& buffer, unsigned int* position,
-                std::string* output) {
+bool Whitespace(absl::string_view buffer, unsigned int* position,
+                absl::string_view* output) {
   unsigned int begin = (*position);
   unsigned int end = begin;
-  while (end < buffer.length() && isspace(buffer[end]) && buffer[end] != '\n') {
+  while (end < buffer.length() &&
+         isspace(static_cast<unsigned char>(buffer[end])) &&
+         buffer[end] != '\n') {
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
+  (*output) = buffer.substr(begin, end - begin);
   return !output->empty();
 }
 
-bool Any(std::string const& buffer, unsigned int* position,
-         std::string* output) {
+bool Any(absl::string_view buffer, unsigned int* position,
+         absl::string_view* output) {
   if (*position >= buffer.length()) {
     return false;
   }
-  output->assign(buffer, (*position)++, 1);
+  (*output) = buffer.substr((*position)++, 1);
   return true;
 }
 
 }  // namespace matcher
 
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+ByteSet ByteRange(unsigned char first, unsigned char last) {
+  ByteSet set;
+  for (unsigned int c = first; c <= last; ++c) {
+    set.set(c);
+  }
+  return set;
+}
+
+// Non-deterministic automaton built from a pattern with the Thompson
+// construction. Each state either consumes one of the given bytes and moves
+// to the next state, or moves to any of its epsilon states for free.
+struct NfaState {
+  ByteSet bytes;
+  int next = -1;
+  std::vector<int> epsilon;
+};
+
+class PatternCompiler {
+ public:
+  explicit PatternCompiler(absl::string_view pattern)
+      : pattern_(pattern), position_(0), start_(0), accept_(0) {
+    Fragment fragment = Alternation();
+    if (position_ != pattern_.length()) {
+      Fail("unbalanced ')'");
+    }
+    start_ = fragment.start;
+    accept_ = fragment.end;
+  }
+
+  std::vector<NfaState> const& states() const { return states_; }
+  int accept() const { return accept_; }
+
+  // Returns the sorted set of states reachable from the given ones through
+  // epsilon moves (including themselves).
+  std::vector<int> Closure(std::vector<int> const& states) const {
+    std::vector<bool> seen(states_.size(), false);
+    std::vector<int> pending{states};
+    std::vector<int> closure;
+    while (!pending.empty()) {
+      int state = pending.back();
+      pending.pop_back();
+      if (seen[state]) {
+        continue;
+      }
+      seen[state] = true;
+      closure.push_back(state);
+      for (int next : states_[state].epsilon) {
+        pending.push_back(next);
+      }
+    }
+    std::sort(closure.begin(), closure.end());
+    return closure;
+  }
+
+  std::vector<int> StartClosure() const { return Closure({start_}); }
+
+ private:
+  struct Fragment {
+    int start;
+    int end;
+  };
+
+  absl::string_view pattern_;
+  size_t position_;
+  std::vector<NfaState> states_;
+  int start_;
+  int accept_;
+
+  [[noreturn]] void Fail(const char* reason) const {
+    throw std::invalid_argument{std::string{"invalid pattern \""} +
+                                std::string{pattern_} + "\": " + reason};
+  }
+
+  bool AtEnd() const { return position_ == pattern_.length(); }
+
+  bool Consume(char c) {
+    if (!AtEnd() && pattern_[position_] == c) {
+      ++position_;
+      return true;
+    }
+    return false;
+  }
+
+  int NewState() {
+    states_.emplace_back();
+    return (states_.size() - 1);
+  }
+
+  Fragment Bytes(ByteSet const& bytes) {
+    int start = NewState();
+    int end = NewState();
+    states_[start].bytes = bytes;
+    states_[start].next = end;
+    return Fragment{start, end};
+  }
+
+  // <alternation> ::= <concatenation> ("|" <concatenation>)*
+  Fragment Alternation() {
+    Fragment fragment = Concatenation();
+    while (Consume('|')) {
+      Fragment other = Concatenation();
+      int start = NewState();
+      int end = NewState();
+      states_[start].epsilon = {fragment.start, other.start};
+      states_[fragment.end].epsilon.push_back(end);
+      states_[other.end].epsilon.push_back(end);
+      fragment = Fragment{start, end};
+    }
+    return fragment;
+  }
+
+  // <concatenation> ::= <repetition>*
+  Fragment Concatenation() {
+    int state = NewState();
+    Fragment fragment{state, state};
+    while (!AtEnd() && pattern_[position_] != '|' &&
+           pattern_[position_] != ')') {
+      Fragment next = Repetition();
+      states_[fragment.end].epsilon.push_back(next.start);
+      fragment.end = next.end;
+    }
+    return fragment;
+  }
+
+  // <repetition> ::= <atom> ("*" | "+" | "?")*
+  Fragment Repetition() {
+    Fragment fragment = Atom();
+    while (!AtEnd()) {
+      char op = pattern_[position_];
+      if (op != '*' && op != '+' && op != '?') {
+        break;
+      }
+      ++position_;
+
+      int start = NewState();
+      int end = NewState();
+      states_[start].epsilon.push_back(fragment.start);
+      if (op != '+') {
+        states_[start].epsilon.push_back(end);
+      }
+      if (op != '?') {
+        states_[fragment.end].epsilon.push_back(fragment.start);
+      }
+      states_[fragment.end].epsilon.push_back(end);
+      fragment = Fragment{start, end};
+    }
+    return fragment;
+  }
+
+  // <atom> ::= "(" <alternation> ")" | "[" <bracket> "]" | "." | "\" <escape>
+  //          | <literal>
+  Fragment Atom() {
+    char c = pattern_[position_++];
+    switch (c) {
+      case '(': {
+        Fragment fragment = Alternation();
+        if (!Consume(')')) {
+          Fail("missing ')'");
+        }
+        return fragment;
+      }
+      case '[':
+        return Bytes(BracketExpression());
+      case '.': {
+        ByteSet bytes;
+        bytes.set();
+        bytes.reset('\n');
+        bytes.reset('\r');
+        return Bytes(bytes);
+      }
+      case '\\': {
+        ByteSet bytes;
+        int byte = Escape(&bytes);
+        if (byte != -1) {
+          bytes.set(byte);
+        }
+        return Bytes(bytes);
+      }
+      case '*':
+      case '+':
+      case '?':
+        Fail("nothing to repeat");
+      case '^':
+      case '$':
+      case '{':
+        Fail("unsupported syntax");
+      default: {
+        ByteSet bytes;
+        bytes.set(static_cast<unsigned char>(c));
+        return Bytes(bytes);
+      }
+    }
+  }
+
+  // Parses the escape sequence following a backslash. Returns the byte it
+  // stands for, or -1 if it stands for the class of bytes stored in the given
+  // set.
+  int Escape(ByteSet* bytes) {
+    if (AtEnd()) {
+      Fail("trailing '\\'");
+    }
+    char c = pattern_[position_++];
+    switch (c) {
+      case 'd':
+      case 'D':
+        (*bytes) = ByteRange('0', '9');
+        break;
+      case 's':
+      case 'S':
+        (*bytes) = ByteRange('\t', '\r');
+        bytes->set(' ');
+        break;
+      case 'w':
+      case 'W':
+        (*bytes) =
+            ByteRange('a', 'z') | ByteRange('A', 'Z') | ByteRange('0', '9');
+        bytes->set('_');
+        break;
+      case 'f':
+        return '\f';
+      case 'n':
+        return '\n';
+      case 'r':
+        return '\r';
+      case 't':
+        return '\t';
+      case 'v':
+        return '\v';
+      default:
+        if (isalnum(static_cast<unsigned char>(c))) {
+          Fail("unsupported escape sequence");
+        }
+        return static_cast<unsigned char>(c);
+    }
+    if (isupper(static_cast<unsigned char>(c))) {
+      bytes->flip();
+    }
+    return -1;
+  }
+
+  // Parses a single member of a bracket expression, returning the byte it
+  // stands for or -1 for escaped classes (as Escape() does).
+  int ClassAtom(ByteSet* bytes) {
+    if (AtEnd()) {
+      Fail("missing ']'");
+    }
+    char c = pattern_[position_++];
+    if (c == '\\') {
+      return Escape(bytes);
+    }
+    return static_cast<unsigned char>(c);
+  }
+
+  // <bracket> ::= "^"? (<class atom> ("-" <class atom>)?)*
+  ByteSet BracketExpression() {
+    ByteSet bytes;
+    bool negate = Consume('^');
+    while (!Consume(']')) {
+      ByteSet item;
+      int first = ClassAtom(&item);
+      if (first != -1 && !AtEnd() && pattern_[position_] == '-' &&
+          position_ + 1 < pattern_.length() &&
+          pattern_[position_ + 1] != ']') {
+        ++position_;
+        int last = ClassAtom(&item);
+        if (last == -1 || last < first) {
+          Fail("invalid range");
+        }
+        item = ByteRange(first, last);
+      } else if (first != -1) {
+        item.set(first);
+      }
+      bytes |= item;
+    }
+    if (negate) {
+      bytes.flip();
+    }
+    return bytes;
+  }
+};
+
+}  // namespace
+
+constexpr uint16_t Pattern::kDeadState;
+constexpr uint16_t Pattern::kStartState;
+
+Pattern::Pattern(absl::string_view pattern) {
+  PatternCompiler compiler{pattern};
+  std::vector<NfaState> const& nfa = compiler.states();
+
+  // Subset construction: each DFA state stands for the set of NFA states the
+  // automaton could be in.
+  std::vector<std::vector<int>> subsets{{}, compiler.StartClosure()};
+  std::map<std::vector<int>, uint16_t> subset_states{{subsets[0], kDeadState},
+                                                     {subsets[1], kStartState}};
+  transitions_.assign(subsets.size() * 256, kDeadState);
+
+  for (size_t state = kStartState; state < subsets.size(); ++state) {
+    for (unsigned int byte = 0; byte < 256; ++byte) {
+      std::vector<int> moved;
+      for (int nfa_state : subsets[state]) {
+        if (nfa[nfa_state].next != -1 && nfa[nfa_state].bytes.test(byte)) {
+          moved.push_back(nfa[nfa_state].next);
+        }
+      }
+      if (moved.empty()) {
+        continue;
+      }
+
+      std::vector<int> closure{compiler.Closure(moved)};
+      auto it = subset_states.find(closure);
+      if (it == subset_states.end()) {
+        if (subsets.size() > std::numeric_limits<uint16_t>::max()) {
+          throw std::invalid_argument{"pattern too complex"};
+        }
+        it = subset_states.emplace(closure, subsets.size()).first;
+        subsets.push_back(closure);
+        transitions_.resize(subsets.size() * 256, kDeadState);
+      }
+      transitions_[state * 256 + byte] = it->second;
+    }
+  }
+
+  accepting_.assign(subsets.size(), false);
+  for (size_t state = kStartState; state < subsets.size(); ++state) {
+    accepting_[state] = std::binary_search(
+        subsets[state].begin(), subsets[state].end(), compiler.accept());
+  }
+}
+
+size_t Pattern::Match(absl::string_view input) const {
+  size_t longest = 0;
+  uint16_t state = kStartState;
+  for (size_t i = 0; i < input.length(); ++i) {
+    state = transitions_[state * 256 + static_cast<unsigned char>(input[i])];
+    if (state == kDeadState) {
+      break;
+    }
+    if (accepting_[state]) {
+      longest = (i + 1);
+    }
+  }
+  return longest;
+}
+
 TokenMatcher::TokenMatcher(TokenMatcher const& other)
-    : matcher_(other.matcher_) {}
+    : callback_(other.callback_),
+      character_(other.character_),
+      pattern_(other.pattern_) {}
 
 TokenMatcher::TokenMatcher(TokenMatcher&& other)
-    : matcher_(std::move(other.matcher_)) {}
+    : callback_(other.callback_),
+      character_(other.character_),
+      pattern_(std::move(other.pattern_)) {}
 
-TokenMatcher::TokenMatcher(MatcherCallback matcher) : matcher_(matcher) {}
+TokenMatcher::TokenMatcher(MatcherCallback matcher)
+    : callback_(matcher), character_('\0') {}
 
-TokenMatcher::TokenMatcher(char c) : matcher_(MakeCharacterMatcher(c)) {}
+TokenMatcher::TokenMatcher(char c) : callback_(nullptr), character_(c) {}
 
 TokenMatcher::TokenMatcher(const char* regexp)
-    : matcher_(MakeRegexpMatcher(regexp)) {}
+    : callback_(nullptr),
+      character_('\0'),
+      pattern_(std::make_shared<Pattern>(regexp)) {}
 
 TokenMatcher::TokenMatcher(std::string const& regexp)
-    : matcher_(MakeRegexpMatcher(regexp)) {}
+    : callback_(nullptr),
+      character_('\0'),
+      pattern_(std::make_shared<Pattern>(regexp)) {}
 
 TokenMatcher& TokenMatcher::operator=(TokenMatcher other) {
-  std::swap(matcher_, other.matcher_);
+  std::swap(callback_, other.callback_);
+  std::swap(character_, other.character_);
+  std::swap(pattern_, other.pattern_);
   return *this;
 }
 
-bool TokenMatcher::operator()(std::string const& buffer, unsigned int* position,
-                              std::string* output) const {
-  return matcher_(buffer, position, output);
-}
-
-TokenMatcher::MatcherFunction TokenMatcher::MakeCharacterMatcher(char c) {
-  return [c](std::string const& buffer, unsigned int* position,
-             std::string* output) -> bool {
-    if (buffer[*position] == c) {
-      output->assign(1, c);
-      (*position) += 1;
-      return true;
-    }
+bool TokenMatcher::operator()(absl::string_view buffer, unsigned int* position,
+                              absl::string_view* output) const {
+  if (callback_ != nullptr) {
+    return callback_(buffer, position, output);
+  }
+  if (*position >= buffer.length()) {
     return false;
-  };
-}
+  }
 
-TokenMatcher::MatcherFunction TokenMatcher::MakeRegexpMatcher(
-    std::string const& pattern) {
-  std::regex regexp{pattern};
-  return [regexp](std::string const& buffer, unsigned int* position,
-                  std::string* output) -> bool {
-    std::string remainder{buffer, (*position)};
-    std::smatch match;
-    if (std::regex_search(remainder, match, regexp,
-                          std::regex_constants::match_continuous)) {
-      output->assign(match.str());
-      (*position) += match.length();
-      return true;
-    }
+  size_t length = 0;
+  if (pattern_ != nullptr) {
+    length = pattern_->Match(buffer.substr(*position));
+  } else if (buffer[*position] == character_) {
+    length = 1;
+  }
+  if (length == 0) {
     return false;
-  };
+  }
+  (*output) = buffer.substr(*position, length);
+  (*position) += length;
+  return true;
 }
 
-Token::Token(Symbol symbol, unsigned int begin, unsigned int end,
-             std::string const& match)
-    : symbol(symbol), begin(begin), end(end), match(match) {}
+Token::Token(Symbol symbol, unsigned int begin, unsigned int end)
+    : symbol(symbol), begin(begin), end(end) {}
 
 Lexer::Lexer(Lexer const& other)
     : matcher_to_symbol_(other.matcher_to_symbol_) {}
@@ -117,7 +472,7 @@ Lexer& Lexer::operator=(Lexer other) {
   return *this;
 }
 
-bool Lexer::ProcessContents(std::string const& buffer, Result* result) const {
+bool Lexer::ProcessContents(absl::string_view buffer, Result* result) const {
   unsigned int length = buffer.length();
   unsigned int i = 0;
 
@@ -125,24 +480,22 @@ bool Lexer::ProcessContents(std::string const& buffer, Result* result) const {
 
   while (i < length) {
     bool found_match = false;
-    for (auto& pair : matcher_to_symbol_) {
-      TokenMatcher matcher = pair.first;
-      Symbol symbol = pair.second;
-
-      std::string output;
+    for (auto const& pair : matcher_to_symbol_) {
+      absl::string_view output;
       unsigned int begin = i;
-      if (matcher(buffer, &i, &output)) {
+      if (pair.first(buffer, &i, &output)) {
         found_match = true;
-        result->push_back(Token(symbol, begin, i, output));
+        result->push_back(Token(pair.second, begin, i));
         break;
       }
+      i = begin;
     }
     if (!found_match) {
       return false;
     }
   }
 
-  result->push_back(Token(kEOF, length, length, ""));
+  result->push_back(Token(kEOF, length, length));
   return true;
 }
 
@@ -1,40 +1,71 @@
 #ifndef TINT3_PARSER_LEXER_HH
 #define TINT3_PARSER_LEXER_HH
 
-#include <functional>
+#include <cstdint>
 #include <initializer_list>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+
 namespace parser {
 namespace matcher {
 
 // NewLine matcher accepts DOS-style (<CR><LF>), Macintosh-style (<CR>) or
 // Unix-style (<LF>) newline sequences.
-bool NewLine(std::string const& buffer, unsigned int* position,
-             std::string* output);
+bool NewLine(absl::string_view buffer, unsigned int* position,
+             absl::string_view* output);
 
 // Whitespace matcher accepts all the characters accepted by isspace(), except
 // for the newline character (which is usually to be accepted as a separate
 // token, and not swallowed by this matcher).
-bool Whitespace(std::string const& buffer, unsigned int* position,
-                std::string* output);
+bool Whitespace(absl::string_view buffer, unsigned int* position,
+                absl::string_view* output);
 
 // Any matcher accepts any single character.
-bool Any(std::string const& buffer, unsigned int* position,
-         std::string* output);
+bool Any(absl::string_view buffer, unsigned int* position,
+         absl::string_view* output);
 
 }  // namespace matcher
 
+// Regular expression compiled ahead of time into a deterministic automaton,
+// so that matching is a single table lookup per input byte.
+//
+// Supports the ECMAScript subset token patterns need: literals, '.', bracket
+// expressions (with ranges and negation), the \d \D \s \S \w \W escapes,
+// groups, alternation and the *, + and ? quantifiers. Patterns are matched
+// byte by byte, and the longest match wins.
+//
+// Throws std::invalid_argument for malformed or unsupported patterns, just
+// like std::regex would.
+class Pattern {
+ public:
+  explicit Pattern(absl::string_view pattern);
+
+  // Returns the length of the longest non-empty prefix of the input matched
+  // by the pattern, or 0 if there is none.
+  size_t Match(absl::string_view input) const;
+
+ private:
+  static constexpr uint16_t kDeadState = 0;
+  static constexpr uint16_t kStartState = 1;
+
+  // transitions_[state * 256 + byte] is the state reached from the given
+  // state when reading the given byte.
+  std::vector<uint16_t> transitions_;
+  std::vector<bool> accepting_;
+};
+
 using Symbol = unsigned int;
 
 static constexpr Symbol kEOF = 0;
 
 class TokenMatcher {
  public:
-  using MatcherCallback = bool(std::string const&, unsigned int*, std::string*);
-  using MatcherFunction = std::function<MatcherCallback>;
+  using MatcherCallback = bool(absl::string_view, unsigned int*,
+                               absl::string_view*);
 
   TokenMatcher(TokenMatcher const& other);
   TokenMatcher(TokenMatcher&& other);
@@ -45,25 +76,25 @@ class TokenMatcher {
   TokenMatcher(std::string const& regexp);
 
   TokenMatcher& operator=(TokenMatcher other);
-  bool operator()(std::string const& buffer, unsigned int* position,
-                  std::string* output) const;
+  bool operator()(absl::string_view buffer, unsigned int* position,
+                  absl::string_view* output) const;
 
  private:
-  MatcherFunction matcher_;
-
-  static MatcherFunction MakeCharacterMatcher(char c);
-  static MatcherFunction MakeRegexpMatcher(std::string const& pattern);
+  // Exactly one of these is set. Patterns are shared between copies.
+  MatcherCallback* callback_;
+  char character_;
+  std::shared_ptr<Pattern const> pattern_;
 };
 
+// Tokens only record where they are in the lexed buffer, their text is
+// looked up there when needed (see TokenList::CurrentMatch()).
 class Token {
  public:
   Symbol const symbol;
   unsigned int const begin;
   unsigned int const end;
-  std::string const match;
 
-  Token(Symbol symbol, unsigned int begin, unsigned int end,
-        std::string const& match);
+  Token(Symbol symbol, unsigned int begin, unsigned int end);
 };
 
 class Lexer {
@@ -77,7 +108,7 @@ class Lexer {
 
   Lexer& operator=(Lexer other);
 
-  bool ProcessContents(std::string const& buffer, Result* result) const;
+  bool ProcessContents(absl::string_view buffer, Result* result) const;
 
  private:
   // This could be an std::map for brevity, but we want to preserve the
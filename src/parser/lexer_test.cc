@@ -1,12 +1,18 @@
 #include "catch.hpp"
 
+#include <random>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "parser/lexer.hh"
 
 TEST_CASE("matchers::NewLine", "NewLine matcher is sane") {
   SECTION("<CR><LF>") {
     std::string cr_lf{"\r\n"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::NewLine(cr_lf, &position, &output));
     REQUIRE(position == cr_lf.length());
     REQUIRE(output == cr_lf);
@@ -15,7 +21,7 @@ TEST_CASE("matchers::NewLine", "NewLine matcher is sane") {
   SECTION("<CR>") {
     std::string cr{"\r"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::NewLine(cr, &position, &output));
     REQUIRE(position == cr.length());
     REQUIRE(output == cr);
@@ -24,7 +30,7 @@ TEST_CASE("matchers::NewLine", "NewLine matcher is sane") {
   SECTION("<LF>") {
     std::string lf{"\n"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::NewLine(lf, &position, &output));
     REQUIRE(position == lf.length());
     REQUIRE(output == lf);
@@ -33,7 +39,7 @@ TEST_CASE("matchers::NewLine", "NewLine matcher is sane") {
   SECTION("<LF><CR><LF>") {
     std::string mixed{"\n\r\n"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     // First pass: consume only '\n'
     REQUIRE(parser::matcher::NewLine(mixed, &position, &output));
     REQUIRE(position == 1);
@@ -49,7 +55,7 @@ TEST_CASE("matchers::Whitespace", "Whitespace matcher is sane") {
   SECTION("All spaces") {
     std::string all_spaces{"   "};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::Whitespace(all_spaces, &position, &output));
     REQUIRE(position == all_spaces.length());
     REQUIRE(output == all_spaces);
@@ -58,7 +64,7 @@ TEST_CASE("matchers::Whitespace", "Whitespace matcher is sane") {
   SECTION("Mixed spaces") {
     std::string mixed_spaces{" \t \r"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::Whitespace(mixed_spaces, &position, &output));
     REQUIRE(position == mixed_spaces.length());
     REQUIRE(output == mixed_spaces);
@@ -67,7 +73,7 @@ TEST_CASE("matchers::Whitespace", "Whitespace matcher is sane") {
   SECTION("Leading spaces") {
     std::string test_string{"   test"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::Whitespace(test_string, &position, &output));
     REQUIRE(position == 3);
     REQUIRE(output == "   ");
@@ -76,7 +82,7 @@ TEST_CASE("matchers::Whitespace", "Whitespace matcher is sane") {
   SECTION("Trailing spaces") {
     std::string test_string{"test   "};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     // Since we're starting from position=0, there's no whitespace that matches
     // at that position, so we expect to fail here.
     REQUIRE_FALSE(parser::matcher::Whitespace(test_string, &position, &output));
@@ -89,7 +95,7 @@ TEST_CASE("matchers::Any", "Whitespace matcher is sane") {
   SECTION("Inside a string") {
     std::string test_string{"test"};
     unsigned int position = 0;
-    std::string output;
+    absl::string_view output;
     REQUIRE(parser::matcher::Any(test_string, &position, &output));
     REQUIRE(position == 1);
     REQUIRE(output == "t");
@@ -98,7 +104,7 @@ TEST_CASE("matchers::Any", "Whitespace matcher is sane") {
   SECTION("At the end of a string") {
     std::string test_string{"test"};
     unsigned int position = test_string.length();
-    std::string output;
+    absl::string_view output;
     REQUIRE_FALSE(parser::matcher::Any(test_string, &position, &output));
     REQUIRE(position == test_string.length());
     REQUIRE(output.empty());
@@ -159,3 +165,81 @@ key=value
     REQUIRE(result[i].symbol == kExpectedSequence[i]);
   }
 }
+
+TEST_CASE("Pattern", "Patterns match the longest prefix") {
+  SECTION("literals") {
+    parser::Pattern pattern{"@import"};
+    REQUIRE(pattern.Match("@import") == 7);
+    REQUIRE(pattern.Match("@import foo") == 7);
+    REQUIRE(pattern.Match("@impor") == 0);
+    REQUIRE(pattern.Match(" @import") == 0);
+  }
+
+  SECTION("bracket expressions") {
+    parser::Pattern pattern{"[A-Za-z0-9-]+"};
+    REQUIRE(pattern.Match("key-name=value") == 8);
+    REQUIRE(pattern.Match("=value") == 0);
+
+    parser::Pattern negated{"[^=\\n]*"};
+    REQUIRE(negated.Match("key=value") == 3);
+    REQUIRE(negated.Match("key\nvalue") == 3);
+    // Empty matches are never reported.
+    REQUIRE(negated.Match("=value") == 0);
+
+    parser::Pattern dashes{"[-a]+"};
+    REQUIRE(dashes.Match("a-a-b") == 4);
+  }
+
+  SECTION("escapes") {
+    REQUIRE(parser::Pattern{"\\s+"}.Match(" \t\r\nx") == 4);
+    REQUIRE(parser::Pattern{"\\S+"}.Match("ab c") == 2);
+    REQUIRE(parser::Pattern{"\\d+\\.\\d+"}.Match("3.14s") == 4);
+    REQUIRE(parser::Pattern{"\\w+"}.Match("snake_case1-x") == 11);
+    REQUIRE(parser::Pattern{"."}.Match("\n") == 0);
+  }
+
+  SECTION("groups and alternation") {
+    parser::Pattern pattern{"(ab|a)(c|bcd)?"};
+    REQUIRE(pattern.Match("abcd") == 4);
+    REQUIRE(pattern.Match("abc") == 3);
+    REQUIRE(pattern.Match("ax") == 1);
+  }
+
+  SECTION("invalid patterns") {
+    for (auto const& invalid :
+         {"(a", "a)", "[a", "*a", "a\\", "[z-a]", "\\q", "a{2}", "^a"}) {
+      REQUIRE_THROWS_AS(parser::Pattern{invalid}, std::invalid_argument);
+    }
+  }
+
+  SECTION("agrees with std::regex") {
+    // Without alternation, greedy ECMAScript matching is also the longest.
+    std::vector<std::string> patterns{
+        "[0-9-]+", "\\s+", "[A-Za-z0-9-]+", ".", "a*b+c?", "(ab)+a?",
+        "[^ab]+b*", "\\w+\\s*=",
+    };
+    std::mt19937 generator{1234};
+    std::uniform_int_distribution<unsigned int> length(0, 8);
+    std::uniform_int_distribution<unsigned int> pick(0, 9);
+    static constexpr char kAlphabet[] = "ab09-= \t\nc";
+
+    for (auto const& pattern : patterns) {
+      parser::Pattern compiled{pattern};
+      std::regex regex{pattern};
+      for (unsigned int i = 0; i < 2000; ++i) {
+        std::string input;
+        for (unsigned int n = length(generator); n != 0; --n) {
+          input.push_back(kAlphabet[pick(generator)]);
+        }
+        std::smatch match;
+        size_t expected = 0;
+        if (std::regex_search(input, match, regex,
+                              std::regex_constants::match_continuous)) {
+          expected = match.length();
+        }
+        INFO(pattern << " on \"" << input << "\"");
+        REQUIRE(compiled.Match(input) == expected);
+      }
+    }
+  }
+}
@@ -1,16 +1,21 @@
-#include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
-
 #include "parser/parser.hh"
 
+#include <utility>
+
 #include "util/common.hh"
 
 namespace parser {
 
-TokenList::TokenList(Lexer::Result tokens) : tokens_(tokens), current_(0) {}
+TokenList::TokenList(absl::string_view buffer, Lexer::Result tokens)
+    : buffer_(buffer), tokens_(std::move(tokens)), current_(0) {}
 
 Token const& TokenList::Current() const { return tokens_.at(current_); }
 
+absl::string_view TokenList::CurrentMatch() const {
+  Token const& token = Current();
+  return buffer_.substr(token.begin, token.end - token.begin);
+}
+
 bool TokenList::Accept(Symbol symbol) {
   if (Current().symbol == symbol) {
     // Skip over the current symbol, unless we're at the end of file.
@@ -30,47 +35,46 @@ bool TokenList::Next() {
   return false;
 }
 
-bool TokenList::SkipOver(Symbol symbol, std::vector<Token>* output) {
+bool TokenList::SkipOver(Symbol symbol, absl::string_view* skipped) {
+  unsigned int begin = Current().begin;
+  bool result = true;
   while (Current().symbol == symbol) {
-    if (output != nullptr) {
-      output->push_back(Current());
-    }
     if (!Next()) {
-      return false;
+      result = false;
+      break;
     }
   }
-  return (Current().symbol != kEOF);
+  if (skipped != nullptr) {
+    (*skipped) = buffer_.substr(begin, Current().begin - begin);
+  }
+  return result && (Current().symbol != kEOF);
 }
 
-bool TokenList::SkipUntil(Symbol symbol, std::vector<Token>* output) {
+bool TokenList::SkipUntil(Symbol symbol, absl::string_view* skipped) {
+  unsigned int begin = Current().begin;
+  bool result = true;
   while (Current().symbol != symbol && Current().symbol != kEOF) {
-    if (output != nullptr) {
-      output->push_back(Current());
-    }
     if (!Next()) {
-      return false;
+      result = false;
+      break;
     }
   }
-  return (Current().symbol != kEOF);
-}
-
-std::string TokenList::JoinSkipped(std::vector<Token> const& tokens) {
-  static auto token_formatter = [](std::string* out, Token const& t) {
-    absl::StrAppend(out, t.match);
-  };
-  return absl::StrJoin(tokens, "", token_formatter);
+  if (skipped != nullptr) {
+    (*skipped) = buffer_.substr(begin, Current().begin - begin);
+  }
+  return result && (Current().symbol != kEOF);
 }
 
-Parser::Parser(Lexer lexer, ParseCallback* entry_fn)
+Parser::Parser(Lexer const& lexer, ParseCallback* entry_fn)
     : lexer_(lexer), parser_entry_fn_(entry_fn) {}
 
-bool Parser::Parse(std::string const& buffer) const {
+bool Parser::Parse(absl::string_view buffer) const {
   Lexer::Result result;
   if (!lexer_.ProcessContents(buffer, &result)) {
     return false;
   }
 
-  TokenList tokens{result};
+  TokenList tokens{buffer, std::move(result)};
   if (!(*parser_entry_fn_)(&tokens)) {
     return false;
   }
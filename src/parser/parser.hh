@@ -4,23 +4,31 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+
 #include "parser/lexer.hh"
 
 namespace parser {
 
 class TokenList {
  public:
-  explicit TokenList(Lexer::Result tokens);
+  // The tokens refer to the given buffer, which has to outlive the list.
+  TokenList(absl::string_view buffer, Lexer::Result tokens);
 
   Token const& Current() const;
+  // Returns the text of the current token.
+  absl::string_view CurrentMatch() const;
   bool Accept(Symbol symbol);
   bool Next();
-  bool SkipOver(Symbol symbol, std::vector<Token>* output = nullptr);
-  bool SkipUntil(Symbol symbol, std::vector<Token>* output = nullptr);
 
-  static std::string JoinSkipped(std::vector<Token> const& tokens);
+  // Skip tokens as long as (or until) they have the given symbol. Since the
+  // tokens are contiguous, the text of those skipped over is returned as a
+  // single view into the buffer.
+  bool SkipOver(Symbol symbol, absl::string_view* skipped = nullptr);
+  bool SkipUntil(Symbol symbol, absl::string_view* skipped = nullptr);
 
  private:
+  absl::string_view buffer_;
   Lexer::Result tokens_;
   unsigned int current_;
 };
@@ -32,12 +40,15 @@ class ParseCallback {
 
 class Parser {
  public:
-  Parser(Lexer lexer, ParseCallback* entry_fn);
+  // The lexer has to outlive the parser.
+  Parser(Lexer const& lexer, ParseCallback* entry_fn);
 
-  bool Parse(std::string const& buffer) const;
+  // Tokens handed to the callback point into the buffer, so strings are only
+  // copied out of it when the callback decides to keep them.
+  bool Parse(absl::string_view buffer) const;
 
  private:
-  Lexer lexer_;
+  Lexer const& lexer_;
   ParseCallback* parser_entry_fn_;
 };
 
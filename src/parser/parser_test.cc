@@ -2,6 +2,7 @@
 
 #include <stack>
 #include <string>
+#include <utility>
 
 #include "parser/parser.hh"
 
@@ -40,7 +41,7 @@ class SimpleArithmeticParser : public parser::ParseCallback {
 
   bool Expression(parser::TokenList* tokens) {
     if (tokens->Current().symbol == kNumber) {
-      op_stack_.emplace(std::stoul(tokens->Current().match));
+      op_stack_.emplace(std::stoul(std::string{tokens->CurrentMatch()}));
       tokens->Next();
     } else if (tokens->Current().symbol == kLeftBracket) {
       if (!WrappedExpression(tokens)) {
@@ -120,3 +121,30 @@ TEST_CASE("Parser", "Parses valid contents and rejects invalid ones") {
   simple_arithmetic_parser.Clear();
   REQUIRE_FALSE(test_parser.Parse("5 - 3"));
 }
+
+TEST_CASE("TokenList", "Skipped tokens are returned as views of the buffer") {
+  std::string buffer{"(12 + 3)  * 4"};
+  parser::Lexer::Result result;
+  REQUIRE(test_file_lexer.ProcessContents(buffer, &result));
+  parser::TokenList tokens{buffer, std::move(result)};
+
+  REQUIRE(tokens.CurrentMatch() == "(");
+  absl::string_view skipped;
+  REQUIRE(tokens.SkipUntil(kRightBracket, &skipped));
+  REQUIRE(skipped == "(12 + 3");
+  REQUIRE(skipped.data() == buffer.data());
+  REQUIRE(tokens.Accept(kRightBracket));
+
+  REQUIRE(tokens.SkipOver(kWhitespace, &skipped));
+  REQUIRE(skipped == "  ");
+  REQUIRE(tokens.CurrentMatch() == "*");
+
+  // Nothing to skip over.
+  REQUIRE(tokens.SkipOver(kWhitespace, &skipped));
+  REQUIRE(skipped.empty());
+
+  // Reaching the end of file.
+  REQUIRE_FALSE(tokens.SkipUntil(kLeftBracket, &skipped));
+  REQUIRE(skipped == "* 4");
+  REQUIRE(tokens.Accept(parser::kEOF));
+}
@@ -61,14 +61,6 @@ void StartupNotification::set_description(
 #endif  // HAVE_SN
 }
 
-void StartupNotification::IncrementRef() const {
-#ifdef HAVE_SN
-  if (context_ != nullptr) {
-    sn_launcher_context_ref(context_);
-  }
-#endif  // HAVE_SN
-}
-
 void StartupNotification::Initiate(
     std::string const& SN_MAYBE_UNUSED(binary_name),
     Time SN_MAYBE_UNUSED(time)) const {
@@ -80,12 +72,13 @@ void StartupNotification::Initiate(
 #endif  // HAVE_SN
 }
 
-void StartupNotification::SetupChildProcess() const {
+std::string StartupNotification::startup_id() const {
 #ifdef HAVE_SN
-  if (context_) {
-    sn_launcher_context_setup_child_process(context_);
+  if (context_ && sn_launcher_context_get_initiated(context_)) {
+    return sn_launcher_context_get_startup_id(context_);
   }
 #endif  // HAVE_SN
+  return std::string{};
 }
 
 void StartupNotification::Complete() const {
@@ -30,10 +30,11 @@ class StartupNotification {
   void set_name(std::string const& SN_MAYBE_UNUSED(name)) const;
   void set_description(std::string const& SN_MAYBE_UNUSED(description)) const;
 
-  void IncrementRef() const;
   void Initiate(std::string const& SN_MAYBE_UNUSED(binary_name),
                 Time SN_MAYBE_UNUSED(time)) const;
-  void SetupChildProcess() const;
+  // What the launched application expects in DESKTOP_STARTUP_ID, once
+  // initiated.
+  std::string startup_id() const;
   void Complete() const;
 
  private:
@@ -1,9 +1,6 @@
 #include "catch.hpp"
 
 #include <X11/Xlib.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <unistd.h>
 
 #ifdef HAVE_SN
 #include <libsn/sn.h>
@@ -57,24 +54,11 @@ TEST_CASE("StartupNotification") {
 #ifdef HAVE_SN
   // initiated!
   REQUIRE(sn_launcher_context_get_initiated(sn.context()));
+  // handed over to launched applications through their environment
+  REQUIRE_FALSE(sn.startup_id().empty());
+#else
+  REQUIRE(sn.startup_id().empty());
 #endif  // HAVE_SN
 
-  pid_t pid = fork();
-  if (pid < 0) {
-    FAIL("fork() failed");
-  }
-
-  if (pid == 0) {  // child
-    sn.IncrementRef();
-    sn.SetupChildProcess();
-    _exit(0);
-  }
-
-  // parent
-  int status;
-  waitpid(pid, &status, 0);
-  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-    FAIL("abnormal termination of child process");
-  }
   sn.Complete();
 }
@@ -1,11 +1,47 @@
 #include "subprocess.hh"
 
+#include <spawn.h>
+
 #include <cerrno>
 #include <cstring>
 #include <utility>
 
+#include "unix_features.hh"
 #include "util/log.hh"
 
+extern char** environ;
+
+namespace {
+
+// Builds the environment of the command as "NAME=value" strings: tint3's own,
+// with the overrides replacing or adding to it.
+std::vector<std::string> BuildEnvironment(
+    std::vector<std::pair<std::string, std::string>> const& overrides) {
+  std::vector<std::string> environment;
+  for (char** variable = environ; *variable != nullptr; ++variable) {
+    const char* equals = std::strchr(*variable, '=');
+    size_t name_length =
+        (equals != nullptr) ? (equals - *variable) : std::strlen(*variable);
+    bool overridden = false;
+    for (auto const& entry : overrides) {
+      if (entry.first.size() == name_length &&
+          std::strncmp(*variable, entry.first.c_str(), name_length) == 0) {
+        overridden = true;
+        break;
+      }
+    }
+    if (!overridden) {
+      environment.push_back(*variable);
+    }
+  }
+  for (auto const& entry : overrides) {
+    environment.push_back(entry.first + '=' + entry.second);
+  }
+  return environment;
+}
+
+}  // namespace
+
 void Subprocess::apply_options() {
   // Base case for the recursive template expansion in the header.
   // This one actually does nothing, it's only here to stop the recursion.
@@ -15,8 +51,8 @@ void Subprocess::set_option(capture&& option) {
   capture_ = std::move(option.value);
 }
 
-void Subprocess::set_option(child_callback&& option) {
-  child_callback_ = std::move(option.value);
+void Subprocess::set_option(environment_overrides&& option) {
+  environment_overrides_ = std::move(option.value);
 }
 
 void Subprocess::set_option(session_leader&& option) {
@@ -27,93 +63,111 @@ void Subprocess::set_option(shell&& option) {
   shell_ = std::move(option.value);
 }
 
-int Subprocess::start() {
+void Subprocess::set_option(stdin_fd&& option) {
+  stdin_fd_ = std::move(option.value);
+}
+
+void Subprocess::set_option(stdout_fd&& option) {
+  stdout_fd_ = std::move(option.value);
+}
+
+pid_t Subprocess::start() {
   if (command_.empty()) {
     util::log::Error() << "Refusing to launch empty command\n";
     return -1;
   }
 
-  std::function<void()> child_callback_ptr = child_callback_;
+  posix_spawn_file_actions_t file_actions;
+  posix_spawn_file_actions_init(&file_actions);
+  if (stdin_fd_ != -1) {
+    posix_spawn_file_actions_adddup2(&file_actions, stdin_fd_, STDIN_FILENO);
+  }
   if (capture_) {
     stdout_.reset(new util::Pipe{util::Pipe::Options::kNonBlocking});
     stderr_.reset(new util::Pipe{util::Pipe::Options::kNonBlocking});
-    child_callback_ptr = [&] {
-      if (dup2(stdout_->WriteEnd(), STDOUT_FILENO) == -1 ||
-          dup2(stderr_->WriteEnd(), STDERR_FILENO) == -1) {
-        util::log::Error() << "dup2: " << strerror(errno) << '\n';
-        _exit(1);
-      }
-      if (child_callback_) {
-        child_callback_();
-      }
-    };
+    posix_spawn_file_actions_adddup2(&file_actions, stdout_->WriteEnd(),
+                                     STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&file_actions, stderr_->WriteEnd(),
+                                     STDERR_FILENO);
+    for (int fd : {stdout_->ReadEnd(), stdout_->WriteEnd(),
+                   stderr_->ReadEnd(), stderr_->WriteEnd()}) {
+      posix_spawn_file_actions_addclose(&file_actions, fd);
+    }
+  } else if (stdout_fd_ != -1) {
+    posix_spawn_file_actions_adddup2(&file_actions, stdout_fd_, STDOUT_FILENO);
   }
 
-  pid_t child_pid = fork();
-  if (child_pid < 0) {
-    util::log::Error() << "fork: " << std::strerror(errno) << '\n';
-    return -1;
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  // Allow child to exist after parent destruction
+  if (session_leader_) {
+#ifdef TINT3_HAVE_POSIX_SPAWN_SETSID
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID);
+#else   // TINT3_HAVE_POSIX_SPAWN_SETSID
+    // Not quite a session of its own, but at least a process group.
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, 0);
+#endif  // TINT3_HAVE_POSIX_SPAWN_SETSID
   }
-  if (child_pid == 0) {
-    if (child_callback_ptr) {
-      child_callback_ptr();
-    }
 
-    // Allow child to exist after parent destruction
-    if (session_leader_) {
-      setsid();
+  // "/bin/sh" should be guaranteed to be a POSIX-compliant shell accepting
+  // the "-c" flag:
+  //   http://pubs.opengroup.org/onlinepubs/9699919799/utilities/sh.html
+  const char* path = (shell_ ? "/bin/sh" : command_.c_str());
+  std::vector<char*> argv;
+  if (shell_) {
+    argv.push_back(const_cast<char*>("sh"));
+    argv.push_back(const_cast<char*>("-c"));
+  }
+  argv.push_back(const_cast<char*>(command_.c_str()));
+  argv.push_back(nullptr);
+
+  std::vector<std::string> environment;
+  std::vector<char*> envp;
+  if (!environment_overrides_.empty()) {
+    environment = BuildEnvironment(environment_overrides_);
+    for (auto& variable : environment) {
+      envp.push_back(&variable[0]);
     }
+    envp.push_back(nullptr);
+  }
 
-    if (shell_) {
-      // "/bin/sh" should be guaranteed to be a POSIX-compliant shell
-      // accepting the "-c" flag:
-      //   http://pubs.opengroup.org/onlinepubs/9699919799/utilities/sh.html
-      execlp("/bin/sh", "sh", "-c", command_.c_str(), nullptr);
-
-      // In case execlp() fails and the process image is not replaced
-      util::log::Error() << "execlp(\"" << command_
-                         << "\"): " << std::strerror(errno) << '\n';
-      _exit(1);
-    } else {
-      execl(command_.c_str(), command_.c_str(), nullptr);
-
-      // In case execl() fails and the process image is not replaced
-      util::log::Error() << "execl(\"" << command_
-                         << "\"): " << std::strerror(errno) << '\n';
-      _exit(1);
-    }
+  pid_t child_pid = -1;
+  int error = posix_spawn(&child_pid, path, &file_actions, &attributes,
+                          argv.data(), envp.empty() ? environ : envp.data());
+  posix_spawnattr_destroy(&attributes);
+  posix_spawn_file_actions_destroy(&file_actions);
+
+  if (capture_) {
+    // Only the child writes to them, so that reading from them ends with it.
+    stdout_->CloseWriteEnd();
+    stderr_->CloseWriteEnd();
+  }
+
+  // Depending on the C library, failing to execute the command is either
+  // reported here, or through the exit status of the child process.
+  if (error != 0) {
+    util::log::Error() << "posix_spawn(\"" << command_
+                       << "\"): " << std::strerror(error) << '\n';
+    return -1;
   }
   return child_pid;
 }
 
-bool Subprocess::communicate(std::ostream* out_ss, std::ostream* err_ss) const {
-  static constexpr ssize_t kBufferSize = 1024;
-
-  auto read_fully = [&](int fd, std::ostream& ss) -> bool {
-    while (true) {
-      char buffer[kBufferSize];
-      int ret = read(fd, buffer, (kBufferSize - 1) * sizeof(char));
-      if (ret <= 0) {
-        if (ret == -1 && errno != EAGAIN) {
-          util::log::Error() << "Failed reading from pipe " << fd << ": "
-                             << strerror(errno) << '\n';
-          return false;
-        }
-        return true;
-      }
-      buffer[ret] = '\0';
-      ss << buffer;
-    }
-  };
+bool Subprocess::communicate(util::LineReader::Callback const& on_stdout_line,
+                             util::LineReader::Callback const& on_stderr_line) {
+  using Result = util::LineReader::Result;
 
   bool read_stdout = true;
-  if (out_ss != nullptr) {
-    read_stdout = read_fully(stdout_->ReadEnd(), *out_ss);
+  if (on_stdout_line) {
+    read_stdout = (stdout_reader_.Read(stdout_->ReadEnd(), on_stdout_line) !=
+                   Result::kError);
   }
 
   bool read_stderr = true;
-  if (err_ss != nullptr) {
-    read_stderr = read_fully(stderr_->ReadEnd(), *err_ss);
+  if (on_stderr_line) {
+    read_stderr = (stderr_reader_.Read(stderr_->ReadEnd(), on_stderr_line) !=
+                   Result::kError);
   }
 
   return read_stdout && read_stderr;
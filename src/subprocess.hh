@@ -1,13 +1,14 @@
 #ifndef TINT3_SUBPROCESS_HH
 #define TINT3_SUBPROCESS_HH
 
-#include <functional>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <unistd.h>
 
+#include "util/line_reader.hh"
 #include "util/pipe.hh"
 
 struct capture {
@@ -15,10 +16,13 @@ struct capture {
   bool value = true;
 };
 
-struct child_callback {
-  child_callback(std::function<void()> child_callback)
-      : value{child_callback} {}
-  std::function<void()> value;
+// Variables set in the environment of the command, on top of (or instead of)
+// those of tint3.
+struct environment_overrides {
+  environment_overrides(
+      std::vector<std::pair<std::string, std::string>> variables)
+      : value{std::move(variables)} {}
+  std::vector<std::pair<std::string, std::string>> value;
 };
 
 struct session_leader {
@@ -31,18 +35,39 @@ struct shell {
   bool value = true;
 };
 
+// File descriptors to use as the standard input and output of the command.
+struct stdin_fd {
+  stdin_fd(int fd) : value{fd} {}
+  int value = -1;
+};
+
+struct stdout_fd {
+  stdout_fd(int fd) : value{fd} {}
+  int value = -1;
+};
+
+// Subprocesses are started with posix_spawn(), rather than fork() and exec(),
+// which spares copying the page tables of tint3 (and its image caches) for
+// every command launched. There's nothing to run in the child process, so
+// everything it needs is set up through options.
+
 class Subprocess {
  public:
   Subprocess(Subprocess const& other) = delete;
   Subprocess(Subprocess&& other) = default;
 
   void set_option(capture&& option);
-  void set_option(child_callback&& option);
+  void set_option(environment_overrides&& option);
   void set_option(session_leader&& option);
   void set_option(shell&& option);
+  void set_option(stdin_fd&& option);
+  void set_option(stdout_fd&& option);
 
   pid_t start();
-  bool communicate(std::ostream* out_ss, std::ostream* err_ss) const;
+  // Reads what the captured command printed so far, calling back with every
+  // line of its standard output and error. Either callback may be empty.
+  bool communicate(util::LineReader::Callback const& on_stdout_line,
+                   util::LineReader::Callback const& on_stderr_line);
 
  private:
   template <typename... Args>
@@ -63,12 +88,16 @@ class Subprocess {
 
   bool capture_ = false;
   std::string command_;
-  std::function<void()> child_callback_;
+  std::vector<std::pair<std::string, std::string>> environment_overrides_;
   bool shell_ = false;
   bool session_leader_ = false;
+  int stdin_fd_ = -1;
+  int stdout_fd_ = -1;
 
   std::unique_ptr<util::Pipe> stdout_;
   std::unique_ptr<util::Pipe> stderr_;
+  util::LineReader stdout_reader_;
+  util::LineReader stderr_reader_;
 };
 
 template <typename... Args>
@@ -76,8 +105,7 @@ Subprocess make_subprocess(std::string command, Args&&... args) {
   return Subprocess{command, std::forward<Args>(args)...};
 }
 
-// ShellExec executes a command through /bin/sh, invoking the provided callback
-// in the child process.
+// ShellExec executes a command through /bin/sh, in a session of its own.
 template <typename... Args>
 pid_t ShellExec(std::string const& command, Args&&... args) {
   auto sp = make_subprocess(command, session_leader{true}, shell{true},
@@ -5,9 +5,16 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 
 #include "subprocess.hh"
+#include "util/environment.hh"
 
 TEST_CASE("make_subprocess") {
   auto exit_status = [](pid_t child_pid) {
@@ -21,6 +28,12 @@ TEST_CASE("make_subprocess") {
     return WEXITSTATUS(status);
   };
 
+  auto collect = [](std::vector<std::string>* lines) {
+    return [lines](absl::string_view line) {
+      lines->emplace_back(line.data(), line.size());
+    };
+  };
+
   SECTION("empty command") {
     auto sp = make_subprocess("");
     pid_t child_pid = sp.start();
@@ -28,10 +41,11 @@ TEST_CASE("make_subprocess") {
   }
 
   SECTION("execution failure") {
+    // Reported either right away or through the exit status, depending on
+    // the C library.
     auto sp = make_subprocess("bogus command");
     pid_t child_pid = sp.start();
-    REQUIRE(child_pid != -1);
-    REQUIRE(exit_status(child_pid) != 0);
+    REQUIRE((child_pid == -1 || exit_status(child_pid) != 0));
   }
 
   SECTION("default") {
@@ -41,13 +55,38 @@ TEST_CASE("make_subprocess") {
     REQUIRE(exit_status(child_pid) == 0);
   }
 
-  SECTION("callback") {
-    auto sp = make_subprocess("/bin/true", child_callback{[] { _exit(123); }});
+  SECTION("environment") {
+    environment::ScopedOverride<std::string> home{"HOME", "/nonexistent"};
+    auto sp = make_subprocess(
+        "[ \"${HOME}\" = /home ] && exit ${EXIT_STATUS}",
+        environment_overrides{{{"EXIT_STATUS", "123"}, {"HOME", "/home"}}},
+        shell{true});
     pid_t child_pid = sp.start();
     REQUIRE(child_pid != -1);
     REQUIRE(exit_status(child_pid) == 123);
   }
 
+  SECTION("stdin_fd and stdout_fd") {
+    int input[2], output[2];
+    REQUIRE(pipe(input) == 0);
+    REQUIRE(pipe(output) == 0);
+    REQUIRE(write(input[1], "hello\n", 6) == 6);
+    close(input[1]);
+
+    auto sp = make_subprocess("/bin/cat", stdin_fd{input[0]},
+                              stdout_fd{output[1]});
+    pid_t child_pid = sp.start();
+    close(input[0]);
+    close(output[1]);
+    REQUIRE(child_pid != -1);
+    REQUIRE(exit_status(child_pid) == 0);
+
+    char buffer[16] = {'\0'};
+    REQUIRE(read(output[0], buffer, sizeof(buffer) - 1) == 6);
+    REQUIRE(std::string{buffer} == "hello\n");
+    close(output[0]);
+  }
+
   SECTION("capture (no callback)") {
     auto sp = make_subprocess("printf stdout >&1; printf stderr >&2",
                               capture{true}, shell{true});
@@ -55,25 +94,37 @@ TEST_CASE("make_subprocess") {
     REQUIRE(child_pid != -1);
     REQUIRE(exit_status(child_pid) == 0);
 
-    std::ostringstream stdout, stderr;
-    REQUIRE(sp.communicate(&stdout, &stderr));
-    REQUIRE(stdout.str() == "stdout");
-    REQUIRE(stderr.str() == "stderr");
+    std::vector<std::string> stdout, stderr;
+    REQUIRE(sp.communicate(collect(&stdout), collect(&stderr)));
+    REQUIRE(stdout == std::vector<std::string>{"stdout"});
+    REQUIRE(stderr == std::vector<std::string>{"stderr"});
   }
 
-  SECTION("capture (with callback)") {
+  SECTION("capture (with environment)") {
     auto sp = make_subprocess(
         "printf stdout >&1; printf stderr >&2; exit ${EXIT_STATUS}",
-        capture{true}, child_callback{[] { setenv("EXIT_STATUS", "123", 1); }},
+        capture{true}, environment_overrides{{{"EXIT_STATUS", "123"}}},
         shell{true});
     pid_t child_pid = sp.start();
     REQUIRE(child_pid != -1);
     REQUIRE(exit_status(child_pid) == 123);
 
-    std::ostringstream stdout, stderr;
-    REQUIRE(sp.communicate(&stdout, &stderr));
-    REQUIRE(stdout.str() == "stdout");
-    REQUIRE(stderr.str() == "stderr");
+    std::vector<std::string> stdout, stderr;
+    REQUIRE(sp.communicate(collect(&stdout), collect(&stderr)));
+    REQUIRE(stdout == std::vector<std::string>{"stdout"});
+    REQUIRE(stderr == std::vector<std::string>{"stderr"});
+  }
+
+  SECTION("capture (lines)") {
+    auto sp = make_subprocess("printf 'one\\ntwo\\n\\nthree'", capture{true},
+                              shell{true});
+    pid_t child_pid = sp.start();
+    REQUIRE(child_pid != -1);
+    REQUIRE(exit_status(child_pid) == 0);
+
+    std::vector<std::string> stdout;
+    REQUIRE(sp.communicate(collect(&stdout), nullptr));
+    REQUIRE(stdout == (std::vector<std::string>{"one", "two", "", "three"}));
   }
 
   SECTION("shell") {
@@ -103,3 +154,45 @@ TEST_CASE("ShellExec") {
     REQUIRE(ShellExec("there is no such command") > 0);
   }
 }
+
+TEST_CASE("SpawnBenchmark", "[.][benchmark]") {
+  // Launching got slower with the size of tint3, which keeps images (and X
+  // buffers) around: copying its page tables took most of the time.
+  static constexpr size_t kFootprint = (256 << 20);  // 256 MiB
+  std::vector<char> footprint(kFootprint, 1);
+
+  static constexpr int kRounds = 200;
+  auto per_spawn = [](std::chrono::steady_clock::duration elapsed) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+               .count() /
+           static_cast<double>(kRounds);
+  };
+
+  // What it used to cost.
+  std::chrono::steady_clock::duration fork_elapsed{0};
+  for (int i = 0; i < kRounds; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    pid_t child_pid = fork();
+    if (child_pid == 0) {
+      execl("/bin/true", "true", nullptr);
+      _exit(1);
+    }
+    fork_elapsed += (std::chrono::steady_clock::now() - start);
+    REQUIRE(child_pid > 0);
+    waitpid(child_pid, nullptr, 0);
+  }
+
+  std::chrono::steady_clock::duration spawn_elapsed{0};
+  for (int i = 0; i < kRounds; ++i) {
+    auto sp = make_subprocess("/bin/true");
+    auto start = std::chrono::steady_clock::now();
+    pid_t child_pid = sp.start();
+    spawn_elapsed += (std::chrono::steady_clock::now() - start);
+    REQUIRE(child_pid > 0);
+    waitpid(child_pid, nullptr, 0);
+  }
+
+  std::cout << "fork/exec: " << per_spawn(fork_elapsed) << " us/spawn\n"
+            << "Subprocess::start: " << per_spawn(spawn_elapsed)
+            << " us/spawn\n";
+}
@@ -0,0 +1,166 @@
+#include <X11/Xutil.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "systray/capture_buffer.hh"
+#include "util/log.hh"
+#include "util/x11.hh"
+
+namespace {
+
+bool shm_attach_failed = false;
+
+int ShmAttachErrorHandler(Display* /* dsp */, XErrorEvent* /* e */) {
+  shm_attach_failed = true;
+  return 0;
+}
+
+}  // namespace
+
+CaptureBuffer::CaptureBuffer()
+    : display_(nullptr),
+      use_shm_(false),
+      shm_info_(),
+      image_(nullptr),
+      capacity_(0) {}
+
+CaptureBuffer::~CaptureBuffer() {
+  // Release() is expected to have been called while the display was still
+  // open, so only take care of what doesn't involve the X server here.
+  DestroyImage();
+  if (use_shm_ && capacity_ != 0) {
+    shmdt(shm_info_.shmaddr);
+  }
+}
+
+DATA32* CaptureBuffer::Get(Display* dsp, Visual* visual, Drawable drawable,
+                           unsigned int width, unsigned int height) {
+  if (!Reserve(dsp, visual, width, height)) {
+    return nullptr;
+  }
+
+  if (use_shm_) {
+    if (!XShmGetImage(display_, drawable, image_, 0, 0, AllPlanes)) {
+      return nullptr;
+    }
+  } else if (!XGetSubImage(display_, drawable, 0, 0, width, height, AllPlanes,
+                           ZPixmap, image_, 0, 0)) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<DATA32*>(image_->data);
+}
+
+void CaptureBuffer::Put(Drawable drawable, GC gc) {
+  if (image_ == nullptr) {
+    return;
+  }
+
+  if (use_shm_) {
+    XShmPutImage(display_, drawable, gc, image_, 0, 0, 0, 0, image_->width,
+                 image_->height, False);
+  } else {
+    XPutImage(display_, drawable, gc, image_, 0, 0, 0, 0, image_->width,
+              image_->height);
+  }
+}
+
+void CaptureBuffer::Release() {
+  DestroyImage();
+
+  if (use_shm_ && capacity_ != 0) {
+    XShmDetach(display_, &shm_info_);
+    shmdt(shm_info_.shmaddr);
+  }
+
+  heap_data_.reset();
+  capacity_ = 0;
+  display_ = nullptr;
+}
+
+bool CaptureBuffer::Reserve(Display* dsp, Visual* visual, unsigned int width,
+                            unsigned int height) {
+  if (display_ != nullptr && display_ != dsp) {
+    Release();
+  }
+
+  if (image_ != nullptr && image_->width == static_cast<int>(width) &&
+      image_->height == static_cast<int>(height)) {
+    return true;
+  }
+
+  // Only the XImage header depends on the geometry, the memory behind it is
+  // reused as long as it is large enough.
+  DestroyImage();
+
+  size_t bytes = sizeof(DATA32) * width * height;
+  if (bytes > capacity_) {
+    Display* previous_display = display_;
+    Release();
+    display_ = dsp;
+
+    if (previous_display == nullptr) {
+      use_shm_ = XShmQueryExtension(display_);
+    }
+    if (use_shm_ && !AttachSharedMemory(bytes)) {
+      util::log::Debug() << "MIT-SHM unusable, systray icons will be copied "
+                            "through the X connection\n";
+      use_shm_ = false;
+    }
+    if (!use_shm_) {
+      heap_data_.reset(new DATA32[width * height]);
+    }
+    capacity_ = bytes;
+  }
+
+  if (use_shm_) {
+    image_ = XShmCreateImage(display_, visual, 32, ZPixmap, shm_info_.shmaddr,
+                             &shm_info_, width, height);
+  } else {
+    image_ = XCreateImage(display_, visual, 32, ZPixmap, 0,
+                          reinterpret_cast<char*>(heap_data_.get()), width,
+                          height, 32, 0);
+  }
+  return image_ != nullptr;
+}
+
+bool CaptureBuffer::AttachSharedMemory(size_t bytes) {
+  shm_info_.shmid = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+  if (shm_info_.shmid == -1) {
+    return false;
+  }
+
+  shm_info_.shmaddr = static_cast<char*>(shmat(shm_info_.shmid, nullptr, 0));
+  if (shm_info_.shmaddr == reinterpret_cast<char*>(-1)) {
+    shmctl(shm_info_.shmid, IPC_RMID, nullptr);
+    return false;
+  }
+  shm_info_.readOnly = False;
+
+  {
+    // XShmAttach fails asynchronously, e.g. when the server is remote.
+    shm_attach_failed = false;
+    util::x11::ScopedErrorHandler error_handler(ShmAttachErrorHandler);
+    XShmAttach(display_, &shm_info_);
+    XSync(display_, False);
+  }
+
+  // The segment goes away as soon as both tint3 and the server detach from
+  // it, so it can't leak even if we crash.
+  shmctl(shm_info_.shmid, IPC_RMID, nullptr);
+
+  if (shm_attach_failed) {
+    shmdt(shm_info_.shmaddr);
+    return false;
+  }
+  return true;
+}
+
+void CaptureBuffer::DestroyImage() {
+  if (image_ != nullptr) {
+    // The pixel memory is owned by us, not by the XImage.
+    image_->data = nullptr;
+    XDestroyImage(image_);
+    image_ = nullptr;
+  }
+}
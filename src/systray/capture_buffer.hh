@@ -0,0 +1,54 @@
+#ifndef TINT3_SYSTRAYBAR_CAPTURE_BUFFER_HH
+#define TINT3_SYSTRAYBAR_CAPTURE_BUFFER_HH
+
+#include <Imlib2.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+
+#include <memory>
+
+// Client-side staging area for tray icons whose pixels have to be touched on
+// the CPU (heuristic masks for 24 bit icons, systray_asb).
+//
+// A single buffer is shared by all icons and only ever grows. When the MIT-SHM
+// extension is usable it lives in a shared memory segment, so pulling pixels
+// off the server and pushing them back doesn't copy them through the X
+// connection; otherwise it falls back to plain XGetSubImage/XPutImage on the
+// same reusable memory.
+class CaptureBuffer {
+ public:
+  CaptureBuffer();
+  ~CaptureBuffer();
+
+  CaptureBuffer(CaptureBuffer const&) = delete;
+  CaptureBuffer& operator=(CaptureBuffer const&) = delete;
+
+  // Copies the top left width x height pixels of the 32 bit drawable into the
+  // buffer and returns a pointer to them (tightly packed ARGB32 rows), or
+  // nullptr if the buffer couldn't be set up.
+  DATA32* Get(Display* dsp, Visual* visual, Drawable drawable,
+              unsigned int width, unsigned int height);
+
+  // Writes the pixels returned by the last call to Get() back to the top left
+  // corner of the 32 bit drawable.
+  void Put(Drawable drawable, GC gc);
+
+  // Frees the buffer and detaches the shared memory segment (if any). Must be
+  // called before the display connection is closed.
+  void Release();
+
+ private:
+  bool Reserve(Display* dsp, Visual* visual, unsigned int width,
+               unsigned int height);
+  bool AttachSharedMemory(size_t bytes);
+  void DestroyImage();
+
+  Display* display_;
+  bool use_shm_;
+  XShmSegmentInfo shm_info_;
+  XImage* image_;
+  std::unique_ptr<DATA32[]> heap_data_;
+  size_t capacity_;
+};
+
+#endif  // TINT3_SYSTRAYBAR_CAPTURE_BUFFER_HH
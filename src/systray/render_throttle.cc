@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cmath>
+
+#include "systray/render_throttle.hh"
+
+namespace {
+
+// How quickly past damage events are forgotten.
+constexpr double kDecaySeconds = 1.0;
+
+// Icons updating less often than this are rendered right away.
+constexpr double kQuietRate = 2.0;
+
+// An icon updating kReferenceRate times per second gets its updates coalesced
+// over kReferenceWindow (the fixed timeout we used to have). The window scales
+// linearly with the rate, within [kMinWindow, kMaxWindow].
+constexpr double kReferenceRate = 20.0;
+const absl::Duration kReferenceWindow = absl::Milliseconds(50);
+const absl::Duration kMinWindow = absl::Milliseconds(16);
+const absl::Duration kMaxWindow = absl::Milliseconds(250);
+
+}  // namespace
+
+UpdateRate::UpdateRate() : rate_(0.0), last_event_(absl::InfinitePast()) {}
+
+void UpdateRate::AddEvent(absl::Time now) {
+  rate_ = PerSecond(now) + 1.0 / kDecaySeconds;
+  last_event_ = now;
+}
+
+double UpdateRate::PerSecond(absl::Time now) const {
+  if (last_event_ == absl::InfinitePast()) {
+    return 0.0;
+  }
+  double elapsed = absl::ToDoubleSeconds(std::max(absl::ZeroDuration(),
+                                                  now - last_event_));
+  return rate_ * std::exp(-elapsed / kDecaySeconds);
+}
+
+absl::Duration UpdateRate::CoalescingWindow(absl::Time now) const {
+  double rate = PerSecond(now);
+  if (rate < kQuietRate) {
+    return absl::ZeroDuration();
+  }
+  return std::min(std::max(kReferenceWindow * (rate / kReferenceRate),
+                           kMinWindow),
+                  kMaxWindow);
+}
+
+RenderBudget::RenderBudget(absl::Duration frame_length,
+                           unsigned int renders_per_frame)
+    : frame_length_(frame_length),
+      renders_per_frame_(renders_per_frame),
+      frame_start_(absl::InfinitePast()),
+      used_(0) {}
+
+absl::Time RenderBudget::Reserve(absl::Time earliest) {
+  absl::Time frame =
+      absl::UnixEpoch() +
+      absl::Floor(earliest - absl::UnixEpoch(), frame_length_);
+  if (frame > frame_start_) {
+    frame_start_ = frame;
+    used_ = 0;
+  }
+  // Slots in the requested frame may have been taken by renders scheduled
+  // earlier, in which case we move on to the first frame with room left.
+  while (used_ >= renders_per_frame_) {
+    frame_start_ += frame_length_;
+    used_ = 0;
+  }
+  ++used_;
+  return std::max(earliest, frame_start_);
+}
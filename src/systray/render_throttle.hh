@@ -0,0 +1,46 @@
+#ifndef TINT3_SYSTRAYBAR_RENDER_THROTTLE_HH
+#define TINT3_SYSTRAYBAR_RENDER_THROTTLE_HH
+
+#include "absl/time/time.h"
+
+// Tracks how often a single tray icon reports damage (as an exponentially
+// decaying event rate), and derives how long its updates should be coalesced.
+class UpdateRate {
+ public:
+  UpdateRate();
+
+  // Records a damage event.
+  void AddEvent(absl::Time now);
+
+  // Events per second, decayed to the given point in time.
+  double PerSecond(absl::Time now) const;
+
+  // How long to wait after a damage event before rendering the icon: zero for
+  // icons that rarely change, and growing with the update rate for busy ones
+  // (e.g., animations, or wine icons updating whenever the mouse is over
+  // them).
+  absl::Duration CoalescingWindow(absl::Time now) const;
+
+ private:
+  double rate_;
+  absl::Time last_event_;
+};
+
+// Limits the number of icon renders per frame, pushing the excess to the
+// following frames, so that lots of busy icons can't monopolize the event loop.
+class RenderBudget {
+ public:
+  RenderBudget(absl::Duration frame_length, unsigned int renders_per_frame);
+
+  // Reserves a render slot at or after the given time point, and returns when
+  // that is.
+  absl::Time Reserve(absl::Time earliest);
+
+ private:
+  absl::Duration frame_length_;
+  unsigned int renders_per_frame_;
+  absl::Time frame_start_;
+  unsigned int used_;
+};
+
+#endif  // TINT3_SYSTRAYBAR_RENDER_THROTTLE_HH
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include "systray/render_throttle.hh"
+
+TEST_CASE("UpdateRate") {
+  absl::Time now = absl::FromUnixSeconds(1000);
+  UpdateRate rate;
+
+  SECTION("starts out idle") {
+    REQUIRE(rate.PerSecond(now) == 0.0);
+    REQUIRE(rate.CoalescingWindow(now) == absl::ZeroDuration());
+  }
+
+  SECTION("rarely changing icons are rendered immediately") {
+    for (int i = 0; i < 10; ++i) {
+      rate.AddEvent(now);
+      now += absl::Seconds(5);
+    }
+    REQUIRE(rate.PerSecond(now) < 1.0);
+    REQUIRE(rate.CoalescingWindow(now) == absl::ZeroDuration());
+  }
+
+  SECTION("busy icons get longer windows") {
+    for (int i = 0; i < 100; ++i) {
+      rate.AddEvent(now);
+      now += absl::Milliseconds(100);
+    }
+    absl::Duration ten_per_second = rate.CoalescingWindow(now);
+    REQUIRE(ten_per_second > absl::ZeroDuration());
+
+    for (int i = 0; i < 500; ++i) {
+      rate.AddEvent(now);
+      now += absl::Milliseconds(10);
+    }
+    absl::Duration hundred_per_second = rate.CoalescingWindow(now);
+    REQUIRE(hundred_per_second > ten_per_second);
+    REQUIRE(hundred_per_second <= absl::Milliseconds(250));
+  }
+
+  SECTION("the rate decays once the icon calms down") {
+    for (int i = 0; i < 100; ++i) {
+      rate.AddEvent(now);
+      now += absl::Milliseconds(10);
+    }
+    REQUIRE(rate.CoalescingWindow(now) > absl::ZeroDuration());
+    REQUIRE(rate.CoalescingWindow(now + absl::Seconds(10)) ==
+            absl::ZeroDuration());
+  }
+}
+
+TEST_CASE("RenderBudget") {
+  absl::Time now = absl::FromUnixSeconds(1000);
+  RenderBudget budget{absl::Milliseconds(16), 2};
+
+  SECTION("renders within budget are not delayed") {
+    REQUIRE(budget.Reserve(now) == now);
+    REQUIRE(budget.Reserve(now) == now);
+  }
+
+  SECTION("excess renders are pushed to the following frames") {
+    REQUIRE(budget.Reserve(now) == now);
+    REQUIRE(budget.Reserve(now) == now);
+    REQUIRE(budget.Reserve(now) == now + absl::Milliseconds(16));
+    REQUIRE(budget.Reserve(now) == now + absl::Milliseconds(16));
+    REQUIRE(budget.Reserve(now) == now + absl::Milliseconds(32));
+  }
+
+  SECTION("a new frame starts with a fresh budget") {
+    REQUIRE(budget.Reserve(now) == now);
+    REQUIRE(budget.Reserve(now) == now);
+    absl::Time later = now + absl::Milliseconds(100);
+    REQUIRE(budget.Reserve(later) == later);
+    REQUIRE(budget.Reserve(later) == later);
+  }
+}
@@ -31,6 +31,7 @@
 #include <cstring>
 
 #include "absl/strings/ascii.h"
+#include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 
 #include "panel.hh"
@@ -76,6 +77,9 @@ void CleanupSystray(Timer& timer) {
   systray.on_screen_ = false;
   systray.FreeArea();
 
+  systray.FreeRenderTarget();
+  systray.capture_buffer().Release();
+
   if (render_background) {
     XFreePixmap(server.dsp, render_background);
     render_background = 0;
@@ -129,6 +133,12 @@ void Systraybar::DrawForeground(cairo_t* /* c */) {
                                       height_, server.depth);
     XCopyArea(server.dsp, pix_, render_background, server.gc, 0, 0, width_,
               height_, 0, 0);
+
+    // pix_ has just been recreated, so the picture on it has to follow
+    FreeRenderTarget();
+    render_target_ = XRenderCreatePicture(
+        server.dsp, pix_, XRenderFindVisualFormat(server.dsp, server.visual),
+        0, 0);
   }
 
   should_refresh_ = true;
@@ -503,6 +513,9 @@ void Systraybar::RefreshIcons(Timer& timer) {
 
 namespace {
 
+// Half a frame at 60 Hz.
+const absl::Duration kRenderSlack = absl::Milliseconds(8);
+
 void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
   // we end up in this function only in real transparency mode or if
   // systray_task_asb != 100 0 0
@@ -513,84 +526,53 @@ void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
   if (traywin->width == 0 || traywin->height == 0) {
     // reschedule rendering since the geometry information has not yet been
     // processed (can happen on slow cpu)
-    systray.RenderIcon(traywin, timer);
+    systray.ScheduleRender(traywin, timer, absl::Milliseconds(50));
     return;
   }
 
-  // good systray icons support 32 bit depth, but some icons are still 24 bit.
-  // We create a heuristic mask for these icons, i.e. we get the rgb value in
-  // the top left corner, and
-  // mask out all pixel with the same rgb value
-  Panel* panel = systray.panel_;
-
-  // Very ugly hack, but somehow imlib2 is not able to get the image from the
-  // traywindow itself,
-  // so we first render the tray window onto a pixmap, and then we tell imlib2
-  // to use this pixmap as
-  // drawable. If someone knows why it does not work with the traywindow itself,
-  // please tell me ;)
-  Pixmap tmp_pmap = XCreatePixmap(server.dsp, server.root_window(),
-                                  traywin->width, traywin->height, 32);
-  XRenderPictFormat* f = nullptr;
-
-  if (traywin->depth == 24) {
-    f = XRenderFindStandardFormat(server.dsp, PictStandardRGB24);
-  } else if (traywin->depth == 32) {
-    f = XRenderFindStandardFormat(server.dsp, PictStandardARGB32);
-  } else {
-    util::log::Debug() << "Strange tray icon found with depth: "
-                       << traywin->depth << '\n';
+  if (!traywin->PrepareRenderResources()) {
     return;
   }
 
-  Picture pict_image =
-      XRenderCreatePicture(server.dsp, traywin->child_id, f, 0, 0);
-  Picture pict_drawable = XRenderCreatePicture(
-      server.dsp, tmp_pmap, XRenderFindVisualFormat(server.dsp, server.visual),
-      0, 0);
-  XRenderComposite(server.dsp, PictOpSrc, pict_image, None, pict_drawable, 0, 0,
-                   0, 0, 0, 0, traywin->width, traywin->height);
-  XRenderFreePicture(server.dsp, pict_image);
-  XRenderFreePicture(server.dsp, pict_drawable);
-  // end of the ugly hack and we can continue as before
-
-  imlib_context_set_visual(server.visual);
-  imlib_context_set_colormap(server.colormap);
-  imlib_context_set_drawable(tmp_pmap);
-  Imlib_Image image = imlib_create_image_from_drawable(0, 0, 0, traywin->width,
-                                                       traywin->height, 1);
-  if (!image) return;
-
-  imlib_context_set_image(image);
-  // if (traywin->depth == 24)
-  // imlib_save_image("/home/thil77/test.jpg");
-  imlib_image_set_has_alpha(1);
-  DATA32* data = imlib_image_get_data();
-
-  if (traywin->depth == 24) {
-    CreateHeuristicMask(data, traywin->width, traywin->height);
-  }
-
-  if (systray.needs_true_color()) {
-    AdjustASB(data, traywin->width, traywin->height, systray.alpha,
-              (float)systray.saturation / 100, (float)systray.brightness / 100);
-  }
-
-  imlib_image_put_back_data(data);
-  XCopyArea(server.dsp, render_background, systray.pix_, server.gc,
-            traywin->x - systray.panel_x_, traywin->y - systray.panel_y_,
-            traywin->width, traywin->height, traywin->x - systray.panel_x_,
-            traywin->y - systray.panel_y_);
-  RenderImage(&server, systray.pix_, image, traywin->x - systray.panel_x_,
-              traywin->y - systray.panel_y_);
-  XCopyArea(server.dsp, systray.pix_, panel->main_win_, server.gc,
-            traywin->x - systray.panel_x_, traywin->y - systray.panel_y_,
-            traywin->width, traywin->height, traywin->x, traywin->y);
-  imlib_free_image_and_decache();
+  Panel* panel = systray.panel_;
+  int x = traywin->x - systray.panel_x_;
+  int y = traywin->y - systray.panel_y_;
+  Picture source = traywin->child_picture();
 
-  XFreePixmap(server.dsp, tmp_pmap);
-  imlib_context_set_visual(server.visual);
-  imlib_context_set_colormap(server.colormap);
+  // good systray icons support 32 bit depth, but some icons are still 24 bit.
+  // We create a heuristic mask for these icons, i.e. we get the rgb value in
+  // the top left corner, and mask out all pixel with the same rgb value.
+  // That, and systray_asb, need the pixels on our side; everything else is
+  // composited directly on the server.
+  if (traywin->depth == 24 || systray.needs_true_color()) {
+    XRenderComposite(server.dsp, PictOpSrc, source, None,
+                     traywin->capture_picture(), 0, 0, 0, 0, 0, 0,
+                     traywin->width, traywin->height);
+
+    DATA32* data =
+        systray.capture_buffer().Get(server.dsp, server.visual,
+                                     traywin->capture_pixmap(), traywin->width,
+                                     traywin->height);
+    if (!data) {
+      return;
+    }
+
+    MaskAdjustASBAndPremultiply(data, traywin->width, traywin->height,
+                                traywin->depth == 24, systray.alpha,
+                                (float)systray.saturation / 100,
+                                (float)systray.brightness / 100);
+    systray.capture_buffer().Put(traywin->capture_pixmap(),
+                                 traywin->capture_gc());
+    source = traywin->capture_picture();
+  }
+
+  XCopyArea(server.dsp, render_background, systray.pix_, server.gc, x, y,
+            traywin->width, traywin->height, x, y);
+  XRenderComposite(server.dsp, PictOpOver, source, None,
+                   systray.render_target(), 0, 0, 0, 0, x, y, traywin->width,
+                   traywin->height);
+  XCopyArea(server.dsp, systray.pix_, panel->main_win_, server.gc, x, y,
+            traywin->width, traywin->height, traywin->x, traywin->y);
 
   if (traywin->damage) {
     XDamageSubtract(server.dsp, traywin->damage, None, None);
@@ -603,15 +585,8 @@ void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
 
 void Systraybar::RenderIcon(TrayWindow* traywin, Timer& timer) {
   if (server.real_transparency() || needs_true_color()) {
-    // wine tray icons update whenever mouse is over them, so we limit the
-    // updates to 50 ms
-    if (!traywin->render_timeout) {
-      traywin->render_timeout =
-          timer.SetTimeout(absl::Milliseconds(50), [traywin, &timer]() -> bool {
-            SystrayRenderIconNow(traywin, timer);
-            return true;
-          });
-    }
+    ScheduleRender(traywin, timer,
+                   traywin->update_rate.CoalescingWindow(timer.Now()));
   } else {
     // comment by andreas: I'm still not sure, what exactly we need to do
     // here... Somehow trayicons which do not
@@ -628,6 +603,59 @@ void Systraybar::RenderIcon(TrayWindow* traywin, Timer& timer) {
   }
 }
 
+void Systraybar::IconDamaged(TrayWindow* traywin, Timer& timer) {
+  absl::Time now = timer.Now();
+#ifdef _TINT3_DEBUG
+  bool was_throttled =
+      (traywin->update_rate.CoalescingWindow(now) != absl::ZeroDuration());
+#endif  // _TINT3_DEBUG
+  traywin->update_rate.AddEvent(now);
+#ifdef _TINT3_DEBUG
+  bool is_throttled =
+      (traywin->update_rate.CoalescingWindow(now) != absl::ZeroDuration());
+  if (was_throttled != is_throttled) {
+    util::log::Debug() << "Systray update rates changed:\n"
+                       << DumpUpdateRates(now);
+  }
+#endif  // _TINT3_DEBUG
+  RenderIcon(traywin, timer);
+}
+
+void Systraybar::ScheduleRender(TrayWindow* traywin, Timer& timer,
+                                absl::Duration delay) {
+  // a pending render will pick up whatever changed in the meantime
+  if (traywin->render_timeout) {
+    return;
+  }
+
+  absl::Time now = timer.Now();
+  absl::Time when = render_budget_.Reserve(now + delay);
+  if (when <= now) {
+    SystrayRenderIconNow(traywin, timer);
+    return;
+  }
+
+  traywin->render_timeout =
+      timer.SetTimeout(when - now,
+                       [traywin, &timer]() -> bool {
+                         SystrayRenderIconNow(traywin, timer);
+                         return true;
+                       },
+                       kRenderSlack);
+}
+
+std::string Systraybar::DumpUpdateRates(absl::Time now) const {
+  std::string dump;
+  for (auto const& traywin : list_icons_) {
+    absl::StrAppendFormat(
+        &dump, "  window 0x%lx: %.2f updates/s, coalesced over %d ms\n",
+        traywin->child_id, traywin->update_rate.PerSecond(now),
+        absl::ToInt64Milliseconds(
+            traywin->update_rate.CoalescingWindow(now)));
+  }
+  return dump;
+}
+
 void Systraybar::RemoveIconInternal(TrayWindow* traywin, Timer& timer) {
   if (traywin->render_timeout) {
     timer.ClearInterval(traywin->render_timeout);
@@ -696,6 +724,17 @@ void Systraybar::NetMessage(XClientMessageEvent* e) {
   }
 }
 
+CaptureBuffer& Systraybar::capture_buffer() { return capture_buffer_; }
+
+Picture Systraybar::render_target() const { return render_target_; }
+
+void Systraybar::FreeRenderTarget() {
+  if (render_target_ != None) {
+    XRenderFreePicture(server.dsp, render_target_);
+    render_target_ = None;
+  }
+}
+
 bool Systraybar::needs_true_color() const {
   return alpha != 100 || brightness != 0 || saturation != 0;
 }
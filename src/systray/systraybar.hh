@@ -2,9 +2,15 @@
 #define TINT3_SYSTRAYBAR_SYSTRAYBAR_HH
 
 #include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xrender.h>
 
 #include <list>
+#include <string>
 
+#include "absl/time/time.h"
+
+#include "systray/capture_buffer.hh"
+#include "systray/render_throttle.hh"
 #include "systray/tray_window.hh"
 #include "util/area.hh"
 #include "util/common.hh"
@@ -24,6 +30,12 @@ class Systraybar : public Area {
   int icon_size, icons_per_column, icons_per_row, margin_;
 
   bool needs_true_color() const;
+
+  // Shared client-side pixel buffer for icons rendered by ourselves.
+  CaptureBuffer& capture_buffer();
+  // Picture on pix_, recreated whenever pix_ is.
+  Picture render_target() const;
+  void FreeRenderTarget();
   bool should_refresh() const;
   void set_should_refresh(bool should_refresh);
 
@@ -38,6 +50,14 @@ class Systraybar : public Area {
   TrayWindow* FindTrayWindow(Window window_id);
   void RefreshIcons(Timer& timer);
   void RenderIcon(TrayWindow* traywin, Timer& timer);
+  // Like RenderIcon(), but also accounts for the damage in the icon's update
+  // rate (see UpdateRate).
+  void IconDamaged(TrayWindow* traywin, Timer& timer);
+  // Renders the icon after the given delay, or later if the per-frame render
+  // budget has been used up. Does nothing if a render is already pending.
+  void ScheduleRender(TrayWindow* traywin, Timer& timer, absl::Duration delay);
+  // Per-icon update rates and coalescing windows, for debugging.
+  std::string DumpUpdateRates(absl::Time now) const;
   void RemoveIcon(TrayWindow* traywin, Timer& timer);
   void RemoveAllIcons(Timer& timer);
   void Clear(Timer& timer);
@@ -57,6 +77,9 @@ class Systraybar : public Area {
  private:
   bool should_refresh_;
   std::list<TrayWindow*> list_icons_;
+  CaptureBuffer capture_buffer_;
+  RenderBudget render_budget_{absl::Milliseconds(16), 4};
+  Picture render_target_ = None;
 };
 
 // net_sel_win != None when protocol started
@@ -1,6 +1,7 @@
 #include "systray/tray_window.hh"
 
 #include "server.hh"
+#include "util/log.hh"
 
 TrayWindow::TrayWindow(Server* server, Window tray_id, Window child_id)
     : tray_id(tray_id),
@@ -13,9 +14,16 @@ TrayWindow::TrayWindow(Server* server, Window tray_id, Window child_id)
       hide(false),
       depth(0),
       damage(0),
-      server_(server) {}
+      server_(server),
+      render_width_(0),
+      render_height_(0),
+      child_picture_(None),
+      capture_pixmap_(None),
+      capture_picture_(None),
+      capture_gc_(nullptr) {}
 
 TrayWindow::~TrayWindow() {
+  FreeRenderResources();
   XSelectInput(server_->dsp, child_id, NoEventMask);
 
   if (!hide) {
@@ -30,3 +38,63 @@ TrayWindow::~TrayWindow() {
   XDestroyWindow(server_->dsp, tray_id);
   XSync(server_->dsp, False);
 }
+
+Picture TrayWindow::child_picture() const { return child_picture_; }
+
+Pixmap TrayWindow::capture_pixmap() const { return capture_pixmap_; }
+
+Picture TrayWindow::capture_picture() const { return capture_picture_; }
+
+GC TrayWindow::capture_gc() const { return capture_gc_; }
+
+bool TrayWindow::PrepareRenderResources() {
+  if (child_picture_ != None && render_width_ == width &&
+      render_height_ == height) {
+    return true;
+  }
+
+  FreeRenderResources();
+
+  XRenderPictFormat* f = nullptr;
+  if (depth == 24) {
+    f = XRenderFindStandardFormat(server_->dsp, PictStandardRGB24);
+  } else if (depth == 32) {
+    f = XRenderFindStandardFormat(server_->dsp, PictStandardARGB32);
+  } else {
+    util::log::Debug() << "Strange tray icon found with depth: " << depth
+                       << '\n';
+    return false;
+  }
+
+  child_picture_ = XRenderCreatePicture(server_->dsp, child_id, f, 0, 0);
+  capture_pixmap_ = XCreatePixmap(server_->dsp, server_->root_window(), width,
+                                  height, 32);
+  capture_picture_ = XRenderCreatePicture(
+      server_->dsp, capture_pixmap_,
+      XRenderFindStandardFormat(server_->dsp, PictStandardARGB32), 0, 0);
+  capture_gc_ = XCreateGC(server_->dsp, capture_pixmap_, 0, nullptr);
+  render_width_ = width;
+  render_height_ = height;
+  return true;
+}
+
+void TrayWindow::FreeRenderResources() {
+  if (capture_gc_ != nullptr) {
+    XFreeGC(server_->dsp, capture_gc_);
+    capture_gc_ = nullptr;
+  }
+  if (capture_picture_ != None) {
+    XRenderFreePicture(server_->dsp, capture_picture_);
+    capture_picture_ = None;
+  }
+  if (capture_pixmap_ != None) {
+    XFreePixmap(server_->dsp, capture_pixmap_);
+    capture_pixmap_ = None;
+  }
+  if (child_picture_ != None) {
+    XRenderFreePicture(server_->dsp, child_picture_);
+    child_picture_ = None;
+  }
+  render_width_ = 0;
+  render_height_ = 0;
+}
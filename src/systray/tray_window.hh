@@ -3,7 +3,9 @@
 
 #include <X11/Xlib.h>
 #include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xrender.h>
 
+#include "systray/render_throttle.hh"
 #include "util/timer.hh"
 
 // forward declaration
@@ -24,9 +26,32 @@ class TrayWindow {
   int depth;
   Damage damage;
   Interval::Id render_timeout;
+  UpdateRate update_rate;
+
+  // Server-side resources used to render the icon ourselves (real
+  // transparency or systray_asb). They are created on first use and kept
+  // alive across renders until the icon changes size or goes away.
+  //
+  // Picture on the embedded window, i.e. the source of every render.
+  Picture child_picture() const;
+  // 32 bit staging pixmap (and its ARGB32 picture and GC) for icons whose
+  // pixels need to be processed on the CPU.
+  Pixmap capture_pixmap() const;
+  Picture capture_picture() const;
+  GC capture_gc() const;
+
+  // (Re)creates the resources above for the current geometry and depth.
+  // Returns false if the icon can't be rendered.
+  bool PrepareRenderResources();
+  void FreeRenderResources();
 
  private:
   Server* server_;
+  int render_width_, render_height_;
+  Picture child_picture_;
+  Pixmap capture_pixmap_;
+  Picture capture_picture_;
+  GC capture_gc_;
 };
 
 #endif  // TINT3_SYSTRAYBAR_TRAY_WINDOW_HH
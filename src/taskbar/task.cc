@@ -50,6 +50,9 @@ namespace {
 
 const char kUntitled[] = "Untitled";
 
+// Blinking unevenly by a tenth of its one second period isn't noticeable.
+const absl::Duration kUrgentBlinkSlack = absl::Milliseconds(100);
+
 unsigned int GetMonitor(Window win) {
   unsigned int monitor = 0;
 
@@ -644,7 +647,8 @@ void Task::AddUrgent() {
     urgent_list.push_front(tsk);
 
     if (!urgent_timeout) {
-      urgent_timeout = timer_.SetInterval(absl::Seconds(1), BlinkUrgent);
+      urgent_timeout =
+          timer_.SetInterval(absl::Seconds(1), BlinkUrgent, kUrgentBlinkSlack);
       BlinkUrgent();
     }
   }
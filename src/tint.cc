@@ -35,13 +35,16 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <unordered_map>
+#include <utility>
 
 #include "absl/base/attributes.h"
 
 #include "config.hh"
 #include "dnd/dnd.hh"
+#include "launcher/icon_cache_tool.hh"
 #include "launcher/launcher.hh"
 #include "panel.hh"
 #include "server.hh"
@@ -57,6 +60,7 @@
 #include "util/log.hh"
 #include "util/timer.hh"
 #include "util/window.hh"
+#include "util/x11.hh"
 #include "util/xdg.hh"
 #include "version.hh"
 
@@ -80,6 +84,22 @@ Use `tint3 theme help` or `man 1 tint3` for usage information.
 )EOF";
 }
 
+// Lets executors read the output of their commands from the event loop.
+class EventLoopWatcher : public Executor::Watcher {
+ public:
+  explicit EventLoopWatcher(util::x11::EventLoop* event_loop)
+      : event_loop_(event_loop) {}
+
+  void Watch(int fd, std::function<void()> handler) override {
+    event_loop_->RegisterFileDescriptor(fd, std::move(handler));
+  }
+
+  void Unwatch(int fd) override { event_loop_->UnregisterFileDescriptor(fd); }
+
+ private:
+  util::x11::EventLoop* event_loop_;
+};
+
 }  // namespace
 
 // Drag and Drop state variables
@@ -885,6 +905,10 @@ int main(int argc, char* argv[]) {
   if (argc > 1 && std::string(argv[1]) == "theme")
     return ThemeManager(argc, argv);
 
+  // Same for dumping the icon caches.
+  if (argc > 1 && std::string(argv[1]) == "icon-cache")
+    return IconCacheTool(argc, argv);
+
 start:
   std::string config_path;
   Init(argc, argv, &config_path);
@@ -950,6 +974,39 @@ start:
     std::exit(1);
   }
 
+  // Launcher icons are loaded in the background, and swapped in as they're
+  // ready.
+  event_loop.RegisterFileDescriptor(LauncherWorkerPool().completion_fd(), [] {
+    LauncherWorkerPool().RunCompletions();
+  });
+
+  // Desktop entries and icon themes are picked up again as they change.
+  WatchLauncherFiles();
+  if (LauncherFileWatcher().IsAlive()) {
+    event_loop.RegisterFileDescriptor(LauncherFileWatcher().fd(),
+                                      [] { HandleLauncherFileChanges(); });
+  }
+
+  // Executors run their commands in the background, and are stopped before
+  // the event loop goes away.
+  EventLoopWatcher executor_watcher{&event_loop};
+  for (auto& execp : executors) {
+    execp.Start(&timer, &executor_watcher);
+  }
+  ABSL_ATTRIBUTE_UNUSED auto stop_executors = util::MakeScopedCallback([] {
+    for (auto& execp : executors) {
+      execp.Stop();
+    }
+  });
+
+#ifdef ENABLE_BATTERY
+  // Batteries are updated as soon as the kernel reports a change.
+  if (BatteryEventFd() != -1) {
+    event_loop.RegisterFileDescriptor(BatteryEventFd(),
+                                      [] { HandleBatteryEvents(); });
+  }
+#endif  // ENABLE_BATTERY
+
   // Setup a handler for child termination
   pending_children = false;
   SignalAction(SIGCHLD, [](int) { pending_children = true; });
@@ -1130,7 +1187,7 @@ start:
     XDamageNotifyEvent* ev = reinterpret_cast<XDamageNotifyEvent*>(&e);
     TrayWindow* traywin = systray.FindTrayWindow(ev->drawable);
     if (traywin != nullptr) {
-      systray.RenderIcon(traywin, timer);
+      systray.IconDamaged(traywin, timer);
     }
   });
 
@@ -9,6 +9,13 @@
 #include "util/log.hh"
 #include "util/window.hh"
 
+namespace {
+
+// A tooltip showing up or going away 20 ms later can't be told apart.
+const absl::Duration kTimeoutSlack = absl::Milliseconds(20);
+
+}  // namespace
+
 TooltipConfig tooltip_config;
 
 Tooltip::Tooltip(Server* server, Timer* timer)
@@ -54,7 +61,8 @@ void Tooltip::Show(Area const* area, XEvent const* e, std::string text) {
         Update(area, e, text);
         XFlush(server_->dsp);
         return false;
-      });
+      },
+      kTimeoutSlack);
 }
 
 void Tooltip::Update(Area const* area, XEvent const* e,
@@ -221,5 +229,6 @@ void Tooltip::Hide() {
         XUnmapWindow(server_->dsp, window_);
         XFlush(server_->dsp);
         return false;
-      });
+      },
+      kTimeoutSlack);
 }
@@ -25,6 +25,13 @@
 #include <X11/Xutil.h>
 #include <X11/extensions/Xrender.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // defined(__SSE2__)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif  // defined(__x86_64__) || defined(__i386__)
+
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
@@ -201,6 +208,179 @@ std::tuple<double, double, double> HsvToRgb(double H, double S, double V) {
   return std::make_tuple(R_ + m, G_ + m, B_ + m);
 }
 
+// The pixel loops below process an image in blocks small enough to stay in
+// L1 cache, so that masking, ASB and premultiplication can be chained with a
+// single trip through memory.
+constexpr unsigned int kBlockPixels = 256;
+
+// x * a / 255, rounded to the nearest integer without a division.
+inline unsigned int premultiply(unsigned int x, unsigned int a) {
+  unsigned int t = x * a + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+void MaskPixelsScalar(DATA32* data, unsigned int n, DATA32 mask_color) {
+  for (unsigned int i = 0; i < n; ++i) {
+    if ((data[i] & 0x00FFFFFF) == mask_color) {
+      data[i] &= 0x00FFFFFF;
+    }
+  }
+}
+
+void PremultiplyPixelsScalar(DATA32* data, unsigned int n) {
+  for (unsigned int i = 0; i < n; ++i) {
+    unsigned int a = data[i] >> 24;
+    if (a == 0xFF) {
+      continue;
+    }
+    data[i] = pack_argb(a, premultiply((data[i] >> 16) & 0xFF, a),
+                        premultiply((data[i] >> 8) & 0xFF, a),
+                        premultiply(data[i] & 0xFF, a));
+  }
+}
+
+#if defined(__SSE2__)
+
+// Clears the alpha channel of every pixel whose color matches mask_color.
+unsigned int MaskPixelsSSE2(DATA32* data, unsigned int n, DATA32 mask_color) {
+  const __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+  const __m128i mask = _mm_set1_epi32(mask_color);
+  unsigned int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+    __m128i px = _mm_loadu_si128(p);
+    __m128i matches = _mm_cmpeq_epi32(_mm_and_si128(px, rgb), mask);
+    _mm_storeu_si128(p, _mm_andnot_si128(_mm_andnot_si128(rgb, matches), px));
+  }
+  return i;
+}
+
+// Multiplies 2 pixels unpacked to 16 bit lanes by their alpha.
+inline __m128i PremultiplyUnpackedSSE2(__m128i px) {
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xFF), 0xFF);
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, a), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+unsigned int PremultiplyPixelsSSE2(DATA32* data, unsigned int n) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha = _mm_set1_epi32(0xFF000000);
+  unsigned int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i* p = reinterpret_cast<__m128i*>(data + i);
+    __m128i px = _mm_loadu_si128(p);
+    __m128i lo = PremultiplyUnpackedSSE2(_mm_unpacklo_epi8(px, zero));
+    __m128i hi = PremultiplyUnpackedSSE2(_mm_unpackhi_epi8(px, zero));
+    __m128i colors = _mm_andnot_si128(alpha, _mm_packus_epi16(lo, hi));
+    _mm_storeu_si128(p, _mm_or_si128(colors, _mm_and_si128(px, alpha)));
+  }
+  return i;
+}
+
+#endif  // defined(__SSE2__)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) unsigned int MaskPixelsAVX2(
+    DATA32* data, unsigned int n, DATA32 mask_color) {
+  const __m256i rgb = _mm256_set1_epi32(0x00FFFFFF);
+  const __m256i mask = _mm256_set1_epi32(mask_color);
+  unsigned int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i* p = reinterpret_cast<__m256i*>(data + i);
+    __m256i px = _mm256_loadu_si256(p);
+    __m256i matches = _mm256_cmpeq_epi32(_mm256_and_si256(px, rgb), mask);
+    _mm256_storeu_si256(
+        p, _mm256_andnot_si256(_mm256_andnot_si256(rgb, matches), px));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline __m256i PremultiplyUnpackedAVX2(
+    __m256i px) {
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, 0xFF), 0xFF);
+  __m256i t =
+      _mm256_add_epi16(_mm256_mullo_epi16(px, a), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2"))) unsigned int PremultiplyPixelsAVX2(
+    DATA32* data, unsigned int n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+  unsigned int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i* p = reinterpret_cast<__m256i*>(data + i);
+    __m256i px = _mm256_loadu_si256(p);
+    // unpack/pack work within 128 bit lanes, so the pixel order survives
+    __m256i lo = PremultiplyUnpackedAVX2(_mm256_unpacklo_epi8(px, zero));
+    __m256i hi = PremultiplyUnpackedAVX2(_mm256_unpackhi_epi8(px, zero));
+    __m256i colors = _mm256_andnot_si256(alpha, _mm256_packus_epi16(lo, hi));
+    _mm256_storeu_si256(p,
+                        _mm256_or_si256(colors, _mm256_and_si256(px, alpha)));
+  }
+  return i;
+}
+
+bool HasAVX2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+#endif  // defined(__x86_64__) || defined(__i386__)
+
+// Vectorized where possible, with the scalar loop picking up the leftovers.
+void MaskPixels(DATA32* data, unsigned int n, DATA32 mask_color) {
+  unsigned int done = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAVX2()) {
+    done = MaskPixelsAVX2(data, n, mask_color);
+  }
+#endif  // defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+  done += MaskPixelsSSE2(data + done, n - done, mask_color);
+#endif  // defined(__SSE2__)
+  MaskPixelsScalar(data + done, n - done, mask_color);
+}
+
+void PremultiplyPixels(DATA32* data, unsigned int n) {
+  unsigned int done = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  if (HasAVX2()) {
+    done = PremultiplyPixelsAVX2(data, n);
+  }
+#endif  // defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+  done += PremultiplyPixelsSSE2(data + done, n - done);
+#endif  // defined(__SSE2__)
+  PremultiplyPixelsScalar(data + done, n - done);
+}
+
+// Finds the color of the background of an icon without an alpha channel: we
+// check all 4 corner pixels and take the color which appears most often (we
+// only need to check three corners, the 4th is implicitly clear).
+DATA32 FindMaskColor(DATA32 const* data, int w, int h) {
+  DATA32 top_left = data[0], top_right = data[w - 1],
+         bottom_left = data[w * h - w], bottom_right = data[w * h - 1];
+  int max = (top_left == top_right) + (top_left == bottom_left) +
+            (top_left == bottom_right);
+  DATA32 mask = top_left;
+
+  if (max < (top_right == top_left) + (top_right == bottom_left) +
+                (top_right == bottom_right)) {
+    max = (top_right == top_left) + (top_right == bottom_left) +
+          (top_right == bottom_right);
+    mask = top_right;
+  }
+
+  if (max < (bottom_left == top_right) + (bottom_left == top_left) +
+                (bottom_left == bottom_right)) {
+    mask = bottom_left;
+  }
+
+  return mask & 0x00FFFFFF;
+}
+
 }  // namespace
 
 void AdjustASB(DATA32* data, unsigned int w, unsigned int h, int alpha,
@@ -233,40 +413,52 @@ void AdjustASB(DATA32* data, unsigned int w, unsigned int h, int alpha,
 }
 
 void CreateHeuristicMask(DATA32* data, int w, int h) {
-  // first we need to find the mask color, therefore we check all 4 edge pixel
-  // and take the color which
-  // appears most often (we only need to check three edges, the 4th is
-  // implicitly clear)
-  unsigned int top_left = data[0], top_right = data[w - 1],
-               bottomLeft = data[w * h - w], bottomRight = data[w * h - 1];
-  int max = (top_left == top_right) + (top_left == bottomLeft) +
-            (top_left == bottomRight);
-  int maskPos = 0;
-
-  if (max < (top_right == top_left) + (top_right == bottomLeft) +
-                (top_right == bottomRight)) {
-    max = (top_right == top_left) + (top_right == bottomLeft) +
-          (top_right == bottomRight);
-    maskPos = w - 1;
-  }
-
-  if (max < (bottomLeft == top_right) + (bottomLeft == top_left) +
-                (bottomLeft == bottomRight)) {
-    maskPos = w * h - w;
-  }
+  MaskPixels(data, w * h, FindMaskColor(data, w, h));
+}
 
-  // now mask out every pixel which has the same color as the edge pixels
-  unsigned char* udata = (unsigned char*)data;
-  unsigned char b = udata[4 * maskPos];
-  unsigned char g = udata[4 * maskPos + 1];
-  unsigned char r = udata[4 * maskPos + 1];
+void PremultiplyAlpha(DATA32* data, unsigned int w, unsigned int h) {
+  PremultiplyPixels(data, w * h);
+}
 
-  for (int i = 0; i < h * w; ++i) {
-    if (b - udata[0] == 0 && g - udata[1] == 0 && r - udata[2] == 0) {
-      udata[3] = 0;
+void UnpremultiplyAlpha(DATA32* data, unsigned int w, unsigned int h) {
+  for (unsigned int i = 0; i < w * h; ++i, ++data) {
+    unsigned int a = (*data >> 24);
+    if (a == 0xFF) {
+      continue;
+    }
+    if (a == 0) {
+      *data = 0;
+      continue;
     }
+    auto unpremultiply = [a](unsigned int x) {
+      return std::min((x * 0xFF + a / 2) / a, 0xFFU);
+    };
+    *data = (a << 24) | (unpremultiply((*data >> 16) & 0xFF) << 16) |
+            (unpremultiply((*data >> 8) & 0xFF) << 8) |
+            unpremultiply(*data & 0xFF);
+  }
+}
 
-    udata += 4;
+void MaskAdjustASBAndPremultiply(DATA32* data, int w, int h,
+                                 bool heuristic_mask, int alpha,
+                                 float saturation_adjustment,
+                                 float brightness_adjustment) {
+  bool adjust_asb = (alpha != 100 || saturation_adjustment != 0 ||
+                     brightness_adjustment != 0);
+  DATA32 mask_color = heuristic_mask ? FindMaskColor(data, w, h) : 0;
+
+  unsigned int size = w * h;
+  for (unsigned int i = 0; i < size; i += kBlockPixels) {
+    DATA32* block = data + i;
+    unsigned int n = std::min(kBlockPixels, size - i);
+    if (heuristic_mask) {
+      MaskPixels(block, n, mask_color);
+    }
+    if (adjust_asb) {
+      AdjustASB(block, n, 1, alpha, saturation_adjustment,
+                brightness_adjustment);
+    }
+    PremultiplyPixels(block, n);
   }
 }
 
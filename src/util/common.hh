@@ -127,6 +127,19 @@ bool SignalAction(int signal_number, void signal_handler(int), int flags = 0);
 void AdjustASB(DATA32* data, unsigned int w, unsigned int h, int alpha,
                float saturation_adjustment, float brightness_adjustment);
 void CreateHeuristicMask(DATA32* data, int w, int h);
+// converts straight ARGB (what Imlib2 uses) to the premultiplied ARGB XRender
+// expects
+void PremultiplyAlpha(DATA32* data, unsigned int w, unsigned int h);
+// converts premultiplied ARGB (what cairo image surfaces use) back to straight
+// ARGB
+void UnpremultiplyAlpha(DATA32* data, unsigned int w, unsigned int h);
+// CreateHeuristicMask() (if heuristic_mask is set), AdjustASB() (unless the
+// adjustments are neutral) and PremultiplyAlpha(), in a single pass over the
+// pixels.
+void MaskAdjustASBAndPremultiply(DATA32* data, int w, int h,
+                                 bool heuristic_mask, int alpha,
+                                 float saturation_adjustment,
+                                 float brightness_adjustment);
 
 void RenderImage(Server* server, Drawable drawable, Imlib_Image image, int x,
                  int y);
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -65,6 +66,85 @@ TEST_CASE("AdjustASB",
   REQUIRE(image_data[3] == 0x0a212427);
 }
 
+TEST_CASE("CreateHeuristicMask") {
+  // A 3x3 bitmap whose corners are mostly the same color.
+  DATA32 image_data[] = {
+      0xff102030, 0xff405060, 0xff102030,  // NOLINT
+      0xff708090, 0xff102030, 0xff708090,  // NOLINT
+      0xff102030, 0xffa0b0c0, 0xff405060,  // NOLINT
+  };
+  CreateHeuristicMask(image_data, 3, 3);
+
+  for (DATA32 pixel : image_data) {
+    if ((pixel & 0x00ffffff) == 0x102030) {
+      REQUIRE(pixel == 0x00102030);
+    } else {
+      REQUIRE((pixel >> 24) == 0xff);
+    }
+  }
+}
+
+TEST_CASE("PremultiplyAlpha") {
+  DATA32 image_data[] = {0xff102030, 0x80ff8000, 0x00ffffff, 0x01ffffff};
+  PremultiplyAlpha(image_data, 2, 2);
+
+  REQUIRE(image_data[0] == 0xff102030);
+  REQUIRE(image_data[1] == 0x80804000);
+  REQUIRE(image_data[2] == 0x00000000);
+  REQUIRE(image_data[3] == 0x01010101);
+}
+
+TEST_CASE("UnpremultiplyAlpha") {
+  DATA32 image_data[] = {0xff102030, 0x80804000, 0x00000000, 0x40202020};
+  UnpremultiplyAlpha(image_data, 2, 2);
+
+  REQUIRE(image_data[0] == 0xff102030);
+  REQUIRE(image_data[1] == 0x80ff8000);
+  REQUIRE(image_data[2] == 0x00000000);
+  REQUIRE(image_data[3] == 0x40808080);
+}
+
+TEST_CASE("MaskAdjustASBAndPremultiply",
+          "The fused pass matches the individual steps") {
+  // Odd dimensions, so that the vectorized loops leave some pixels over.
+  constexpr int kWidth = 37;
+  constexpr int kHeight = 29;
+
+  std::srand(1234);
+  std::vector<DATA32> image_data(kWidth * kHeight);
+  for (auto& pixel : image_data) {
+    // Few distinct colors, so that plenty of pixels match the mask.
+    pixel = (static_cast<DATA32>(std::rand() & 0xff) << 24) |
+            ((std::rand() % 4) * 0x00404040);
+  }
+
+  for (bool heuristic_mask : {false, true}) {
+    std::vector<DATA32> expected{image_data};
+    if (heuristic_mask) {
+      CreateHeuristicMask(expected.data(), kWidth, kHeight);
+    }
+    AdjustASB(expected.data(), kWidth, kHeight, 80, 0.1, -0.2);
+    PremultiplyAlpha(expected.data(), kWidth, kHeight);
+
+    std::vector<DATA32> actual{image_data};
+    MaskAdjustASBAndPremultiply(actual.data(), kWidth, kHeight, heuristic_mask,
+                                80, 0.1, -0.2);
+    REQUIRE(actual == expected);
+
+    // Without any ASB adjustment, only the mask and premultiplication apply.
+    expected = image_data;
+    if (heuristic_mask) {
+      CreateHeuristicMask(expected.data(), kWidth, kHeight);
+    }
+    PremultiplyAlpha(expected.data(), kWidth, kHeight);
+
+    actual = image_data;
+    MaskAdjustASBAndPremultiply(actual.data(), kWidth, kHeight, heuristic_mask,
+                                100, 0, 0);
+    REQUIRE(actual == expected);
+  }
+}
+
 TEST_CASE("ScopedCallback") {
   bool was_invoked = false;
   {
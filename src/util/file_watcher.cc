@@ -0,0 +1,124 @@
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "util/file_watcher.hh"
+#include "util/log.hh"
+
+namespace {
+
+constexpr uint32_t kWatchMask = (IN_CREATE | IN_DELETE | IN_CLOSE_WRITE |
+                                 IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+
+}  // namespace
+
+namespace util {
+
+FileWatcher::FileWatcher() : fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+  if (fd_ == -1) {
+    util::log::Error() << "Failed to initialize inotify: "
+                       << std::strerror(errno) << '\n';
+  }
+}
+
+FileWatcher::~FileWatcher() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+bool FileWatcher::IsAlive() const { return (fd_ != -1); }
+
+int FileWatcher::fd() const { return fd_; }
+
+bool FileWatcher::WatchDirectory(std::string const& path, Callback callback) {
+  if (fd_ == -1) {
+    return false;
+  }
+
+  int wd = inotify_add_watch(fd_, path.c_str(), kWatchMask);
+  if (wd == -1) {
+    // Most likely a directory that doesn't exist (yet).
+    util::log::Debug() << "Not watching \"" << path
+                       << "\": " << std::strerror(errno) << '\n';
+    return false;
+  }
+
+  Watch& watch = watches_[wd];
+  watch.path = path;
+  watch.callbacks.push_back(std::move(callback));
+  return true;
+}
+
+void FileWatcher::UnwatchAll() {
+  for (auto const& pair : watches_) {
+    inotify_rm_watch(fd_, pair.first);
+  }
+  watches_.clear();
+}
+
+void FileWatcher::ProcessEvents() {
+  if (fd_ == -1) {
+    return;
+  }
+
+  // Callbacks may add or remove watches, so only run them once all the events
+  // have been read.
+  struct Change {
+    Callback callback;
+    std::string directory;
+    std::string name;
+  };
+  std::vector<Change> changes;
+
+  alignas(struct inotify_event) char buffer[4096];
+  while (true) {
+    ssize_t length = read(fd_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      if (length == -1 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    for (char* p = buffer; p < buffer + length;) {
+      auto event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        for (auto const& pair : watches_) {
+          for (auto const& callback : pair.second.callbacks) {
+            changes.push_back(Change{callback, pair.second.path, ""});
+          }
+        }
+        continue;
+      }
+
+      auto it = watches_.find(event->wd);
+      if (it == watches_.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        // The directory was removed (or unmounted).
+        watches_.erase(it);
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+      for (auto const& callback : it->second.callbacks) {
+        changes.push_back(Change{callback, it->second.path, event->name});
+      }
+    }
+  }
+
+  for (auto const& change : changes) {
+    change.callback(change.directory, change.name);
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,51 @@
+#ifndef TINT3_UTIL_FILE_WATCHER_HH
+#define TINT3_UTIL_FILE_WATCHER_HH
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+// Watches directories for changes with inotify. The events are only read and
+// dispatched by ProcessEvents(), which is meant to be called by the event loop
+// whenever fd() becomes readable.
+class FileWatcher {
+ public:
+  // Called with the watched directory and the name of the entry that was
+  // created, modified, removed or moved in it. The name is empty if events
+  // were lost, in which case anything in the directory may have changed.
+  using Callback =
+      std::function<void(std::string const& directory, std::string const& name)>;
+
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(FileWatcher const&) = delete;
+  FileWatcher& operator=(FileWatcher const&) = delete;
+
+  bool IsAlive() const;
+  int fd() const;
+
+  // Starts watching the given directory. A directory can be watched several
+  // times, with different callbacks.
+  bool WatchDirectory(std::string const& path, Callback callback);
+  void UnwatchAll();
+
+  // Reads all the pending events, and runs the matching callbacks.
+  void ProcessEvents();
+
+ private:
+  struct Watch {
+    std::string path;
+    std::vector<Callback> callbacks;
+  };
+
+  int fd_;
+  std::unordered_map<int, Watch> watches_;
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_FILE_WATCHER_HH
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <poll.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/file_watcher.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+namespace {
+
+bool IsReadable(int fd, int timeout_ms) {
+  struct pollfd poll_fd = {fd, POLLIN, 0};
+  return poll(&poll_fd, 1, timeout_ms) == 1;
+}
+
+}  // namespace
+
+TEST_CASE("FileWatcher") {
+  TemporaryDirectory temp_dir;
+  std::string watched{temp_dir.path() / "watched"};
+  std::string unwatched{temp_dir.path() / "unwatched"};
+  REQUIRE(util::fs::CreateDirectory(watched));
+  REQUIRE(util::fs::CreateDirectory(unwatched));
+
+  util::FileWatcher watcher;
+  REQUIRE(watcher.IsAlive());
+
+  std::vector<std::pair<std::string, std::string>> changes;
+  REQUIRE(watcher.WatchDirectory(
+      watched, [&](std::string const& directory, std::string const& name) {
+        changes.emplace_back(directory, name);
+      }));
+  REQUIRE_FALSE(watcher.WatchDirectory(
+      temp_dir.path() / "missing",
+      [](std::string const&, std::string const&) {}));
+
+  SECTION("changes in watched directories are reported") {
+    REQUIRE(util::fs::WriteFile(util::fs::Path{watched} / "file", "contents"));
+    REQUIRE(IsReadable(watcher.fd(), 1000));
+    watcher.ProcessEvents();
+    REQUIRE_FALSE(changes.empty());
+    for (auto const& change : changes) {
+      REQUIRE(change.first == watched);
+      REQUIRE(change.second == "file");
+    }
+
+    changes.clear();
+    REQUIRE(util::fs::Unlink(util::fs::Path{watched} / "file"));
+    REQUIRE(IsReadable(watcher.fd(), 1000));
+    watcher.ProcessEvents();
+    REQUIRE(changes.size() == 1);
+    REQUIRE(changes[0].second == "file");
+  }
+
+  SECTION("other directories are not") {
+    REQUIRE(util::fs::WriteFile(util::fs::Path{unwatched} / "file", ""));
+    REQUIRE_FALSE(IsReadable(watcher.fd(), 100));
+    watcher.ProcessEvents();
+    REQUIRE(changes.empty());
+  }
+
+  SECTION("unwatch") {
+    watcher.UnwatchAll();
+    REQUIRE(util::fs::WriteFile(util::fs::Path{watched} / "file", ""));
+    watcher.ProcessEvents();
+    REQUIRE(changes.empty());
+  }
+}
@@ -1,5 +1,7 @@
 #include <libgen.h>
+#include <fcntl.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -8,6 +10,7 @@
 #include <sstream>
 #include <utility>
 
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/strip.h"
@@ -109,6 +112,51 @@ absl::string_view StripTrailingSlash(absl::string_view path) {
 
 }  // namespace
 
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(std::string const& path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return false;
+  }
+
+  // mmap() refuses empty mappings, but an empty file is still a valid file.
+  if (info.st_size != 0) {
+    void* data =
+        mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, /* offset= */ 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    data_ = data;
+    size_ = info.st_size;
+  }
+
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+  }
+  size_ = 0;
+}
+
+absl::string_view MappedFile::contents() const {
+  return absl::string_view{static_cast<char const*>(data_), size_};
+}
+
 Path::Path(const char* path) : Path(absl::string_view(path)) {}
 Path::Path(std::string const& path) : Path(absl::string_view(path)) {}
 Path::Path(absl::string_view path) : path_{StripTrailingSlash(path)} {}
@@ -188,7 +236,7 @@ bool CopyFile(std::string const& from_path, std::string const& to_path) {
 }
 
 bool CreateDirectory(std::string const& path, mode_t mode) {
-  Path partial_path{"/"};
+  Path partial_path{absl::StartsWith(path, "/") ? "/" : ""};
 
   for (auto const& component : absl::StrSplit(path, '/')) {
     if (component.empty()) {
@@ -312,6 +360,10 @@ bool ReadFileByLine(std::string const& path,
   return true;
 }
 
+bool Stat(std::string const& path, struct stat* info) {
+  return system_interface->stat(path, info);
+}
+
 bool SymbolicLink(std::string const& target, std::string const& linkpath) {
   return system_interface->symlink(target, linkpath);
 }
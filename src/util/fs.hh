@@ -55,6 +55,28 @@ class DirectoryContents {
   DIR* dir_;
 };
 
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  // Maps the file at the given path, replacing the current mapping (if any).
+  // Returns false if the file can't be opened or mapped.
+  bool Open(std::string const& path);
+  void Close();
+
+  // The mapped bytes, valid until the file is closed or reopened.
+  absl::string_view contents() const;
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 class Path {
  public:
   friend std::ostream& operator<<(std::ostream& os, Path const& path);
@@ -105,6 +127,7 @@ bool ReadFile(std::string const& path,
               std::function<bool(std::string const&)> const& fn);
 bool ReadFileByLine(std::string const& path,
                     std::function<bool(std::string const&)> const& fn);
+bool Stat(std::string const& path, struct stat* info);
 bool SymbolicLink(std::string const& target, std::string const& linkpath);
 bool Unlink(std::string const& path);
 
@@ -254,3 +254,20 @@ TEST_CASE("DirectoryContents") {
 
   REQUIRE(actual_set == expected_set);
 }
+
+TEST_CASE("MappedFile", "Maps the entire contents of a file into memory") {
+  util::fs::MappedFile file;
+  REQUIRE_FALSE(file.Open("/none"));
+  REQUIRE(file.contents().empty());
+
+  // Directories can't be mapped.
+  REQUIRE_FALSE(file.Open("src/util/testdata"));
+
+  std::string contents;
+  REQUIRE(util::fs::ReadFile("src/util/testdata/fs_test.txt", &contents));
+  REQUIRE(file.Open("src/util/testdata/fs_test.txt"));
+  REQUIRE(file.contents() == contents);
+
+  file.Close();
+  REQUIRE(file.contents().empty());
+}
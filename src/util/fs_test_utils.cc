@@ -1,3 +1,9 @@
+#include <ftw.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
 #include "util/fs_test_utils.hh"
 
 bool FakeFileSystemInterface::stat(std::string const& path, struct stat* buf) {
@@ -30,3 +36,31 @@ bool FakeFileSystemInterface::unlink(std::string const& path) {
   response->second.pop_front();
   return result;
 }
+
+namespace {
+
+constexpr char kTemporaryDirectoryTemplate[] = "/tmp/tint3_test.XXXXXX";
+
+int RemoveEntry(const char* path, const struct stat* /* info */,
+                int /* type */, struct FTW* /* ftw */) {
+  return std::remove(path);
+}
+
+}  // namespace
+
+TemporaryDirectory::TemporaryDirectory() {
+  std::vector<char> path{std::begin(kTemporaryDirectoryTemplate),
+                         std::end(kTemporaryDirectoryTemplate)};
+  if (mkdtemp(path.data()) != nullptr) {
+    path_.assign(path.data());
+  }
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  if (!path_.empty()) {
+    // Depth-first, so that directories are empty by the time they're removed.
+    nftw(path_.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+}
+
+util::fs::Path TemporaryDirectory::path() const { return path_; }
@@ -38,4 +38,20 @@ struct FakeFileSystemInterface : public util::fs::SystemInterface {
   std::unordered_map<std::string, std::list<bool>> unlink_responses;
 };
 
+// Creates a uniquely named, empty directory under /tmp, which is removed
+// along with all of its contents when going out of scope.
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory();
+  ~TemporaryDirectory();
+
+  TemporaryDirectory(TemporaryDirectory const&) = delete;
+  TemporaryDirectory& operator=(TemporaryDirectory const&) = delete;
+
+  util::fs::Path path() const;
+
+ private:
+  std::string path_;
+};
+
 #endif  // TINT3_UTIL_FS_TEST_UTILS_HH
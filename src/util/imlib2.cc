@@ -33,7 +33,7 @@ Image::Image(Imlib_Image image) : image_(image) {}
 
 Image::Image(Image const& other) : image_(CloneImlib2Image(other.image_)) {}
 
-Image::Image(Image&& other) : image_(std::move(other.image_)) {}
+Image::Image(Image&& other) : image_(other.image_) { other.image_ = nullptr; }
 
 Image::~Image() { Free(); }
 
@@ -75,5 +75,17 @@ Image Image::CloneExisting(Imlib_Image other_image) {
   return Image{CloneImlib2Image(other_image)};
 }
 
+Image Image::FromPixels(int width, int height, DATA32 const* pixels) {
+  // Imlib wants mutable memory, but it only reads from it here.
+  DATA32* data = const_cast<DATA32*>(pixels);
+  Image image{imlib_create_image_using_copied_data(width, height, data)};
+  if (image) {
+    ScopedCurrentImageRestorer restorer;
+    imlib_context_set_image(image);
+    imlib_image_set_has_alpha(1);
+  }
+  return image;
+}
+
 }  // namespace imlib2
 }  // namespace util
@@ -22,6 +22,9 @@ class Image {
   void Free();
 
   static Image CloneExisting(Imlib_Image other_image);
+  // Creates an image (with an alpha channel) from a copy of the given ARGB32
+  // pixels, e.g. from the raster cache.
+  static Image FromPixels(int width, int height, DATA32 const* pixels);
 
  private:
   Imlib_Image image_;
@@ -0,0 +1,137 @@
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "util/line_reader.hh"
+#include "util/log.hh"
+
+namespace {
+
+// How many times the buffer may be filled in one call, so that a file
+// descriptor which never runs dry (e.g. "yes") doesn't starve the others.
+constexpr size_t kMaxFillsPerRead = 4;
+
+}  // namespace
+
+namespace util {
+
+constexpr size_t LineReader::kDefaultCapacity;
+
+LineReader::LineReader(size_t capacity)
+    : capacity_(capacity),
+      buffer_(new char[capacity]),
+      line_(new char[capacity]),
+      begin_(0),
+      size_(0),
+      scanned_(0),
+      truncating_(false) {}
+
+LineReader::Result LineReader::Read(int fd, Callback const& callback) {
+  size_t total_length = 0;
+  while (total_length < kMaxFillsPerRead * capacity_) {
+    if (size_ == capacity_) {
+      // Still no end of line, and no room left for one.
+      callback(Line(size_));
+      Consume(size_);
+      truncating_ = true;
+    }
+
+    // The free part of the buffer wraps around its end unless the pending
+    // part does.
+    size_t end = (begin_ + size_) % capacity_;
+    struct iovec iov[2];
+    int iov_count = 1;
+    if (end >= begin_) {
+      iov[0] = {buffer_.get() + end, capacity_ - end};
+      iov[1] = {buffer_.get(), begin_};
+      iov_count = (begin_ > 0) ? 2 : 1;
+    } else {
+      iov[0] = {buffer_.get() + end, begin_ - end};
+    }
+
+    ssize_t length = readv(fd, iov, iov_count);
+    if (length == -1 && errno == EINTR) {
+      continue;
+    }
+    if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return Result::kAgain;
+    }
+    if (length == -1) {
+      util::log::Error() << "Failed reading from file descriptor " << fd
+                         << ": " << std::strerror(errno) << '\n';
+      return Result::kError;
+    }
+    if (length == 0) {
+      if (size_ > 0 && !truncating_) {
+        callback(Line(size_));
+      }
+      Clear();
+      return Result::kEndOfFile;
+    }
+
+    size_ += length;
+    total_length += length;
+    size_t line_end;
+    while ((line_end = FindLineEnd()) != size_) {
+      if (!truncating_) {
+        callback(Line(line_end));
+      }
+      truncating_ = false;
+      Consume(line_end + 1);
+    }
+    if (truncating_) {
+      Consume(size_);
+    }
+  }
+  // There may be more to read: the file descriptor will be polled again.
+  return Result::kAgain;
+}
+
+void LineReader::Clear() {
+  begin_ = 0;
+  size_ = 0;
+  scanned_ = 0;
+  truncating_ = false;
+}
+
+size_t LineReader::FindLineEnd() {
+  // Look in (at most) two contiguous pieces, past what was already scanned.
+  size_t offset = scanned_;
+  while (offset < size_) {
+    size_t position = (begin_ + offset) % capacity_;
+    size_t length = std::min(size_ - offset, capacity_ - position);
+    const void* found = std::memchr(buffer_.get() + position, '\n', length);
+    if (found != nullptr) {
+      return offset + (static_cast<const char*>(found) -
+                       (buffer_.get() + position));
+    }
+    offset += length;
+  }
+  scanned_ = size_;
+  return size_;
+}
+
+absl::string_view LineReader::Line(size_t length) {
+  if (begin_ + length <= capacity_) {
+    return absl::string_view{buffer_.get() + begin_, length};
+  }
+  size_t head = (capacity_ - begin_);
+  std::memcpy(line_.get(), buffer_.get() + begin_, head);
+  std::memcpy(line_.get() + head, buffer_.get(), length - head);
+  return absl::string_view{line_.get(), length};
+}
+
+void LineReader::Consume(size_t length) {
+  begin_ = (begin_ + length) % capacity_;
+  size_ -= length;
+  scanned_ = 0;
+  if (size_ == 0) {
+    // Keeps lines contiguous for as long as possible.
+    begin_ = 0;
+  }
+}
+
+}  // namespace util
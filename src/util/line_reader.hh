@@ -0,0 +1,70 @@
+#ifndef TINT3_UTIL_LINE_READER_HH
+#define TINT3_UTIL_LINE_READER_HH
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+
+namespace util {
+
+// Splits what is read from a file descriptor into lines, through a ring
+// buffer of a fixed size: nothing is allocated while reading, however much
+// there is to read.
+//
+// Lines longer than the buffer are truncated to its size. Line terminators
+// aren't part of the lines.
+class LineReader {
+ public:
+  enum class Result {
+    kAgain,
+    kEndOfFile,
+    kError,
+  };
+
+  // Lines handed to the callback are only valid until it returns.
+  using Callback = std::function<void(absl::string_view line)>;
+
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit LineReader(size_t capacity = kDefaultCapacity);
+  LineReader(LineReader const&) = delete;
+  LineReader(LineReader&&) = default;
+  LineReader& operator=(LineReader&&) = default;
+
+  // Reads until the file descriptor would block (kAgain), or until its end
+  // (kEndOfFile), calling back with every complete line. The incomplete last
+  // line, if any, is reported at the end of file too.
+  //
+  // At most a few buffers' worth is read per call, so that a writer which
+  // never stops can't keep the caller busy: kAgain is returned then too, and
+  // the rest is read once the file descriptor is polled again.
+  Result Read(int fd, Callback const& callback);
+
+  // Forgets about the incomplete line, before reading from another file
+  // descriptor.
+  void Clear();
+
+ private:
+  size_t capacity_;
+  std::unique_ptr<char[]> buffer_;
+  // Lines wrapping around the end of the buffer are copied here, to hand
+  // them out in one piece.
+  std::unique_ptr<char[]> line_;
+  // Position and size of what's pending in the buffer.
+  size_t begin_;
+  size_t size_;
+  // How much of what's pending was already looked at for line terminators.
+  size_t scanned_;
+  // Whether the rest of a line too long for the buffer is being dropped.
+  bool truncating_;
+
+  size_t FindLineEnd();
+  absl::string_view Line(size_t length);
+  void Consume(size_t length);
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_LINE_READER_HH
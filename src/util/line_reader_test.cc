@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+#include "util/line_reader.hh"
+
+namespace {
+
+void Write(int fd, std::string const& data) {
+  REQUIRE(write(fd, data.data(), data.size()) ==
+          static_cast<ssize_t>(data.size()));
+}
+
+}  // namespace
+
+TEST_CASE("LineReader") {
+  // The write end is closed by some sections, to test the end of file.
+  int fds[2];
+  REQUIRE(pipe2(fds, O_NONBLOCK) == 0);
+  int read_fd = fds[0];
+  int write_fd = fds[1];
+
+  std::vector<std::string> lines;
+  auto callback = [&lines](absl::string_view line) {
+    lines.emplace_back(line.data(), line.size());
+  };
+
+  SECTION("complete lines are reported") {
+    util::LineReader reader;
+    Write(write_fd, "one\ntwo\n\nthree\n");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE(lines == (std::vector<std::string>{"one", "two", "", "three"}));
+  }
+
+  SECTION("partial reads") {
+    util::LineReader reader;
+    Write(write_fd, "par");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE(lines.empty());
+
+    Write(write_fd, "tial\nnext");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE(lines == (std::vector<std::string>{"partial"}));
+
+    // The incomplete line is reported at the end of file.
+    close(write_fd);
+    write_fd = -1;
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kEndOfFile);
+    REQUIRE(lines == (std::vector<std::string>{"partial", "next"}));
+  }
+
+  SECTION("lines wrap around the end of the buffer") {
+    util::LineReader reader{8};
+    for (int i = 0; i < 10; ++i) {
+      Write(write_fd, "abcde\n");
+      REQUIRE(reader.Read(read_fd, callback) ==
+              util::LineReader::Result::kAgain);
+    }
+    Write(write_fd, "abc");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    Write(write_fd, "de\n");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE(lines == std::vector<std::string>(11, "abcde"));
+  }
+
+  SECTION("long lines are truncated") {
+    util::LineReader reader{8};
+    Write(write_fd, "0123456789abcdef\nshort\n");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE(lines == (std::vector<std::string>{"01234567", "short"}));
+
+    // Even when the line comes in pieces.
+    lines.clear();
+    Write(write_fd, "0123");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    Write(write_fd, "456789");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    Write(write_fd, "abcdef");
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    Write(write_fd, "\nend");
+    close(write_fd);
+    write_fd = -1;
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kEndOfFile);
+    REQUIRE(lines == (std::vector<std::string>{"01234567", "end"}));
+  }
+
+  SECTION("reading stops after a few buffers") {
+    util::LineReader reader{8};
+    for (int i = 0; i < 100; ++i) {
+      Write(write_fd, "abc\n");
+    }
+    REQUIRE(reader.Read(read_fd, callback) ==
+            util::LineReader::Result::kAgain);
+    REQUIRE_FALSE(lines.empty());
+    REQUIRE(lines.size() < 100);
+
+    while (lines.size() < 100) {
+      REQUIRE(reader.Read(read_fd, callback) ==
+              util::LineReader::Result::kAgain);
+    }
+    REQUIRE(lines == std::vector<std::string>(100, "abc"));
+  }
+
+  SECTION("errors") {
+    util::LineReader reader;
+    REQUIRE(reader.Read(-1, callback) == util::LineReader::Result::kError);
+  }
+
+  close(read_fd);
+  if (write_fd != -1) {
+    close(write_fd);
+  }
+}
@@ -43,7 +43,9 @@ Pipe::Pipe(Pipe&& other) {
 Pipe::~Pipe() {
   if (alive_) {
     close(pipe_fd_[0]);
-    close(pipe_fd_[1]);
+    if (pipe_fd_[1] != -1) {
+      close(pipe_fd_[1]);
+    }
   }
 }
 
@@ -53,6 +55,13 @@ int Pipe::ReadEnd() const { return pipe_fd_[0]; }
 
 int Pipe::WriteEnd() const { return pipe_fd_[1]; }
 
+void Pipe::CloseWriteEnd() {
+  if (alive_ && pipe_fd_[1] != -1) {
+    close(pipe_fd_[1]);
+    pipe_fd_[1] = -1;
+  }
+}
+
 bool Pipe::SetFlag(int fd, int flag) const {
   int flags = fcntl(fd, F_GETFL);
   if (flags == -1) {
@@ -25,6 +25,9 @@ class Pipe {
   int ReadEnd() const;
   int WriteEnd() const;
 
+  // Closes the write end, e.g. once handed over to a child process.
+  void CloseWriteEnd();
+
  private:
   friend class test::MockSelfPipe;
 
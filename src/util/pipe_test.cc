@@ -35,6 +35,19 @@ TEST_CASE("move constructor") {
   REQUIRE(p1.WriteEnd() == -1);
 }
 
+TEST_CASE("CloseWriteEnd") {
+  util::Pipe p;
+  REQUIRE(p.IsAlive());
+  p.CloseWriteEnd();
+  REQUIRE(p.WriteEnd() == -1);
+
+  // Nothing is left to write to the pipe: reading from it ends right away.
+  char byte;
+  REQUIRE(read(p.ReadEnd(), &byte, 1) == 0);
+
+  p.CloseWriteEnd();
+}
+
 TEST_CASE("non blocking") {
   auto assert_nonblocking = [](int fd) {
     int flags = fcntl(fd, F_GETFL);
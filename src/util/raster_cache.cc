@@ -0,0 +1,197 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+
+#include "util/fs.hh"
+#include "util/log.hh"
+#include "util/raster_cache.hh"
+#include "util/xdg.hh"
+
+namespace {
+
+// Entry layout, all integers in host byte order:
+//
+//   EntryHeader
+//   char[key_length], zero padded to a multiple of 8 bytes
+//   uint32_t[width * height]
+constexpr char kEntryMagic[8] = {'t', 'i', 'n', 't', '3', 'R', 'S', 'T'};
+constexpr uint32_t kEntryVersion = 1;
+
+struct EntryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_length;
+  uint32_t width;
+  uint32_t height;
+};
+
+static_assert(sizeof(EntryHeader) % 8 == 0, "unaligned entry header");
+
+// Entries for icons that changed or were resized are never used again.
+const absl::Duration kIconRasterCacheMaxUnused = absl::Hours(30 * 24);
+
+// Tells apart the temporary files of concurrent Store() calls, as launcher
+// icons are stored from worker threads.
+std::atomic<unsigned long> temporary_count{0};
+
+size_t PaddedKeyLength(size_t key_length) { return (key_length + 7) & ~7; }
+
+// FNV-1a: unlike std::hash and absl::Hash, it is stable across runs, which is
+// what file names derived from it need.
+uint64_t HashKey(absl::string_view key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+namespace util {
+
+unsigned int RasterCache::Raster::width() const { return width_; }
+
+unsigned int RasterCache::Raster::height() const { return height_; }
+
+uint32_t const* RasterCache::Raster::pixels() const { return pixels_; }
+
+RasterCache::RasterCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+bool RasterCache::MakeKey(std::string const& source_path,
+                          absl::string_view variant, std::string* key) {
+  struct stat info;
+  if (!util::fs::Stat(source_path, &info)) {
+    return false;
+  }
+  key->assign(absl::StrFormat("%s\n%d.%09d\n%d\n%s", source_path,
+                              info.st_mtim.tv_sec, info.st_mtim.tv_nsec,
+                              info.st_size, variant));
+  return true;
+}
+
+bool RasterCache::Load(std::string const& key, Raster* raster) const {
+  std::string path{EntryPath(key)};
+  if (!raster->file_.Open(path)) {
+    return false;
+  }
+
+  absl::string_view data = raster->file_.contents();
+  if (data.size() < sizeof(EntryHeader)) {
+    return false;
+  }
+
+  auto header = reinterpret_cast<EntryHeader const*>(data.data());
+  size_t pixels_offset = sizeof(EntryHeader) + PaddedKeyLength(key.length());
+  if (std::memcmp(header->magic, kEntryMagic, sizeof(kEntryMagic)) != 0 ||
+      header->version != kEntryVersion || header->key_length != key.length() ||
+      data.size() != pixels_offset + uint64_t{header->width} * header->height *
+                                         sizeof(uint32_t) ||
+      data.substr(sizeof(EntryHeader), key.length()) != key) {
+    // Either corrupt, or a hash collision: either way, this isn't our raster.
+    raster->file_.Close();
+    return false;
+  }
+
+  raster->width_ = header->width;
+  raster->height_ = header->height;
+  raster->pixels_ =
+      reinterpret_cast<uint32_t const*>(data.data() + pixels_offset);
+
+  // The modification time tells when the entry was last used, for Prune().
+  // Access times aren't reliable, as file systems are often mounted with
+  // noatime or relatime.
+  utimensat(AT_FDCWD, path.c_str(), nullptr, /* flags= */ 0);
+  return true;
+}
+
+bool RasterCache::Store(std::string const& key, unsigned int width,
+                        unsigned int height, uint32_t const* pixels) const {
+  if (!util::fs::CreateDirectory(directory_)) {
+    util::log::Error() << "Couldn't create the raster cache directory \""
+                       << directory_ << "\"\n";
+    return false;
+  }
+
+  EntryHeader header;
+  std::memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+  header.version = kEntryVersion;
+  header.key_length = key.length();
+  header.width = width;
+  header.height = height;
+
+  std::string data;
+  data.reserve(sizeof(header) + PaddedKeyLength(key.length()) +
+               width * height * sizeof(uint32_t));
+  data.append(reinterpret_cast<char const*>(&header), sizeof(header));
+  data.append(key);
+  data.resize(sizeof(header) + PaddedKeyLength(key.length()), '\0');
+  data.append(reinterpret_cast<char const*>(pixels),
+              width * height * sizeof(uint32_t));
+
+  // Entries may be mapped by other tint3 instances, so never write them in
+  // place.
+  std::string path{EntryPath(key)};
+  std::string temporary_path{
+      absl::StrCat(path, ".", getpid(), ".", temporary_count++)};
+  if (!util::fs::WriteFile(temporary_path, data) ||
+      std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    util::log::Error() << "Couldn't write the raster cache entry \"" << path
+                       << "\"\n";
+    util::fs::Unlink(temporary_path);
+    return false;
+  }
+  return true;
+}
+
+void RasterCache::Prune(absl::Duration max_unused) const {
+  absl::Time oldest = absl::Now() - max_unused;
+  unsigned int pruned = 0;
+  for (auto const& name : util::fs::DirectoryContents(directory_)) {
+    // Entries are "<hash>.raster", and temporary files
+    // "<hash>.raster.<pid>.<n>".
+    if (!absl::StrContains(name, ".raster")) {
+      continue;
+    }
+    std::string path{util::fs::Path(directory_) / name};
+    struct stat info;
+    if (util::fs::Stat(path, &info) &&
+        absl::TimeFromTimespec(info.st_mtim) < oldest &&
+        util::fs::Unlink(path)) {
+      ++pruned;
+    }
+  }
+  if (pruned > 0) {
+    util::log::Debug() << "Pruned " << pruned
+                       << " unused entries from the raster cache \""
+                       << directory_ << "\"\n";
+  }
+}
+
+RasterCache& IconRasterCache() {
+  static RasterCache cache = [] {
+    RasterCache cache{util::xdg::basedir::CacheHome() / "tint3" / "icons"};
+    cache.Prune(kIconRasterCacheMaxUnused);
+    return cache;
+  }();
+  return cache;
+}
+
+std::string RasterCache::EntryPath(std::string const& key) const {
+  return util::fs::Path(directory_) /
+         absl::StrFormat("%016x.raster", HashKey(key));
+}
+
+}  // namespace util
@@ -0,0 +1,74 @@
+#ifndef TINT3_UTIL_RASTER_CACHE_HH
+#define TINT3_UTIL_RASTER_CACHE_HH
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+#include "util/fs.hh"
+
+namespace util {
+
+// On-disk cache of decoded (and possibly scaled and adjusted) images.
+//
+// Entries are content addressed: they're identified by a key describing the
+// source file (path, modification time and size) and how the raster was
+// derived from it, so that editing or replacing the source simply makes the
+// old entry unreachable. Pixels are stored uncompressed as host-order ARGB32
+// words, and read back through a memory mapping.
+//
+// Unreachable entries are never looked up again, so entries that haven't
+// been used for a while are pruned. Loading an entry counts as using it.
+class RasterCache {
+ public:
+  // Pixels of a cached raster, valid as long as the object is alive.
+  class Raster {
+   public:
+    friend class RasterCache;
+
+    unsigned int width() const;
+    unsigned int height() const;
+    uint32_t const* pixels() const;
+
+   private:
+    util::fs::MappedFile file_;
+    unsigned int width_ = 0;
+    unsigned int height_ = 0;
+    uint32_t const* pixels_ = nullptr;
+  };
+
+  explicit RasterCache(std::string directory);
+
+  // Builds the key identifying the raster derived from the given source file
+  // as described by variant (e.g. target size and color adjustments).
+  // Returns false if the source file can't be stat()'ed.
+  static bool MakeKey(std::string const& source_path, absl::string_view variant,
+                      std::string* key);
+
+  // Maps the raster stored for the given key, if any, and marks it as used.
+  bool Load(std::string const& key, Raster* raster) const;
+
+  // Stores the given raster for the given key, replacing any previous one.
+  bool Store(std::string const& key, unsigned int width, unsigned int height,
+             uint32_t const* pixels) const;
+
+  // Removes the entries (and leftover temporary files) that were neither
+  // stored nor loaded within the given duration.
+  void Prune(absl::Duration max_unused) const;
+
+ private:
+  std::string EntryPath(std::string const& key) const;
+
+  std::string directory_;
+};
+
+// The cache of launcher and execp icons, in $XDG_CACHE_HOME/tint3/icons.
+// Entries are told apart by their source file, and the ones unused for a
+// month are pruned when it's first used.
+RasterCache& IconRasterCache();
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_RASTER_CACHE_HH
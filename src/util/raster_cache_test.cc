@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+#include "util/raster_cache.hh"
+
+TEST_CASE("RasterCache") {
+  TemporaryDirectory temp_dir;
+  util::RasterCache cache{temp_dir.path() / "cache"};
+  std::string source_path{temp_dir.path() / "icon.png"};
+  REQUIRE(util::fs::WriteFile(source_path, "not really a png"));
+
+  std::string key;
+  REQUIRE_FALSE(util::RasterCache::MakeKey(temp_dir.path() / "missing.png",
+                                           "16x16", &key));
+  REQUIRE(util::RasterCache::MakeKey(source_path, "16x16", &key));
+
+  util::RasterCache::Raster raster;
+  REQUIRE_FALSE(cache.Load(key, &raster));
+
+  std::vector<uint32_t> pixels{0xff000000, 0x80ff0000, 0x0000ff00, 0xffffffff,
+                               0x12345678, 0x9abcdef0};
+  REQUIRE(cache.Store(key, 3, 2, pixels.data()));
+  REQUIRE(cache.Load(key, &raster));
+  REQUIRE(raster.width() == 3);
+  REQUIRE(raster.height() == 2);
+  REQUIRE(std::vector<uint32_t>(raster.pixels(), raster.pixels() + 6) ==
+          pixels);
+
+  SECTION("variants are cached separately") {
+    std::string other_key;
+    REQUIRE(util::RasterCache::MakeKey(source_path, "32x32", &other_key));
+    REQUIRE(other_key != key);
+    REQUIRE_FALSE(cache.Load(other_key, &raster));
+  }
+
+  SECTION("modifying the source invalidates the entry") {
+    struct stat info;
+    REQUIRE(util::fs::Stat(source_path, &info));
+    struct timespec times[2] = {info.st_atim, info.st_mtim};
+    times[1].tv_sec += 10;
+    REQUIRE(utimensat(AT_FDCWD, source_path.c_str(), times,
+                      /* flags= */ 0) == 0);
+
+    std::string new_key;
+    REQUIRE(util::RasterCache::MakeKey(source_path, "16x16", &new_key));
+    REQUIRE(new_key != key);
+    REQUIRE_FALSE(cache.Load(new_key, &raster));
+  }
+
+  SECTION("unused entries are pruned") {
+    std::string other_key;
+    REQUIRE(util::RasterCache::MakeKey(source_path, "32x32", &other_key));
+    REQUIRE(cache.Store(other_key, 3, 2, pixels.data()));
+
+    // Make both entries look unused for two days.
+    std::vector<std::string> entries;
+    for (auto const& name : util::fs::DirectoryContents(temp_dir.path() /
+                                                        "cache")) {
+      if (name != "" && name != "." && name != "..") {
+        entries.push_back(temp_dir.path() / "cache" / name);
+      }
+    }
+    REQUIRE(entries.size() == 2);
+    struct timespec times[2] = {
+        absl::ToTimespec(absl::Now() - absl::Hours(48)),
+        absl::ToTimespec(absl::Now() - absl::Hours(48))};
+    for (auto const& entry : entries) {
+      REQUIRE(utimensat(AT_FDCWD, entry.c_str(), times, /* flags= */ 0) == 0);
+    }
+
+    // Loading an entry marks it as used again.
+    REQUIRE(cache.Load(key, &raster));
+    cache.Prune(absl::Hours(24));
+    REQUIRE(cache.Load(key, &raster));
+    REQUIRE_FALSE(cache.Load(other_key, &raster));
+
+    // Nothing happens without a cache directory.
+    util::RasterCache{temp_dir.path() / "missing"}.Prune(absl::Hours(24));
+  }
+
+  SECTION("concurrent stores of the same entry don't clash") {
+    std::vector<std::thread> threads;
+    std::vector<char> stored(8, false);
+    for (size_t i = 0; i < stored.size(); ++i) {
+      threads.emplace_back([&, i] {
+        for (int j = 0; j < 50; ++j) {
+          stored[i] = cache.Store(key, 3, 2, pixels.data());
+          if (!stored[i]) break;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(stored == std::vector<char>(stored.size(), true));
+    REQUIRE(cache.Load(key, &raster));
+    REQUIRE(std::vector<uint32_t>(raster.pixels(), raster.pixels() + 6) ==
+            pixels);
+  }
+
+  SECTION("corrupt entries are ignored") {
+    std::vector<std::string> entries;
+    for (auto const& name : util::fs::DirectoryContents(temp_dir.path() /
+                                                        "cache")) {
+      if (name != "" && name != "." && name != "..") {
+        entries.push_back(temp_dir.path() / "cache" / name);
+      }
+    }
+    REQUIRE(entries.size() == 1);
+
+    std::string contents;
+    {
+      util::fs::MappedFile file;
+      REQUIRE(file.Open(entries.front()));
+      contents.assign(file.contents().data(), file.contents().size());
+    }
+
+    for (auto const& corruption :
+         {std::string{}, contents.substr(0, contents.size() - 1),
+          contents + "x", std::string(contents.size(), '\0')}) {
+      REQUIRE(util::fs::WriteFile(entries.front(), corruption));
+      REQUIRE_FALSE(cache.Load(key, &raster));
+    }
+  }
+}
@@ -19,8 +19,6 @@
 #include <algorithm>
 #include <atomic>
 #include <iomanip>
-#include <list>
-#include <map>
 #include <utility>
 
 #include "absl/time/clock.h"
@@ -38,29 +36,34 @@ std::atomic<uint64_t> interval_id_counter;
 Interval::Interval() {}
 
 Interval::Interval(Interval::Id interval_id, absl::Time time_point,
-                   absl::Duration repeat_interval, Callback callback)
+                   absl::Duration repeat_interval, Callback callback,
+                   absl::Duration slack)
     : id_(interval_id),
       time_point_(time_point),
       repeat_interval_(repeat_interval),
-      callback_(callback) {}
+      callback_(callback),
+      slack_(slack) {}
 
 Interval::Interval(Interval const& other)
     : id_(other.id_),
       time_point_(other.time_point_),
       repeat_interval_(other.repeat_interval_),
-      callback_(other.callback_) {}
+      callback_(other.callback_),
+      slack_(other.slack_) {}
 
 Interval::Interval(Interval&& other)
     : id_(std::move(other.id_)),
       time_point_(std::move(other.time_point_)),
       repeat_interval_(std::move(other.repeat_interval_)),
-      callback_(std::move(other.callback_)) {}
+      callback_(std::move(other.callback_)),
+      slack_(std::move(other.slack_)) {}
 
 Interval& Interval::operator=(Interval other) {
   std::swap(id_, other.id_);
   std::swap(time_point_, other.time_point_);
   std::swap(repeat_interval_, other.repeat_interval_);
   std::swap(callback_, other.callback_);
+  std::swap(slack_, other.slack_);
   return *this;
 }
 
@@ -70,12 +73,17 @@ absl::Time Interval::GetTimePoint() const { return time_point_; }
 
 absl::Duration Interval::GetRepeatInterval() const { return repeat_interval_; }
 
+absl::Duration Interval::GetSlack() const { return slack_; }
+
 std::ostream& operator<<(std::ostream& os, Interval const& interval) {
   os << '[' << interval.GetTimePoint();
 
   auto ms = absl::ToInt64Milliseconds(interval.GetRepeatInterval());
   if (ms != 0) os << "; " << ms << " ms";
 
+  auto slack_ms = absl::ToInt64Milliseconds(interval.GetSlack());
+  if (slack_ms != 0) os << "; +" << slack_ms << " ms";
+
   os << ']';
   return os;
 }
@@ -106,34 +114,177 @@ bool CompareIntervals::operator()(Interval const& lhs,
   return CompareIds()(lhs.id_, rhs.id_);
 }
 
-Timer::Timer() : get_current_time_(absl::Now) {}
+bool IntervalQueue::empty() const { return heap_.empty(); }
+
+size_t IntervalQueue::size() const { return heap_.size(); }
+
+Interval& IntervalQueue::top() { return slots_[heap_.front()].interval; }
+
+Interval const& IntervalQueue::top() const {
+  return slots_[heap_.front()].interval;
+}
+
+void IntervalQueue::Insert(Interval interval) {
+  size_t slot_index;
+  if (free_slots_.empty()) {
+    slot_index = slots_.size();
+    slots_.push_back(Slot{Interval{}, 0});
+  } else {
+    slot_index = free_slots_.back();
+    free_slots_.pop_back();
+  }
+
+  Slot& slot = slots_[slot_index];
+  slot_by_id_[interval.id_.value()] = slot_index;
+  slot.interval = std::move(interval);
+  slot.heap_index = heap_.size();
+  heap_.push_back(slot_index);
+  SiftUp(slot.heap_index);
+}
+
+bool IntervalQueue::Erase(Interval::Id const& id) {
+  if (!id) {
+    return false;
+  }
+  auto it = slot_by_id_.find(id.value());
+  if (it == slot_by_id_.end()) {
+    return false;
+  }
+
+  size_t slot_index = it->second;
+  slot_by_id_.erase(it);
+
+  size_t heap_index = slots_[slot_index].heap_index;
+  size_t last = heap_.size() - 1;
+  if (heap_index != last) {
+    Swap(heap_index, last);
+  }
+  heap_.pop_back();
+  if (heap_index != last) {
+    // The last interval took its place, and may belong above or below it.
+    Slot const& moved = slots_[heap_[heap_index]];
+    SiftUp(moved.heap_index);
+    SiftDown(moved.heap_index);
+  }
+
+  // Releases whatever the callback holds on to.
+  slots_[slot_index].interval = Interval{};
+  free_slots_.push_back(slot_index);
+  return true;
+}
+
+bool IntervalQueue::Update(Interval::Id const& id) {
+  if (!id) {
+    return false;
+  }
+  auto it = slot_by_id_.find(id.value());
+  if (it == slot_by_id_.end()) {
+    return false;
+  }
+
+  Slot const& slot = slots_[it->second];
+  SiftUp(slot.heap_index);
+  SiftDown(slot.heap_index);
+  return true;
+}
+
+absl::Time IntervalQueue::EarliestDeadline() const {
+  absl::Time deadline = absl::InfiniteFuture();
+  FindEarliestDeadline(0, &deadline);
+  return deadline;
+}
+
+bool IntervalQueue::Before(size_t lhs_heap_index,
+                           size_t rhs_heap_index) const {
+  return CompareIntervals()(slots_[heap_[lhs_heap_index]].interval,
+                            slots_[heap_[rhs_heap_index]].interval);
+}
+
+void IntervalQueue::Swap(size_t lhs_heap_index, size_t rhs_heap_index) {
+  std::swap(heap_[lhs_heap_index], heap_[rhs_heap_index]);
+  slots_[heap_[lhs_heap_index]].heap_index = lhs_heap_index;
+  slots_[heap_[rhs_heap_index]].heap_index = rhs_heap_index;
+}
+
+void IntervalQueue::SiftUp(size_t heap_index) {
+  while (heap_index > 0) {
+    size_t parent = (heap_index - 1) / 2;
+    if (!Before(heap_index, parent)) {
+      break;
+    }
+    Swap(heap_index, parent);
+    heap_index = parent;
+  }
+}
+
+void IntervalQueue::SiftDown(size_t heap_index) {
+  while (true) {
+    size_t first = heap_index;
+    size_t left = 2 * heap_index + 1;
+    size_t right = left + 1;
+    if (left < heap_.size() && Before(left, first)) {
+      first = left;
+    }
+    if (right < heap_.size() && Before(right, first)) {
+      first = right;
+    }
+    if (first == heap_index) {
+      break;
+    }
+    Swap(heap_index, first);
+    heap_index = first;
+  }
+}
+
+void IntervalQueue::FindEarliestDeadline(size_t heap_index,
+                                         absl::Time* deadline) const {
+  if (heap_index >= heap_.size()) {
+    return;
+  }
+  // Intervals below this one expire no earlier, so can't have an earlier
+  // deadline than one already found before it expires.
+  Interval const& interval = slots_[heap_[heap_index]].interval;
+  if (interval.time_point_ >= *deadline) {
+    return;
+  }
+  *deadline = std::min(*deadline, interval.time_point_ + interval.slack_);
+  FindEarliestDeadline(2 * heap_index + 1, deadline);
+  FindEarliestDeadline(2 * heap_index + 2, deadline);
+}
+
+Timer::Timer() : Timer(absl::Now) {}
 
 Timer::Timer(TimerCallback get_current_time_callback)
-    : get_current_time_(get_current_time_callback) {}
+    : get_current_time_(get_current_time_callback),
+      created_(get_current_time_()),
+      wakeups_(0) {}
 
 absl::Time Timer::Now() const { return get_current_time_(); }
 
 Interval::Id Timer::SetTimeout(absl::Duration timeout_interval,
-                               Interval::Callback callback) {
+                               Interval::Callback callback,
+                               absl::Duration slack) {
   Interval::Id id{++interval_id_counter};
-  timeouts_.insert(id, Interval{id, Now() + timeout_interval,
-                                absl::Milliseconds(0), std::move(callback)});
+  timeouts_.Insert(Interval{id, Now() + timeout_interval,
+                            absl::Milliseconds(0), std::move(callback),
+                            slack});
   return id;
 }
 
 Interval::Id Timer::SetInterval(absl::Duration repeat_interval,
-                                Interval::Callback callback) {
+                                Interval::Callback callback,
+                                absl::Duration slack) {
   Interval::Id id{++interval_id_counter};
-  intervals_.insert(id, Interval{id, Now() + repeat_interval, repeat_interval,
-                                 std::move(callback)});
+  intervals_.Insert(Interval{id, Now() + repeat_interval, repeat_interval,
+                             std::move(callback), slack});
   return id;
 }
 
 bool Timer::ClearInterval(Interval::Id interval_id) {
-  if (timeouts_.left.erase(interval_id)) {
+  if (timeouts_.Erase(interval_id)) {
     return true;
   }
-  if (intervals_.left.erase(interval_id)) {
+  if (intervals_.Erase(interval_id)) {
     return true;
   }
   return false;
@@ -141,39 +292,35 @@ bool Timer::ClearInterval(Interval::Id interval_id) {
 
 void Timer::ProcessExpiredIntervals() {
   absl::Time now = get_current_time_();
-
-  while (true) {
-    auto it = timeouts_.right.begin();
-    if (it == timeouts_.right.end()) {
-      break;
-    }
-
-    Interval const& interval = it->first;
-    if (interval.time_point_ > now) {
-      break;
-    }
+  bool invoked = false;
+
+  // Intervals stay where they are while their callbacks run, even if those
+  // register new intervals, so they are invoked in place and looked up by id
+  // afterwards.
+  while (!timeouts_.empty() && timeouts_.top().time_point_ <= now) {
+    Interval& interval = timeouts_.top();
+    Interval::Id id = interval.id_;
     interval.InvokeCallback();
-    timeouts_.right.erase(interval);
+    timeouts_.Erase(id);
+    invoked = true;
   }
 
-  while (true) {
-    auto it = intervals_.right.begin();
-    if (it == intervals_.right.end()) {
-      break;
+  while (!intervals_.empty() && intervals_.top().time_point_ <= now) {
+    Interval& interval = intervals_.top();
+    Interval::Id id = interval.id_;
+    invoked = true;
+    if (!interval.callback_()) {
+      intervals_.Erase(id);
+      continue;
     }
+    do {
+      interval.time_point_ += interval.repeat_interval_;
+    } while (interval.time_point_ < now);
+    intervals_.Update(id);
+  }
 
-    Interval interval{it->first};
-    if (interval.time_point_ > now) {
-      break;
-    }
-    bool should_keep = interval.callback_();
-    intervals_.right.erase(interval);
-    if (should_keep) {
-      do {
-        interval.time_point_ += interval.repeat_interval_;
-      } while (interval.time_point_ < now);
-      intervals_.insert(interval.id_, interval);
-    }
+  if (invoked) {
+    ++wakeups_;
   }
 }
 
@@ -182,11 +329,34 @@ absl::optional<Interval> Timer::GetNextInterval() const {
     return {};
   }
   if (intervals_.empty()) {
-    return timeouts_.right.begin()->first;
+    return timeouts_.top();
   }
   if (timeouts_.empty()) {
-    return intervals_.right.begin()->first;
+    return intervals_.top();
+  }
+  return std::min(timeouts_.top(), intervals_.top());
+}
+
+absl::optional<absl::Time> Timer::GetNextWakeup() const {
+  if (timeouts_.empty() && intervals_.empty()) {
+    return {};
+  }
+  if (intervals_.empty()) {
+    return timeouts_.EarliestDeadline();
+  }
+  if (timeouts_.empty()) {
+    return intervals_.EarliestDeadline();
+  }
+  return std::min(timeouts_.EarliestDeadline(),
+                  intervals_.EarliestDeadline());
+}
+
+uint64_t Timer::wakeups() const { return wakeups_; }
+
+double Timer::WakeupsPerSecond() const {
+  double elapsed = absl::ToDoubleSeconds(Now() - created_);
+  if (elapsed <= 0.0) {
+    return 0.0;
   }
-  return std::min(timeouts_.right.begin()->first,
-                  intervals_.right.begin()->first);
+  return wakeups_ / elapsed;
 }
@@ -4,21 +4,26 @@
 #include <sys/select.h>
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <ostream>
+#include <unordered_map>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
-#include "util/bimap.hh"
 
 class Timer;
 class CompareIntervals;
+class IntervalQueue;
 class Interval {
  public:
   friend class Timer;
   friend class CompareIntervals;
+  friend class IntervalQueue;
   friend bool operator<(Interval const& lhs, Interval const& rhs);
 
   using Id = absl::optional<uint64_t>;
@@ -26,7 +31,8 @@ class Interval {
 
   Interval();
   Interval(Interval::Id interval_id, absl::Time time_point,
-           absl::Duration repeat_interval, Callback callback);
+           absl::Duration repeat_interval, Callback callback,
+           absl::Duration slack = absl::ZeroDuration());
   Interval(Interval const& other);
   Interval(Interval&& other);
 
@@ -35,12 +41,16 @@ class Interval {
   void InvokeCallback() const;
   absl::Time GetTimePoint() const;
   absl::Duration GetRepeatInterval() const;
+  absl::Duration GetSlack() const;
 
  private:
   Id id_;
   absl::Time time_point_;
   absl::Duration repeat_interval_;
   Callback callback_;
+  // How late past time_point_ the callback may be invoked (see
+  // Timer::SetTimeout()).
+  absl::Duration slack_;
 };
 
 bool operator<(Interval const& lhs, Interval const& rhs);
@@ -56,8 +66,48 @@ class CompareIntervals {
   bool operator()(Interval const& lhs, Interval const& rhs) const;
 };
 
-using IntervalSet =
-    util::bimap<Interval::Id, Interval, CompareIds, CompareIntervals>;
+// Intervals ordered by expiration time, in an indexed binary min-heap.
+//
+// Intervals live in slots that never move, so references to them stay valid
+// while callbacks register new intervals, and the heap only shuffles slot
+// indices around. Each slot knows its position in the heap: updating or
+// erasing an interval is O(log n), and rescheduling one in place doesn't
+// allocate.
+class IntervalQueue {
+ public:
+  bool empty() const;
+  size_t size() const;
+
+  // The interval expiring first. The queue must not be empty.
+  Interval& top();
+  Interval const& top() const;
+
+  void Insert(Interval interval);
+  bool Erase(Interval::Id const& id);
+  // Restores the ordering after the given interval's time point changed.
+  bool Update(Interval::Id const& id);
+
+  // The earliest time point by which some interval must be invoked, given its
+  // slack. The queue must not be empty.
+  absl::Time EarliestDeadline() const;
+
+ private:
+  struct Slot {
+    Interval interval;
+    size_t heap_index;
+  };
+
+  std::deque<Slot> slots_;
+  std::vector<size_t> free_slots_;
+  std::vector<size_t> heap_;
+  std::unordered_map<uint64_t, size_t> slot_by_id_;
+
+  bool Before(size_t lhs_heap_index, size_t rhs_heap_index) const;
+  void Swap(size_t lhs_heap_index, size_t rhs_heap_index);
+  void SiftUp(size_t heap_index);
+  void SiftDown(size_t heap_index);
+  void FindEarliestDeadline(size_t heap_index, absl::Time* deadline) const;
+};
 
 class ChronoTimerTestUtils;
 class Timer {
@@ -74,21 +124,32 @@ class Timer {
   // Registers a new single-shot callback.
   // Will be called at (or after) now + timeout_interval.
   //
+  // Slack is how late past that the callback may be called. The event loop
+  // only wakes up at the earliest deadline (time point plus slack) of all the
+  // callbacks, and then calls every one that has expired. So callbacks whose
+  // windows overlap share one wakeup instead of needing one each.
+  // Timers that may run a little late unnoticed should have some, to save
+  // wakeups (and power).
+  //
   // DO NOT call ClearInterval() from inside the registered callback function,
   // as this kind of timeout is removed automatically after having been
   // processed. The return value of the callback function is ignored.
   Interval::Id SetTimeout(absl::Duration timeout_interval,
-                          Interval::Callback callback);
+                          Interval::Callback callback,
+                          absl::Duration slack = absl::ZeroDuration());
 
   // Registers a new periodic callback.
   // Will be called at (or after) now + repeat_interval, and the next callback
   // time point will be adjusted accordingly for the next invocation.
+  // Slack delays invocations as for SetTimeout(), without shifting the
+  // following ones.
   //
   // DO NOT call ClearInterval() from inside the registered callback function;
   // instead, have the callback function return a boolean indicating whether
   // the interval should be kept (true) or deleted (false);
   Interval::Id SetInterval(absl::Duration repeat_interval,
-                           Interval::Callback callback);
+                           Interval::Callback callback,
+                           absl::Duration slack = absl::ZeroDuration());
 
   // Unregister the given interval from the timeout/repeat queues.
   //
@@ -104,11 +165,24 @@ class Timer {
   // Returns the next registered interval, if any, or a nulled-out object.
   absl::optional<Interval> GetNextInterval() const;
 
+  // Returns when ProcessExpiredIntervals() should be called next, if there are
+  // any registered intervals: the latest time point at which no interval is
+  // invoked later than its slack allows. Intervals expired by then are all
+  // invoked together.
+  absl::optional<absl::Time> GetNextWakeup() const;
+
+  // How many times ProcessExpiredIntervals() invoked callbacks, overall and
+  // on average per second since the timer was created.
+  uint64_t wakeups() const;
+  double WakeupsPerSecond() const;
+
  private:
   TimerCallback get_current_time_;
+  absl::Time created_;
+  uint64_t wakeups_;
 
-  IntervalSet timeouts_;
-  IntervalSet intervals_;
+  IntervalQueue timeouts_;
+  IntervalQueue intervals_;
 };
 
 #endif  // TINT3_UTIL_TIMER_HH
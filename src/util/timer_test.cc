@@ -1,7 +1,10 @@
 #include "catch.hpp"
 
+#include <chrono>
 #include <functional>
+#include <iostream>
 #include <limits>
+#include <vector>
 
 #include "util/timer.hh"
 #include "util/timer_test_utils.hh"
@@ -72,11 +75,11 @@ class ChronoTimerTestUtils {
  public:
   virtual ~ChronoTimerTestUtils() = 0;
 
-  static IntervalSet const& GetTimeouts(Timer& timer) {
+  static IntervalQueue const& GetTimeouts(Timer& timer) {
     return timer.timeouts_;
   }
 
-  static IntervalSet const& GetIntervals(Timer& timer) {
+  static IntervalQueue const& GetIntervals(Timer& timer) {
     return timer.intervals_;
   }
 };
@@ -187,5 +190,166 @@ TEST_CASE("Timer", "Test the Timer class") {
     auto next_interval = timer.GetNextInterval();
     REQUIRE(next_interval.has_value());
     REQUIRE(next_interval->GetRepeatInterval() == absl::Milliseconds(100));
+    REQUIRE(timer.GetNextWakeup() ==
+            absl::FromUnixSeconds(0) + absl::Milliseconds(100));
   }
+
+  SECTION("invokes callbacks in expiration order") {
+    std::vector<int> invocations;
+    std::vector<Interval::Id> ids;
+    for (int i : {7, 3, 9, 1, 5, 8, 2, 6, 4, 10}) {
+      ids.push_back(timer.SetTimeout(absl::Milliseconds(10 * i),
+                                     [&invocations, i]() -> bool {
+                                       invocations.push_back(i);
+                                       return true;
+                                     }));
+    }
+    // Erasing from the middle of the queue keeps it ordered.
+    REQUIRE(timer.ClearInterval(ids[0]));
+    REQUIRE(timer.ClearInterval(ids[4]));
+    REQUIRE_FALSE(timer.ClearInterval(ids[4]));
+
+    fake_clock.AdvanceBy(absl::Seconds(1));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(invocations == (std::vector<int>{1, 2, 3, 4, 6, 8, 9, 10}));
+    REQUIRE(ChronoTimerTestUtils::GetTimeouts(timer).empty());
+  }
+
+  SECTION("callbacks may register new intervals") {
+    unsigned int invocations_count = 0;
+    std::function<bool()> callback = [&]() -> bool {
+      // Expiring right away, within the same call.
+      if (++invocations_count < 100) {
+        timer.SetTimeout(absl::ZeroDuration(), callback);
+      }
+      return true;
+    };
+    timer.SetTimeout(absl::Milliseconds(0), callback);
+
+    fake_clock.AdvanceBy(absl::Seconds(10));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(invocations_count == 100);
+    REQUIRE(ChronoTimerTestUtils::GetTimeouts(timer).empty());
+  }
+
+  SECTION("repeating intervals are rescheduled independently") {
+    std::vector<int> invocations;
+    auto const& intervals = ChronoTimerTestUtils::GetIntervals(timer);
+    timer.SetInterval(absl::Milliseconds(300), [&invocations]() -> bool {
+      invocations.push_back(300);
+      return true;
+    });
+    unsigned int short_invocations_count = 0;
+    timer.SetInterval(absl::Milliseconds(200), [&]() -> bool {
+      invocations.push_back(200);
+      // Deleted after its second invocation.
+      return ++short_invocations_count < 2;
+    });
+
+    for (int i = 0; i < 6; ++i) {
+      fake_clock.AdvanceBy(absl::Milliseconds(100));
+      timer.ProcessExpiredIntervals();
+    }
+    REQUIRE(invocations == (std::vector<int>{200, 300, 200, 300}));
+    REQUIRE(intervals.size() == 1);
+    REQUIRE(timer.GetNextWakeup() ==
+            absl::FromUnixSeconds(0) + absl::Milliseconds(900));
+  }
+}
+
+TEST_CASE("Timer slack", "Test coalescing intervals with some slack") {
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  std::vector<int> invocations;
+  auto callback = [&invocations](int i) {
+    return [&invocations, i]() -> bool {
+      invocations.push_back(i);
+      return true;
+    };
+  };
+  absl::Time epoch = absl::FromUnixSeconds(0);
+
+  SECTION("overlapping windows share a wakeup") {
+    // [100, 200], [150, 150] and [180, 230] overlap at 150 ms...
+    timer.SetTimeout(absl::Milliseconds(100), callback(1),
+                     absl::Milliseconds(100));
+    timer.SetTimeout(absl::Milliseconds(150), callback(2));
+    timer.SetTimeout(absl::Milliseconds(180), callback(3),
+                     absl::Milliseconds(50));
+    // ...but [400, 500] doesn't.
+    timer.SetTimeout(absl::Milliseconds(400), callback(4),
+                     absl::Milliseconds(100));
+    REQUIRE(timer.GetNextWakeup() == epoch + absl::Milliseconds(150));
+
+    fake_clock.AdvanceBy(absl::Milliseconds(150));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(invocations == (std::vector<int>{1, 2}));
+    // [180, 230] doesn't overlap [400, 500], so the third one gets its own
+    // wakeup at its 230 ms deadline.
+    REQUIRE(timer.GetNextWakeup() == epoch + absl::Milliseconds(230));
+    fake_clock.AdvanceBy(absl::Milliseconds(80));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(invocations == (std::vector<int>{1, 2, 3}));
+    REQUIRE(timer.GetNextWakeup() == epoch + absl::Milliseconds(500));
+    REQUIRE(timer.wakeups() == 2);
+  }
+
+  SECTION("repeating intervals keep their period") {
+    timer.SetInterval(absl::Seconds(1), callback(1));
+    fake_clock.AdvanceBy(absl::Milliseconds(300));
+    timer.SetInterval(absl::Seconds(1), callback(2), absl::Milliseconds(800));
+
+    // The second interval waits for the first one every time, without
+    // drifting away from it.
+    for (int i = 1; i <= 10; ++i) {
+      REQUIRE(timer.GetNextWakeup() == epoch + absl::Seconds(i));
+      fake_clock.AdvanceBy(epoch + absl::Seconds(i) - fake_clock.Now());
+      timer.ProcessExpiredIntervals();
+    }
+    REQUIRE(invocations.size() == 19);
+    REQUIRE(timer.wakeups() == 10);
+    REQUIRE(timer.WakeupsPerSecond() == Approx(1.0));
+  }
+
+  SECTION("expired intervals are processed on unrelated wakeups") {
+    timer.SetTimeout(absl::Milliseconds(100), callback(1),
+                     absl::Seconds(1));
+    REQUIRE(timer.GetNextWakeup() == epoch + absl::Milliseconds(1100));
+
+    // e.g. the event loop waking up for X events.
+    fake_clock.AdvanceBy(absl::Milliseconds(500));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(invocations == (std::vector<int>{1}));
+    REQUIRE_FALSE(timer.GetNextWakeup().has_value());
+  }
+}
+
+TEST_CASE("TimerBenchmark", "[.][benchmark]") {
+  static constexpr int kIntervals = 1000;
+  static constexpr int kRounds = 1000;
+
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  unsigned int invocations_count = 0;
+  for (int i = 0; i < kIntervals; ++i) {
+    timer.SetInterval(absl::Milliseconds(1 + i % 100),
+                      [&invocations_count]() -> bool {
+                        ++invocations_count;
+                        return true;
+                      });
+  }
+
+  // Every round expires (and re-arms) some of the intervals.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRounds; ++i) {
+    fake_clock.AdvanceBy(absl::Milliseconds(1));
+    timer.ProcessExpiredIntervals();
+  }
+  auto elapsed = (std::chrono::steady_clock::now() - start);
+
+  std::cout << "ProcessExpiredIntervals: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                       .count() /
+                   static_cast<double>(invocations_count)
+            << " ns/invocation\n";
 }
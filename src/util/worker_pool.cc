@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <utility>
+
+#include "util/worker_pool.hh"
+
+namespace util {
+
+WorkerPool::WorkerPool(unsigned int thread_count) : stopping_(false) {
+  for (unsigned int i = 0; i < std::max(thread_count, 1U); ++i) {
+    threads_.emplace_back(&WorkerPool::Work, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Submit(void const* owner, Job job) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    queue_.push_back(Task{owner, std::move(job)});
+  }
+  work_available_.notify_one();
+}
+
+void WorkerPool::Cancel(void const* owner) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto owned_by = [owner](void const* other) { return other == owner; };
+
+  queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+                              [&](Task const& task) {
+                                return owned_by(task.owner);
+                              }),
+               queue_.end());
+  work_done_.wait(lock, [&] {
+    return std::none_of(running_.begin(), running_.end(), owned_by);
+  });
+  completions_.erase(std::remove_if(completions_.begin(), completions_.end(),
+                                    [&](Result const& result) {
+                                      return owned_by(result.owner);
+                                    }),
+                     completions_.end());
+}
+
+int WorkerPool::completion_fd() const { return completion_pipe_.ReadEnd(); }
+
+void WorkerPool::RunCompletions() {
+  completion_pipe_.ReadPendingBytes();
+
+  // Completions are taken one at a time, as any of them may cancel the ones
+  // queued after it.
+  while (true) {
+    Completion completion;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (completions_.empty()) {
+        break;
+      }
+      completion = std::move(completions_.front().completion);
+      completions_.pop_front();
+    }
+    completion();
+  }
+}
+
+void WorkerPool::Drain() {
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    work_done_.wait(lock, [&] { return queue_.empty() && running_.empty(); });
+  }
+  RunCompletions();
+}
+
+void WorkerPool::Work() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    work_available_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      return;
+    }
+
+    Task task{std::move(queue_.front())};
+    queue_.pop_front();
+    running_.push_back(task.owner);
+
+    lock.unlock();
+    Completion completion{task.job()};
+    lock.lock();
+
+    running_.erase(std::find(running_.begin(), running_.end(), task.owner));
+    if (completion) {
+      completions_.push_back(Result{task.owner, std::move(completion)});
+      completion_pipe_.WriteOneByte();
+    }
+    work_done_.notify_all();
+  }
+}
+
+}  // namespace util
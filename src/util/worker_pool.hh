@@ -0,0 +1,77 @@
+#ifndef TINT3_UTIL_WORKER_POOL_HH
+#define TINT3_UTIL_WORKER_POOL_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util/pipe.hh"
+
+namespace util {
+
+// Runs jobs on a fixed set of background threads, and hands their results
+// back to the thread owning the pool (typically the one running the event
+// loop, which watches completion_fd()).
+//
+// Jobs must not touch any X11, Imlib2 or other non thread-safe state: whatever
+// needs it goes in the completion they return instead.
+class WorkerPool {
+ public:
+  // Runs on the owning thread, once the job that returned it is done.
+  using Completion = std::function<void()>;
+  // Runs on a worker thread. May return an empty completion.
+  using Job = std::function<Completion()>;
+
+  explicit WorkerPool(unsigned int thread_count);
+  ~WorkerPool();
+
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+
+  // Queues a job on behalf of owner, which only matters to Cancel().
+  void Submit(void const* owner, Job job);
+
+  // Forgets about the queued jobs and pending completions of the given owner,
+  // after waiting for its currently running jobs (if any). Must be called
+  // before an owner referenced by its completions goes away.
+  void Cancel(void const* owner);
+
+  // Becomes readable whenever completions are pending.
+  int completion_fd() const;
+
+  // Runs the pending completions.
+  void RunCompletions();
+
+  // Waits for all the submitted jobs to finish, then runs their completions.
+  void Drain();
+
+ private:
+  struct Task {
+    void const* owner;
+    Job job;
+  };
+
+  struct Result {
+    void const* owner;
+    Completion completion;
+  };
+
+  void Work();
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  std::deque<Task> queue_;
+  std::vector<void const*> running_;
+  std::deque<Result> completions_;
+  bool stopping_;
+  util::SelfPipe completion_pipe_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_WORKER_POOL_HH
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <poll.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "util/worker_pool.hh"
+
+namespace {
+
+bool IsReadable(int fd, int timeout_ms) {
+  struct pollfd poll_fd = {fd, POLLIN, 0};
+  return poll(&poll_fd, 1, timeout_ms) == 1;
+}
+
+}  // namespace
+
+TEST_CASE("WorkerPool") {
+  util::WorkerPool pool{4};
+  int owner;
+
+  SECTION("completions run on the owning thread") {
+    std::vector<int> results;
+    std::atomic<int> job_count{0};
+    auto owning_thread = std::this_thread::get_id();
+
+    for (int i = 0; i < 32; ++i) {
+      pool.Submit(&owner, [&, i] {
+        ++job_count;
+        int result = i * i;
+        return [&, result] {
+          REQUIRE(std::this_thread::get_id() == owning_thread);
+          results.push_back(result);
+        };
+      });
+    }
+    pool.Drain();
+
+    REQUIRE(job_count == 32);
+    REQUIRE(results.size() == 32);
+    REQUIRE_FALSE(IsReadable(pool.completion_fd(), 0));
+  }
+
+  SECTION("the completion file descriptor becomes readable") {
+    bool completed = false;
+    pool.Submit(&owner, [&] { return [&] { completed = true; }; });
+
+    REQUIRE(IsReadable(pool.completion_fd(), 5000));
+    REQUIRE_FALSE(completed);
+    pool.RunCompletions();
+    REQUIRE(completed);
+  }
+
+  SECTION("empty completions are skipped") {
+    std::atomic<bool> ran{false};
+    pool.Submit(&owner, [&] {
+      ran = true;
+      return util::WorkerPool::Completion{};
+    });
+    pool.Drain();
+    REQUIRE(ran);
+  }
+
+  SECTION("cancellation") {
+    int other_owner;
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::promise<void> started;
+
+    // Keep one job running until told otherwise...
+    pool.Submit(&owner, [&] {
+      started.set_value();
+      released.wait();
+      return [] { FAIL("completion of a cancelled job"); };
+    });
+    started.get_future().wait();
+
+    // ...queue more, both from the same owner and another one...
+    bool other_completed = false;
+    pool.Submit(&other_owner,
+                [&] { return [&] { other_completed = true; }; });
+    for (int i = 0; i < 8; ++i) {
+      pool.Submit(&owner, [] { return [] { FAIL("cancelled job ran"); }; });
+    }
+
+    // ...then cancel while the first one is still running.
+    std::thread releaser{[&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      release.set_value();
+    }};
+    pool.Cancel(&owner);
+    releaser.join();
+
+    pool.Drain();
+    REQUIRE(other_completed);
+  }
+}
@@ -8,6 +8,7 @@
 
 #include <cstring>
 #include <utility>
+#include <vector>
 
 // For waitpid
 #include <sys/types.h>
@@ -136,22 +137,39 @@ bool EventLoop::RunLoop() {
     FD_SET(self_pipe_.ReadEnd(), &fdset);
 
     int max_fd_ = std::max(x11_file_descriptor_, self_pipe_.ReadEnd());
+    for (auto const& entry : fd_handler_map_) {
+      FD_SET(entry.first, &fdset);
+      max_fd_ = std::max(max_fd_, entry.first);
+    }
 
-    auto next_interval = timer_.GetNextInterval();
+    auto next_wakeup = timer_.GetNextWakeup();
     struct timeval tv;
     struct timeval* next_timeval = nullptr;
 
-    if (next_interval) {
+    if (next_wakeup) {
       auto now = timer_.Now();
-      auto until = next_interval->GetTimePoint();
+      auto until = next_wakeup.value();
 
       absl::Duration duration{until - now};
       tv = absl::ToTimeval(duration);
       next_timeval = &tv;
     }
 
-    if (XPending(server_->dsp) ||
-        select(max_fd_ + 1, &fdset, 0, 0, next_timeval) > 0) {
+    bool events_pending = XPending(server_->dsp);
+    if (events_pending) {
+      // Don't wait, but still poll the other file descriptors, or steady X
+      // traffic would starve them.
+      tv = timeval{0, 0};
+      next_timeval = &tv;
+    }
+
+    int ready = select(max_fd_ + 1, &fdset, 0, 0, next_timeval);
+    if (ready < 0) {
+      // fdset is left undefined on errors (e.g. EINTR).
+      FD_ZERO(&fdset);
+    }
+
+    if (events_pending || ready > 0) {
       // Remove bytes written by WakeUp()
       if (FD_ISSET(self_pipe_.ReadEnd(), &fdset)) {
         self_pipe_.ReadPendingBytes();
@@ -161,6 +179,22 @@ bool EventLoop::RunLoop() {
         ReapChildPIDs();
       }
 
+      // Handlers may unregister file descriptors, so don't iterate over the
+      // map while calling them.
+      std::vector<int> ready_fds;
+      for (auto const& entry : fd_handler_map_) {
+        if (FD_ISSET(entry.first, &fdset)) {
+          ready_fds.push_back(entry.first);
+        }
+      }
+      for (int fd : ready_fds) {
+        auto it = fd_handler_map_.find(fd);
+        if (it != fd_handler_map_.end()) {
+          FileDescriptorHandler handler{it->second};
+          handler();
+        }
+      }
+
       while (XPending(server_->dsp)) {
         XEvent e;
         XNextEvent(server_->dsp, &e);
@@ -224,6 +258,8 @@ bool EventLoop::RunLoop() {
       //  * anything else results in an unsuccessful process termination.
 
       FD_ZERO(&fdset);
+      util::log::Debug() << "Timer wakeups: " << timer_.wakeups() << " ("
+                         << timer_.WakeupsPerSecond() << " wakeups/sec)\n";
       return (signal_pending == SIGUSR1 || signal_pending == SIGUSR2);
     }
   }
@@ -248,6 +284,14 @@ EventLoop& EventLoop::RegisterHandler(std::initializer_list<int> event_list,
   return (*this);
 }
 
+EventLoop& EventLoop::RegisterFileDescriptor(
+    int fd, EventLoop::FileDescriptorHandler handler) {
+  fd_handler_map_[fd] = std::move(handler);
+  return (*this);
+}
+
+void EventLoop::UnregisterFileDescriptor(int fd) { fd_handler_map_.erase(fd); }
+
 void EventLoop::ReapChildPIDs() const {
   pid_t pid;
   while ((pid = waitpid(-1, nullptr, WNOHANG)) > 0) {
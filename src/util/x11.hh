@@ -84,6 +84,7 @@ class Pixmap {
 class EventLoop {
  public:
   using EventHandler = std::function<void(XEvent&)>;
+  using FileDescriptorHandler = std::function<void()>;
 
   EventLoop(Server const* const server, Timer& timer);
 
@@ -93,6 +94,9 @@ class EventLoop {
   EventLoop& RegisterHandler(int event, EventHandler handler);
   EventLoop& RegisterHandler(std::initializer_list<int> event_list,
                              EventHandler handler);
+  // Calls handler whenever the file descriptor becomes readable.
+  EventLoop& RegisterFileDescriptor(int fd, FileDescriptorHandler handler);
+  void UnregisterFileDescriptor(int fd);
 
  private:
   bool alive_;
@@ -101,6 +105,7 @@ class EventLoop {
   util::SelfPipe self_pipe_;
   Timer& timer_;
   std::unordered_map<int, EventHandler> handler_map_;
+  std::unordered_map<int, FileDescriptorHandler> fd_handler_map_;
 
   void ReapChildPIDs() const;
 };
@@ -10,6 +10,7 @@ namespace util {
 namespace xdg {
 namespace basedir {
 
+util::fs::Path CacheHome();
 util::fs::Path ConfigHome();
 util::fs::Path DataHome();
 std::vector<std::string> ConfigDirs();